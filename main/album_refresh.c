@@ -0,0 +1,111 @@
+#include "album_refresh.h"
+#include "wifi_scanner.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/stats.h"
+#include <string.h>
+
+static const char *TAG = "album_refresh";
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static album_refresh_stats_t stats = { .next_channel = 1 };
+
+#ifdef CONFIG_WIFI_MGR_ALBUM_REFRESH
+
+#define REFRESH_BACKOFF_MAX 4   // Con tráfico sostenido el intervalo crece hasta x16
+
+static int64_t next_slice_us = 0;
+static uint8_t backoff = 0;
+static uint32_t prev_packets = 0;
+static int64_t prev_sample_us = 0;
+
+// Paquetes/s desde la llamada anterior (mismos contadores lwIP que la política de ahorro)
+static uint32_t traffic_pps(int64_t now) {
+#if LWIP_STATS && LINK_STATS
+    uint32_t packets = (uint32_t)lwip_stats.link.recv + (uint32_t)lwip_stats.link.xmit;
+    uint32_t elapsed_ms = (uint32_t)((now - prev_sample_us) / 1000);
+    uint32_t pps = (prev_sample_us != 0 && elapsed_ms > 0) ? (packets - prev_packets) * 1000 / elapsed_ms : 0;
+    prev_packets = packets;
+    prev_sample_us = now;
+    return pps;
+#else
+    (void)now;
+    return 0;
+#endif
+}
+
+// Un canal por slice: la vuelta completa (los canales que recorre el refresco) se reparte en el período
+static int64_t slice_us(uint8_t n_channels) {
+    return (int64_t)CONFIG_WIFI_MGR_ALBUM_REFRESH_PERIOD_S * 1000000 / (n_channels ? n_channels : 1);
+}
+
+#endif // CONFIG_WIFI_MGR_ALBUM_REFRESH
+
+void album_refresh_reset(void) {
+#ifdef CONFIG_WIFI_MGR_ALBUM_REFRESH
+    uint8_t channels[WIFI_SCANNER_REFRESH_MAX_CHANNELS];
+    next_slice_us = esp_timer_get_time() + slice_us(wifi_scanner_get_refresh_channels(channels));
+    backoff = 0;
+    prev_sample_us = 0;
+#endif
+}
+
+bool album_refresh_tick(void) {
+#ifdef CONFIG_WIFI_MGR_ALBUM_REFRESH
+    int64_t now = esp_timer_get_time();
+    uint32_t pps = traffic_pps(now); // Se muestrea en cada vuelta para que la tasa sea la reciente
+    uint8_t channels[WIFI_SCANNER_REFRESH_MAX_CHANNELS];
+    uint8_t n = wifi_scanner_get_refresh_channels(channels);
+    if (n == 0) return false;
+    int64_t slice = slice_us(n);
+    if (next_slice_us == 0) next_slice_us = now + slice;
+    if (now < next_slice_us) return false;
+
+    if (pps > CONFIG_WIFI_MGR_ALBUM_REFRESH_BUSY_PPS) {
+        // Hay tráfico: el slice espera, cada vez un poco más
+        if (backoff < REFRESH_BACKOFF_MAX) backoff++;
+        next_slice_us = now + (slice << backoff);
+        taskENTER_CRITICAL(&stats_lock);
+        stats.deferred++;
+        taskEXIT_CRITICAL(&stats_lock);
+        ESP_LOGD(TAG, "Slice pospuesto (%lu paq/s, backoff x%d)", (unsigned long)pps, 1 << backoff);
+        return false;
+    }
+    backoff = 0;
+    next_slice_us = now + slice;
+
+    // Posición en la vuelta; si el canal ya no está en la lista (cambió el país) se empieza de nuevo
+    uint8_t pos = 0;
+    while (pos < n && channels[pos] != stats.next_channel) pos++;
+    if (pos == n) pos = 0;
+    uint8_t channel = channels[pos];
+    int found = wifi_scanner_refresh_channel(channel, CONFIG_WIFI_MGR_ALBUM_REFRESH_DWELL_MS);
+    uint32_t absence_ms = (uint32_t)((esp_timer_get_time() - now) / 1000);
+
+    // Se avanza aunque el driver rechace el canal: si no, la vuelta quedaría trabada en él
+    taskENTER_CRITICAL(&stats_lock);
+    if (found < 0) {
+        stats.failed++;
+    } else {
+        stats.slices++;
+        stats.absence_ms_last = absence_ms;
+        if (absence_ms > stats.absence_ms_max) stats.absence_ms_max = absence_ms;
+    }
+    stats.next_channel = channels[(pos + 1) % n];
+    if (pos + 1 == n) stats.rotations++;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (found >= 0) ESP_LOGD(TAG, "Canal %d: %d APs en %lu ms", channel, found, (unsigned long)absence_ms);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void album_refresh_get_stats(album_refresh_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,39 @@
+#ifndef ALBUM_REFRESH_H
+#define ALBUM_REFRESH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t slices;            /**< Canales refrescados */
+    uint32_t rotations;         /**< Vueltas completas (wifi_scanner_get_refresh_channels) */
+    uint32_t deferred;          /**< Slices pospuestos por tráfico */
+    uint32_t failed;            /**< Escaneos rechazados por el driver */
+    uint32_t absence_ms_last;   /**< Duración del último slice (fuera del canal propio) */
+    uint32_t absence_ms_max;
+    uint8_t  next_channel;
+} album_refresh_stats_t;
+
+/**
+ * @brief Reinicia la planificación (nueva asociación: el primer slice espera un intervalo completo).
+ */
+void album_refresh_reset(void);
+
+/**
+ * @brief Paso del planificador. Lo llama la tarea de estados en CONNECTED (la misma que hace los
+ * demás escaneos, así nunca se pisan). Como mucho refresca un canal por llamada.
+ * @return true si se escaneó un canal en esta llamada.
+ */
+bool album_refresh_tick(void);
+
+void album_refresh_get_stats(album_refresh_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALBUM_REFRESH_H
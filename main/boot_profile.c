@@ -0,0 +1,105 @@
+#include "boot_profile.h"
+#include "conn_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "boot_profile";
+
+static portMUX_TYPE profile_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t phase_ms[BOOT_PHASE_COUNT];
+static bool initialized = false;
+static volatile bool report_pending = false; // Primer GOT_IP marcado, tabla sin imprimir
+
+static const char *phase_names[BOOT_PHASE_COUNT] = {
+    "app_main", "nvs_ready", "wifi_init", "radio_start", "sta_start",
+    "scan_done", "connect", "sta_connected", "got_ip"
+};
+
+// Tabla con el delta respecto del hito anterior alcanzado: ahí se ve qué etapa se come el presupuesto
+static void log_report(void) {
+    uint32_t ms[BOOT_PHASE_COUNT];
+    boot_profile_get(ms);
+
+    uint32_t prev = 0;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (ms[i] == BOOT_PHASE_NOT_REACHED) {
+            ESP_LOGI(TAG, "%-14s      -", phase_names[i]);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-14s %6lu ms (+%lu)", phase_names[i], (unsigned long)ms[i], (unsigned long)(ms[i] - prev));
+        prev = ms[i];
+    }
+    if (boot_profile_over_budget()) {
+        ESP_LOGW(TAG, "Tiempo hasta IP %lu ms: supera el presupuesto de %d ms",
+                 (unsigned long)ms[BOOT_PHASE_GOT_IP], CONFIG_WIFI_MGR_BOOT_BUDGET_MS);
+    } else {
+        ESP_LOGI(TAG, "Tiempo hasta IP %lu ms (presupuesto %d ms)",
+                 (unsigned long)ms[BOOT_PHASE_GOT_IP], CONFIG_WIFI_MGR_BOOT_BUDGET_MS);
+    }
+}
+
+static void conn_event_cb(const conn_event_t *evt, void *arg) {
+    switch (evt->type) {
+        case CONN_EVT_STA_START:     boot_profile_mark(BOOT_PHASE_STA_START); break;
+        case CONN_EVT_STA_CONNECTED: boot_profile_mark(BOOT_PHASE_STA_CONNECTED); break;
+        case CONN_EVT_GOT_IP: {
+            bool first;
+            taskENTER_CRITICAL(&profile_lock);
+            first = (phase_ms[BOOT_PHASE_GOT_IP] == BOOT_PHASE_NOT_REACHED);
+            taskEXIT_CRITICAL(&profile_lock);
+            boot_profile_mark(BOOT_PHASE_GOT_IP);
+            // Corremos en el event loop del sistema: la tabla (diez líneas de log) la imprime la tarea de estados
+            if (first) report_pending = true;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void ensure_initialized(void) {
+    taskENTER_CRITICAL(&profile_lock);
+    if (!initialized) {
+        for (int i = 0; i < BOOT_PHASE_COUNT; i++) phase_ms[i] = BOOT_PHASE_NOT_REACHED;
+        initialized = true;
+    }
+    taskEXIT_CRITICAL(&profile_lock);
+}
+
+void boot_profile_init(void) {
+    ensure_initialized();
+    conn_bus_subscribe_cb(conn_event_cb, NULL);
+}
+
+void boot_profile_mark(boot_phase_t phase) {
+    if (phase >= BOOT_PHASE_COUNT) return;
+    ensure_initialized(); // app_main marca antes de boot_profile_init
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    taskENTER_CRITICAL(&profile_lock);
+    if (phase_ms[phase] == BOOT_PHASE_NOT_REACHED) phase_ms[phase] = now_ms;
+    taskEXIT_CRITICAL(&profile_lock);
+}
+
+void boot_profile_get(uint32_t out_ms[BOOT_PHASE_COUNT]) {
+    ensure_initialized();
+    taskENTER_CRITICAL(&profile_lock);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) out_ms[i] = phase_ms[i];
+    taskEXIT_CRITICAL(&profile_lock);
+}
+
+void boot_profile_report(void) {
+    if (!report_pending) return;
+    report_pending = false;
+    log_report();
+}
+
+const char *boot_profile_phase_name(boot_phase_t phase) {
+    return (phase < BOOT_PHASE_COUNT) ? phase_names[phase] : "?";
+}
+
+bool boot_profile_over_budget(void) {
+    uint32_t ms[BOOT_PHASE_COUNT];
+    boot_profile_get(ms);
+    return ms[BOOT_PHASE_GOT_IP] != BOOT_PHASE_NOT_REACHED && ms[BOOT_PHASE_GOT_IP] > CONFIG_WIFI_MGR_BOOT_BUDGET_MS;
+}
@@ -0,0 +1,61 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Hitos del arranque, en el orden esperado. Cada uno se registra solo la primera vez.
+ */
+typedef enum {
+    BOOT_PHASE_APP_MAIN = 0,    /**< Entrada a app_main */
+    BOOT_PHASE_NVS_READY,       /**< NVS montada */
+    BOOT_PHASE_WIFI_INIT,       /**< netif + driver Wi-Fi inicializados */
+    BOOT_PHASE_RADIO_START,     /**< esp_wifi_start() llamado */
+    BOOT_PHASE_STA_START,       /**< Evento STA_START (radio lista) */
+    BOOT_PHASE_SCAN_DONE,       /**< Primer álbum armado (no ocurre en fast boot exitoso) */
+    BOOT_PHASE_CONNECT,         /**< Primer intento de conexión en curso (TRY_STA) */
+    BOOT_PHASE_STA_CONNECTED,   /**< Asociado al AP */
+    BOOT_PHASE_GOT_IP,          /**< IP obtenida: fin de la medición */
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+#define BOOT_PHASE_NOT_REACHED UINT32_MAX
+
+/**
+ * @brief Se suscribe a conn_bus para marcar STA_START, STA_CONNECTED y GOT_IP. Llamar tras conn_bus_init.
+ */
+void boot_profile_init(void);
+
+/**
+ * @brief Marca un hito con el tiempo desde el reset (esp_timer). Llamadas repetidas se ignoran.
+ */
+void boot_profile_mark(boot_phase_t phase);
+
+/**
+ * @brief Copia los tiempos (ms desde el reset) de cada hito; BOOT_PHASE_NOT_REACHED si no ocurrió.
+ */
+void boot_profile_get(uint32_t out_ms[BOOT_PHASE_COUNT]);
+
+/**
+ * @brief Imprime la tabla de hitos si el primer GOT_IP ya ocurrió y todavía no se imprimió.
+ * Lo llama la tarea de estados en CONNECTED: el callback de conn_bus solo marca, no loguea.
+ */
+void boot_profile_report(void);
+
+const char *boot_profile_phase_name(boot_phase_t phase);
+
+/**
+ * @brief true si el tiempo hasta IP superó CONFIG_WIFI_MGR_BOOT_BUDGET_MS.
+ */
+bool boot_profile_over_budget(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,127 @@
+#include "button.h"
+#include "mem_report.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include <stdbool.h>
+
+static const char *TAG = "button";
+
+#define BUTTON_GPIO        ((gpio_num_t)CONFIG_WIFI_MGR_BUTTON_GPIO)
+#define BUTTON_DEBOUNCE_MS 30
+#define BUTTON_LONG_MS     CONFIG_WIFI_MGR_BUTTON_LONG_MS
+#define BUTTON_DOUBLE_MS   CONFIG_WIFI_MGR_BUTTON_DOUBLE_MS
+
+static button_cb_t user_cb = NULL;
+static void *user_arg = NULL;
+
+static esp_timer_handle_t debounce_timer = NULL;
+static esp_timer_handle_t long_timer = NULL;
+static esp_timer_handle_t gap_timer = NULL;
+
+// Solo se tocan desde la tarea de esp_timer (todos los callbacks corren ahí, en serie)
+static bool pressed = false;
+static bool long_fired = false;
+static uint8_t clicks = 0;
+
+static void emit(button_event_t evt) {
+    static const char *names[BUTTON_EVT_MAX] = { "corta", "doble", "larga" };
+    ESP_LOGI(TAG, "Pulsación %s", names[evt]);
+    if (user_cb) user_cb(evt, user_arg);
+}
+
+/* =========================
+   ISR y debounce
+   ========================= */
+
+// Primer flanco: se silencia el pin y se mira el nivel recién cuando deja de rebotar
+static void IRAM_ATTR button_isr(void *arg) {
+    gpio_intr_disable(BUTTON_GPIO);
+    esp_timer_start_once(debounce_timer, BUTTON_DEBOUNCE_MS * 1000);
+}
+
+static void debounce_cb(void *arg) {
+    bool now_pressed = (gpio_get_level(BUTTON_GPIO) == 0);
+    gpio_intr_enable(BUTTON_GPIO);
+    if (now_pressed == pressed) return; // Rebote de ida y vuelta: nada cambió
+    pressed = now_pressed;
+
+    if (pressed) {
+        long_fired = false;
+        esp_timer_start_once(long_timer, (uint64_t)BUTTON_LONG_MS * 1000);
+        return;
+    }
+
+    // Soltado
+    esp_timer_stop(long_timer);
+    if (long_fired) return; // La larga ya se emitió al cumplirse el tiempo
+    if (++clicks >= 2) {
+        esp_timer_stop(gap_timer);
+        clicks = 0;
+        emit(BUTTON_EVT_DOUBLE);
+    } else {
+        esp_timer_start_once(gap_timer, (uint64_t)BUTTON_DOUBLE_MS * 1000);
+    }
+}
+
+/* =========================
+   Gestos
+   ========================= */
+
+static void long_cb(void *arg) {
+    if (!pressed) return;
+    long_fired = true;
+    esp_timer_stop(gap_timer);
+    clicks = 0;
+    emit(BUTTON_EVT_LONG);
+}
+
+static void gap_cb(void *arg) {
+    // No llegó la segunda pulsación a tiempo (si está presionado de nuevo, lo decide el release)
+    if (clicks == 1 && !pressed) {
+        clicks = 0;
+        emit(BUTTON_EVT_SHORT);
+    }
+}
+
+/* =========================
+   API
+   ========================= */
+
+void button_init(button_cb_t cb, void *arg) {
+    if (debounce_timer) return;
+    user_cb = cb;
+    user_arg = arg;
+
+    const esp_timer_create_args_t debounce_args = { .callback = debounce_cb, .name = "btn_debounce" };
+    const esp_timer_create_args_t long_args = { .callback = long_cb, .name = "btn_long" };
+    const esp_timer_create_args_t gap_args = { .callback = gap_cb, .name = "btn_gap" };
+    if (esp_timer_create(&debounce_args, &debounce_timer) != ESP_OK ||
+        esp_timer_create(&long_args, &long_timer) != ESP_OK ||
+        esp_timer_create(&gap_args, &gap_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudieron crear los timers del botón");
+        return;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << BUTTON_GPIO),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    gpio_config(&io_conf);
+
+    // ESP_ERR_INVALID_STATE: otro componente ya instaló el servicio, sirve igual
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "gpio_install_isr_service: %s", esp_err_to_name(err));
+        return;
+    }
+    gpio_isr_handler_add(BUTTON_GPIO, button_isr, NULL);
+    mem_report_register("button", NULL, 0, 3 * MEM_REPORT_ESP_TIMER_BYTES); // debounce, larga, doble
+
+    // Arranque con el botón ya apretado: se procesa como un flanco
+    if (gpio_get_level(BUTTON_GPIO) == 0) button_isr(NULL);
+    ESP_LOGI(TAG, "Botón en GPIO %d (larga %d ms, doble < %d ms)", BUTTON_GPIO, BUTTON_LONG_MS, BUTTON_DOUBLE_MS);
+}
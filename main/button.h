@@ -0,0 +1,32 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BUTTON_EVT_SHORT = 0,   /**< Pulsación corta (confirmada al vencer la ventana de doble pulsación) */
+    BUTTON_EVT_DOUBLE,      /**< Dos pulsaciones cortas dentro de la ventana */
+    BUTTON_EVT_LONG,        /**< Mantenido CONFIG_WIFI_MGR_BUTTON_LONG_MS (se emite sin esperar a soltar) */
+    BUTTON_EVT_MAX
+} button_event_t;
+
+/**
+ * @brief Se ejecuta en la tarea de esp_timer: debe ser breve (encolar y volver).
+ */
+typedef void (*button_cb_t)(button_event_t evt, void *arg);
+
+/**
+ * @brief Configura el GPIO del botón (activo en bajo, pull-up) con interrupción por flanco.
+ * La ISR solo arma el timer de debounce; los gestos se resuelven con esp_timer, sin polling.
+ */
+void button_init(button_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BUTTON_H
@@ -0,0 +1,130 @@
+#include "conn_bus.h"
+#include "mem_report.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "conn_bus";
+
+typedef struct {
+    QueueHandle_t queue;
+    conn_event_cb_t cb;
+    void *arg;
+} conn_subscriber_t;
+
+static portMUX_TYPE bus_lock = portMUX_INITIALIZER_UNLOCKED;
+static conn_subscriber_t subscribers[CONN_BUS_MAX_SUBSCRIBERS];
+static int n_subscribers = 0;
+static conn_status_t status = { .ip_str = "0.0.0.0" };
+static conn_bus_stats_t stats = {0};
+
+void conn_bus_init(void) {
+    taskENTER_CRITICAL(&bus_lock);
+    memset(subscribers, 0, sizeof(subscribers));
+    n_subscribers = 0;
+    taskEXIT_CRITICAL(&bus_lock);
+    mem_report_register("conn_bus", NULL, 0, sizeof(subscribers) + sizeof(status) + sizeof(stats));
+}
+
+static bool add_subscriber(QueueHandle_t queue, conn_event_cb_t cb, void *arg) {
+    bool ok = false;
+    taskENTER_CRITICAL(&bus_lock);
+    if (n_subscribers < CONN_BUS_MAX_SUBSCRIBERS) {
+        subscribers[n_subscribers].queue = queue;
+        subscribers[n_subscribers].cb = cb;
+        subscribers[n_subscribers].arg = arg;
+        n_subscribers++;
+        ok = true;
+    }
+    taskEXIT_CRITICAL(&bus_lock);
+    if (!ok) ESP_LOGE(TAG, "Sin lugar para más suscriptores");
+    return ok;
+}
+
+bool conn_bus_subscribe_queue(QueueHandle_t queue) {
+    return queue != NULL && add_subscriber(queue, NULL, NULL);
+}
+
+bool conn_bus_subscribe_cb(conn_event_cb_t cb, void *arg) {
+    return cb != NULL && add_subscriber(NULL, cb, arg);
+}
+
+void conn_bus_publish(conn_event_type_t type, uint8_t reason, uint32_t ip) {
+    if (type >= CONN_EVT_MAX) return;
+
+    conn_event_t evt = {
+        .type = type,
+        .reason = reason,
+        .ip = ip,
+        .timestamp_us = esp_timer_get_time(),
+    };
+
+    // 1. Foto: se formatea afuera y se copia adentro del lock (lectores nunca ven una IP a medias)
+    char ip_txt[16] = "0.0.0.0";
+    if (type == CONN_EVT_GOT_IP) {
+        esp_ip4_addr_t addr = { .addr = ip };
+        snprintf(ip_txt, sizeof(ip_txt), IPSTR, IP2STR(&addr));
+    }
+
+    taskENTER_CRITICAL(&bus_lock);
+    switch (type) {
+        case CONN_EVT_STA_DISCONNECTED:
+            status.last_reason = reason;
+            // fall through
+        case CONN_EVT_LOST_IP:
+            status.connected = false;
+            status.ip = 0;
+            memcpy(status.ip_str, ip_txt, sizeof(status.ip_str));
+            break;
+        case CONN_EVT_GOT_IP:
+            status.connected = true;
+            status.ip = ip;
+            status.last_reason = 0;
+            memcpy(status.ip_str, ip_txt, sizeof(status.ip_str));
+            break;
+        case CONN_EVT_STA_START:
+            status.sta_started = true;
+            break;
+        default:
+            break;
+    }
+    status.seq++;
+    stats.published[type]++;
+    int n = n_subscribers;
+    taskEXIT_CRITICAL(&bus_lock);
+
+    // 2. Entrega: colas sin bloqueo, callbacks en línea
+    for (int i = 0; i < n; i++) {
+        if (subscribers[i].queue) {
+            if (xQueueSend(subscribers[i].queue, &evt, 0) != pdTRUE) {
+                taskENTER_CRITICAL(&bus_lock);
+                stats.dropped++;
+                taskEXIT_CRITICAL(&bus_lock);
+            }
+        } else if (subscribers[i].cb) {
+            subscribers[i].cb(&evt, subscribers[i].arg);
+        }
+    }
+}
+
+void conn_bus_get_status(conn_status_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&bus_lock);
+    memcpy(out, &status, sizeof(status));
+    taskEXIT_CRITICAL(&bus_lock);
+}
+
+void conn_bus_clear_reason(void) {
+    taskENTER_CRITICAL(&bus_lock);
+    status.last_reason = 0;
+    taskEXIT_CRITICAL(&bus_lock);
+}
+
+void conn_bus_get_stats(conn_bus_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&bus_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&bus_lock);
+}
@@ -0,0 +1,81 @@
+#ifndef CONN_BUS_H
+#define CONN_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONN_BUS_MAX_SUBSCRIBERS 6
+
+typedef enum {
+    CONN_EVT_STA_CONNECTED = 0,   /**< Asociado al AP (todavía sin IP) */
+    CONN_EVT_STA_DISCONNECTED,    /**< Enlace caído; 'reason' trae el código del driver */
+    CONN_EVT_GOT_IP,              /**< IP obtenida; 'ip' en orden de red */
+    CONN_EVT_LOST_IP,             /**< IP perdida (lease vencido) */
+    CONN_EVT_STA_START,           /**< Interfaz STA lista tras esp_wifi_start() */
+    CONN_EVT_MAX
+} conn_event_type_t;
+
+typedef struct {
+    conn_event_type_t type;
+    uint8_t reason;
+    uint32_t ip;
+    int64_t timestamp_us;
+} conn_event_t;
+
+/**
+ * @brief Foto consistente del estado de conectividad (se copia entera bajo lock).
+ */
+typedef struct {
+    bool sta_started;     /**< El driver ya emitió STA_START (radio lista para escanear/conectar) */
+    bool connected;       /**< true con IP asignada */
+    uint32_t ip;          /**< Orden de red, 0 sin IP */
+    char ip_str[16];      /**< "0.0.0.0" sin IP */
+    uint8_t last_reason;  /**< Última razón de desconexión (0 = ninguna) */
+    uint32_t seq;         /**< Se incrementa con cada evento publicado */
+} conn_status_t;
+
+typedef void (*conn_event_cb_t)(const conn_event_t *evt, void *arg);
+
+typedef struct {
+    uint32_t published[CONN_EVT_MAX];
+    uint32_t dropped;     /**< Eventos descartados por colas llenas */
+} conn_bus_stats_t;
+
+void conn_bus_init(void);
+
+/**
+ * @brief Suscribe una cola (de elementos conn_event_t). Si está llena, el evento se descarta
+ * para ese suscriptor: el publicador (event loop) nunca se bloquea.
+ */
+bool conn_bus_subscribe_queue(QueueHandle_t queue);
+
+/**
+ * @brief Suscribe un callback. Se ejecuta en el contexto del event loop: debe ser breve.
+ */
+bool conn_bus_subscribe_cb(conn_event_cb_t cb, void *arg);
+
+/**
+ * @brief Publica un evento: actualiza la foto y lo entrega a cada suscriptor. Solo lo usa wifi_manager.
+ */
+void conn_bus_publish(conn_event_type_t type, uint8_t reason, uint32_t ip);
+
+void conn_bus_get_status(conn_status_t *out);
+
+/**
+ * @brief Limpia la última razón de desconexión de la foto (antes de un nuevo intento).
+ */
+void conn_bus_clear_reason(void);
+
+void conn_bus_get_stats(conn_bus_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONN_BUS_H
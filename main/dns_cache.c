@@ -0,0 +1,182 @@
+#include "dns_cache.h"
+#include <string.h>
+#include <ctype.h>
+
+/* Módulo puro (sin FreeRTOS ni sockets): lo usa solamente la tarea DNS, no necesita locks. */
+
+#define DNS_CACHE_ENTRIES     12
+#define DNS_CACHE_MAX_NAME    96    // Nombres más largos no se cachean
+#define DNS_CACHE_NEG_TTL_S   30    // Respuestas sin registros ni SOA
+#define DNS_CACHE_MAX_TTL_S   3600
+#define DNS_TYPE_OPT          41
+
+typedef struct {
+    bool used;
+    uint16_t qtype;
+    uint8_t qname_len;
+    uint8_t qname[DNS_CACHE_MAX_NAME];   // Formato wire, en minúsculas
+    uint16_t resp_len;
+    uint8_t resp[DNS_CACHE_MAX_RESP];
+    uint32_t stored_ms;
+    uint32_t ttl_s;
+    uint32_t last_use;                   // Marca LRU
+} dns_cache_entry_t;
+
+static dns_cache_entry_t cache[DNS_CACHE_ENTRIES];
+static uint32_t use_tick = 0;
+static dns_cache_stats_t stats = {0};
+
+/* =========================
+   Funciones Auxiliares
+   ========================= */
+
+// Salta un nombre (con o sin compresión). Retorna el offset siguiente o 0 si es inválido.
+static size_t skip_name(const uint8_t *msg, size_t len, size_t off) {
+    while (off < len) {
+        uint8_t l = msg[off];
+        if (l == 0) return off + 1;
+        if ((l & 0xc0) == 0xc0) return (off + 1 < len) ? off + 2 : 0;
+        if (l & 0xc0) return 0;
+        off += l + 1;
+    }
+    return 0;
+}
+
+/**
+ * Recorre todos los RR: calcula el TTL mínimo y, si elapsed_s > 0, lo descuenta en el lugar.
+ * El pseudo-registro OPT (EDNS) no tiene TTL real y se ignora.
+ */
+static bool walk_ttls(uint8_t *msg, size_t len, uint32_t elapsed_s, uint32_t *min_ttl, int *rr_seen) {
+    if (len < 12) return false;
+    uint16_t qd = (msg[4] << 8) | msg[5];
+    uint32_t rr = ((msg[6] << 8) | msg[7]) + ((msg[8] << 8) | msg[9]) + ((msg[10] << 8) | msg[11]);
+    size_t off = 12;
+
+    for (uint16_t i = 0; i < qd; i++) {
+        off = skip_name(msg, len, off);
+        if (off == 0 || off + 4 > len) return false;
+        off += 4;
+    }
+
+    *min_ttl = UINT32_MAX;
+    *rr_seen = 0;
+    for (uint32_t i = 0; i < rr; i++) {
+        off = skip_name(msg, len, off);
+        if (off == 0 || off + 10 > len) return false;
+        uint16_t type = (msg[off] << 8) | msg[off + 1];
+        uint16_t rdlen = (msg[off + 8] << 8) | msg[off + 9];
+        if (type != DNS_TYPE_OPT) {
+            uint8_t *p = &msg[off + 4];
+            uint32_t ttl = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+            if (ttl < *min_ttl) *min_ttl = ttl;
+            (*rr_seen)++;
+            if (elapsed_s > 0) {
+                ttl = (ttl > elapsed_s) ? ttl - elapsed_s : 0;
+                p[0] = ttl >> 24; p[1] = ttl >> 16; p[2] = ttl >> 8; p[3] = ttl;
+            }
+        }
+        off += 10 + rdlen;
+        if (off > len) return false;
+    }
+    return true;
+}
+
+static bool key_matches(const dns_cache_entry_t *e, const uint8_t *qname, size_t qname_len, uint16_t qtype) {
+    if (!e->used || e->qtype != qtype || e->qname_len != qname_len) return false;
+    for (size_t i = 0; i < qname_len; i++) {
+        if (e->qname[i] != (uint8_t)tolower(qname[i])) return false;
+    }
+    return true;
+}
+
+static dns_cache_entry_t *find_entry(const uint8_t *qname, size_t qname_len, uint16_t qtype) {
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        if (key_matches(&cache[i], qname, qname_len, qtype)) return &cache[i];
+    }
+    return NULL;
+}
+
+/* =========================
+   API
+   ========================= */
+
+void dns_cache_init(void) {
+    memset(cache, 0, sizeof(cache));
+    use_tick = 0;
+}
+
+bool dns_cache_lookup(const uint8_t *qname, size_t qname_len, uint16_t qtype, uint32_t now_ms,
+                      uint8_t *out, size_t cap, size_t *out_len) {
+    dns_cache_entry_t *e = find_entry(qname, qname_len, qtype);
+    if (!e) {
+        stats.misses++;
+        return false;
+    }
+
+    uint32_t elapsed_ms = now_ms - e->stored_ms;
+    if (elapsed_ms >= e->ttl_s * 1000U || e->resp_len > cap) {
+        e->used = false; // Vencida: la próxima consulta va al upstream
+        stats.misses++;
+        return false;
+    }
+
+    memcpy(out, e->resp, e->resp_len);
+    uint32_t min_ttl;
+    int rr_seen;
+    walk_ttls(out, e->resp_len, elapsed_ms / 1000, &min_ttl, &rr_seen);
+    *out_len = e->resp_len;
+    e->last_use = ++use_tick;
+    stats.hits++;
+    return true;
+}
+
+void dns_cache_store(const uint8_t *qname, size_t qname_len, uint16_t qtype,
+                     const uint8_t *resp, size_t len, uint32_t now_ms) {
+    if (qname_len == 0 || qname_len > DNS_CACHE_MAX_NAME || len < 12 || len > DNS_CACHE_MAX_RESP) return;
+    if (resp[2] & 0x02) return;                       // TC: respuesta truncada
+    uint8_t rcode = resp[3] & 0x0f;
+    if (rcode != 0 && rcode != 3) return;             // Solo NOERROR y NXDOMAIN
+
+    uint8_t tmp[DNS_CACHE_MAX_RESP];
+    memcpy(tmp, resp, len);
+    uint32_t ttl;
+    int rr_seen;
+    if (!walk_ttls(tmp, len, 0, &ttl, &rr_seen)) return;
+    if (rr_seen == 0) ttl = DNS_CACHE_NEG_TTL_S;
+    if (ttl == 0) return;
+    if (ttl > DNS_CACHE_MAX_TTL_S) ttl = DNS_CACHE_MAX_TTL_S;
+
+    dns_cache_entry_t *e = find_entry(qname, qname_len, qtype);
+    if (!e) {
+        for (int i = 0; i < DNS_CACHE_ENTRIES && !e; i++) {
+            if (!cache[i].used) e = &cache[i];
+        }
+    }
+    if (!e) {
+        // Caché llena: reemplazamos la entrada usada hace más tiempo
+        e = &cache[0];
+        for (int i = 1; i < DNS_CACHE_ENTRIES; i++) {
+            if (cache[i].last_use < e->last_use) e = &cache[i];
+        }
+        stats.evictions++;
+    }
+
+    e->used = true;
+    e->qtype = qtype;
+    e->qname_len = qname_len;
+    for (size_t i = 0; i < qname_len; i++) e->qname[i] = tolower(qname[i]);
+    memcpy(e->resp, resp, len);
+    e->resp_len = len;
+    e->stored_ms = now_ms;
+    e->ttl_s = ttl;
+    e->last_use = ++use_tick;
+    stats.stores++;
+}
+
+void dns_cache_get_stats(dns_cache_stats_t *out) {
+    if (out) memcpy(out, &stats, sizeof(stats));
+}
+
+size_t dns_cache_static_bytes(void) {
+    return sizeof(cache) + sizeof(stats);
+}
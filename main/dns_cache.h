@@ -0,0 +1,53 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DNS_CACHE_MAX_RESP 320 // Respuestas más grandes no se cachean (se reenvían igual)
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t stores;
+    uint32_t evictions;
+} dns_cache_stats_t;
+
+/**
+ * @brief Vacía la caché (por ejemplo, al cambiar de red upstream).
+ */
+void dns_cache_init(void);
+
+/**
+ * @brief Busca una respuesta vigente para (nombre, tipo).
+ * El nombre va en formato wire (etiquetas) y se compara sin distinguir mayúsculas.
+ * Los TTL de la copia entregada se descuentan según el tiempo transcurrido.
+ * @return true si hubo acierto y la respuesta se copió en 'out'.
+ */
+bool dns_cache_lookup(const uint8_t *qname, size_t qname_len, uint16_t qtype, uint32_t now_ms,
+                      uint8_t *out, size_t cap, size_t *out_len);
+
+/**
+ * @brief Guarda la respuesta del upstream. Si la caché está llena se reemplaza la menos usada (LRU).
+ * Respuestas truncadas, con error de servidor o con TTL 0 se ignoran.
+ */
+void dns_cache_store(const uint8_t *qname, size_t qname_len, uint16_t qtype,
+                     const uint8_t *resp, size_t len, uint32_t now_ms);
+
+void dns_cache_get_stats(dns_cache_stats_t *out);
+
+/**
+ * @brief Bytes estáticos de la caché (para mem_report; el módulo no depende de FreeRTOS).
+ */
+size_t dns_cache_static_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+#include "dns_forward.h"
+#include <string.h>
+#include <ctype.h>
+
+/* Módulo puro (sin FreeRTOS ni sockets): lo usa solamente la tarea DNS, no necesita locks. */
+
+typedef struct {
+    bool used;
+    uint16_t upstream_id;
+    uint16_t qtype;
+    uint8_t qname_len;
+    uint8_t qname[DNS_MAX_NAME_LEN];
+    uint8_t n_waiters;
+    dns_fwd_client_t waiters[DNS_FWD_MAX_WAITERS];
+    int64_t sent_us;
+} dns_pending_t;
+
+static dns_pending_t pending[DNS_FWD_MAX_PENDING];
+
+/* =========================
+   Funciones Auxiliares
+   ========================= */
+
+static bool pending_matches(const dns_pending_t *p, const uint8_t *qname, size_t qname_len, uint16_t qtype) {
+    if (!p->used || p->qtype != qtype || p->qname_len != qname_len) return false;
+    for (size_t i = 0; i < qname_len; i++) {
+        if (tolower(p->qname[i]) != tolower(qname[i])) return false;
+    }
+    return true;
+}
+
+/* =========================
+   API
+   ========================= */
+
+void dns_forward_reset(void) {
+    memset(pending, 0, sizeof(pending));
+}
+
+dns_fwd_result_t dns_forward_add(const uint8_t *query, const dns_question_t *q, const dns_fwd_client_t *client,
+                                 uint16_t upstream_id, int64_t now_us, uint8_t *out, size_t cap, size_t *out_len) {
+    const uint8_t *qname = query + q->name_off;
+
+    // Misma pregunta ya en vuelo: nos colgamos de ella (coalescing)
+    dns_pending_t *slot = NULL;
+    for (int i = 0; i < DNS_FWD_MAX_PENDING; i++) {
+        if (pending_matches(&pending[i], qname, q->name_len, q->qtype)) {
+            if (pending[i].n_waiters >= DNS_FWD_MAX_WAITERS) return DNS_FWD_FULL;
+            pending[i].waiters[pending[i].n_waiters++] = *client;
+            return DNS_FWD_COALESCED;
+        }
+        if (!pending[i].used && slot == NULL) slot = &pending[i];
+    }
+    if (slot == NULL || q->qend > cap || q->name_len > DNS_MAX_NAME_LEN) return DNS_FWD_FULL;
+
+    // Nueva consulta al upstream: solo encabezado + pregunta, con ID propio
+    memset(slot, 0, sizeof(*slot));
+    slot->used = true;
+    slot->upstream_id = upstream_id;
+    slot->qtype = q->qtype;
+    slot->qname_len = q->name_len;
+    memcpy(slot->qname, qname, q->name_len);
+    slot->waiters[0] = *client;
+    slot->n_waiters = 1;
+    slot->sent_us = now_us;
+
+    memcpy(out, query, q->qend);
+    out[0] = upstream_id >> 8;
+    out[1] = upstream_id & 0xff;
+    out[2] = 0x01; // RD
+    out[3] = 0x00;
+    dns_packet_set_counts(out, 1, 0);
+    *out_len = q->qend;
+    return DNS_FWD_SEND;
+}
+
+bool dns_forward_id_in_use(uint16_t upstream_id) {
+    for (int i = 0; i < DNS_FWD_MAX_PENDING; i++) {
+        if (pending[i].used && pending[i].upstream_id == upstream_id) return true;
+    }
+    return false;
+}
+
+void dns_forward_cancel(uint16_t upstream_id) {
+    for (int i = 0; i < DNS_FWD_MAX_PENDING; i++) {
+        if (pending[i].used && pending[i].upstream_id == upstream_id) pending[i].used = false;
+    }
+}
+
+bool dns_forward_match_reply(uint8_t *resp, size_t len, int64_t now_us, dns_fwd_reply_t *out) {
+    if (len < DNS_HEADER_LEN || !(resp[2] & 0x80)) return false;
+
+    // La pregunta de la respuesta se valida igual que la de un cliente (quitando QR temporalmente)
+    resp[2] &= ~0x80;
+    int rc = dns_packet_parse_question(resp, len, &out->q);
+    resp[2] |= 0x80;
+    if (rc != 0) return false;
+
+    uint16_t id = (resp[0] << 8) | resp[1];
+    for (int i = 0; i < DNS_FWD_MAX_PENDING; i++) {
+        dns_pending_t *p = &pending[i];
+        if (!p->used || p->upstream_id != id) continue;
+        if (!pending_matches(p, resp + out->q.name_off, out->q.name_len, out->q.qtype)) return false;
+
+        out->latency_us = (uint32_t)(now_us - p->sent_us);
+        out->n_clients = p->n_waiters;
+        memcpy(out->clients, p->waiters, p->n_waiters * sizeof(p->waiters[0]));
+        p->used = false;
+        return true;
+    }
+    return false;
+}
+
+uint32_t dns_forward_expire(int64_t now_us) {
+    uint32_t expired = 0;
+    for (int i = 0; i < DNS_FWD_MAX_PENDING; i++) {
+        if (pending[i].used && (now_us - pending[i].sent_us) > DNS_FWD_TIMEOUT_MS * 1000LL) {
+            pending[i].used = false;
+            expired++;
+        }
+    }
+    return expired;
+}
+
+size_t dns_forward_static_bytes(void) {
+    return sizeof(pending);
+}
@@ -0,0 +1,89 @@
+#ifndef DNS_FORWARD_H
+#define DNS_FORWARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "dns_packet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Tabla de consultas en vuelo del forwarder (coalescing incluido). Módulo puro (sin FreeRTOS ni
+ * sockets): lo usa solamente la tarea DNS y se compila en el host para test/host.
+ */
+
+#define DNS_FWD_MAX_PENDING 6
+#define DNS_FWD_MAX_WAITERS 4
+#define DNS_FWD_TIMEOUT_MS  2000
+
+/** Cliente que espera la respuesta. ip y port en orden de red, como en sockaddr_in. */
+typedef struct {
+    uint32_t ip;
+    uint16_t port;
+    uint16_t id;
+} dns_fwd_client_t;
+
+typedef enum {
+    DNS_FWD_SEND = 0,   /**< Consulta nueva: enviar 'out' al upstream */
+    DNS_FWD_COALESCED,  /**< La misma pregunta ya estaba en vuelo: el cliente quedó en espera */
+    DNS_FWD_FULL,       /**< Sin lugar en la tabla: el cliente reintentará */
+} dns_fwd_result_t;
+
+typedef struct {
+    uint8_t n_clients;
+    dns_fwd_client_t clients[DNS_FWD_MAX_WAITERS];
+    uint32_t latency_us;
+    dns_question_t q;   /**< Pregunta de la respuesta (clave para la caché) */
+} dns_fwd_reply_t;
+
+/**
+ * @brief Vacía la tabla (arranque del servidor o cambio de upstream).
+ */
+void dns_forward_reset(void);
+
+/**
+ * @brief Registra la consulta de un cliente.
+ * Si la pregunta ya está en vuelo el cliente se agrega a sus esperas; si no, se toma un lugar libre
+ * y se arma en 'out' la consulta al upstream (encabezado + pregunta, con 'upstream_id' y RD).
+ * @return DNS_FWD_SEND solo cuando hay que enviar 'out' (de largo *out_len).
+ */
+dns_fwd_result_t dns_forward_add(const uint8_t *query, const dns_question_t *q, const dns_fwd_client_t *client,
+                                 uint16_t upstream_id, int64_t now_us, uint8_t *out, size_t cap, size_t *out_len);
+
+/**
+ * @brief Indica si un ID ya pertenece a una consulta en vuelo.
+ * El llamador vuelve a sortear el ID hasta obtener uno libre, así una respuesta nunca puede
+ * emparejarse con una consulta ajena.
+ */
+bool dns_forward_id_in_use(uint16_t upstream_id);
+
+/**
+ * @brief Libera el lugar de una consulta que no se pudo enviar.
+ */
+void dns_forward_cancel(uint16_t upstream_id);
+
+/**
+ * @brief Empareja una respuesta del upstream (ID y pregunta) y libera su lugar.
+ * @return true si correspondía a una consulta en vuelo; 'out' trae los clientes a contestar.
+ */
+bool dns_forward_match_reply(uint8_t *resp, size_t len, int64_t now_us, dns_fwd_reply_t *out);
+
+/**
+ * @brief Descarta las consultas sin respuesta después de DNS_FWD_TIMEOUT_MS.
+ * @return Cantidad de consultas vencidas.
+ */
+uint32_t dns_forward_expire(int64_t now_us);
+
+/**
+ * @brief Bytes estáticos de la tabla (para mem_report).
+ */
+size_t dns_forward_static_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DNS_FORWARD_H
@@ -0,0 +1,101 @@
+#include "dns_packet.h"
+#include <string.h>
+#include <ctype.h>
+
+/* Respuesta A fija (precalculada): puntero a la pregunta, IN, TTL 60s, 192.168.4.1 */
+static const uint8_t dns_answer_a[] = {
+    0xc0, 0x0c,             // Pointer a la pregunta (offset 12)
+    0x00, 0x01,             // Type A
+    0x00, 0x01,             // Class IN
+    0x00, 0x00, 0x00, 0x3c, // TTL 60s
+    0x00, 0x04,             // Len 4
+    192, 168, 4, 1
+};
+
+void dns_packet_set_counts(uint8_t *buf, uint16_t qd, uint16_t an) {
+    buf[4] = qd >> 8; buf[5] = qd & 0xff;
+    buf[6] = an >> 8; buf[7] = an & 0xff;
+    buf[8] = 0; buf[9] = 0;   // NSCOUNT
+    buf[10] = 0; buf[11] = 0; // ARCOUNT (descartamos EDNS y cualquier adicional)
+}
+
+// Encabezado de respuesta: QR=1, AA=1, se copia RD y se informa RA como lo hacía el portal original
+static void dns_set_response_flags(uint8_t *buf, uint8_t rcode) {
+    uint8_t rd = buf[2] & 0x01;
+    buf[2] = (buf[2] & 0x78) | 0x80 | 0x04 | rd;
+    buf[3] = (rd ? 0x80 : 0x00) | (rcode & 0x0f);
+}
+
+int dns_packet_parse_question(const uint8_t *buf, size_t len, dns_question_t *q) {
+    if (len < DNS_HEADER_LEN) return -1;
+    if (buf[2] & 0x80) return -1;                       // QR=1: nunca contestamos a otro servidor
+    if ((buf[2] >> 3) & 0x0f) return DNS_RCODE_NOTIMP;  // Solo OPCODE 0 (consulta estándar)
+    if (((buf[4] << 8) | buf[5]) != 1) return DNS_RCODE_FORMERR;
+
+    size_t pos = DNS_HEADER_LEN;
+    while (1) {
+        if (pos >= len) return DNS_RCODE_FORMERR;
+        uint8_t label = buf[pos];
+        if (label == 0) { pos++; break; }
+        if (label & 0xc0) return DNS_RCODE_FORMERR;     // Sin compresión en la pregunta
+        pos += label + 1;
+        if (pos - DNS_HEADER_LEN >= DNS_MAX_NAME_LEN) return DNS_RCODE_FORMERR;
+    }
+    if (pos + 4 > len) return DNS_RCODE_FORMERR;
+
+    q->name_off = DNS_HEADER_LEN;
+    q->name_len = pos - DNS_HEADER_LEN;
+    q->qtype = (buf[pos] << 8) | buf[pos + 1];
+    q->qclass = (buf[pos + 2] << 8) | buf[pos + 3];
+    q->qend = pos + 4; // Todo lo que sigue (EDNS, adicionales) se descarta
+    return 0;
+}
+
+bool dns_packet_name_equals(const uint8_t *wire, size_t wire_len, const char *dotted) {
+    size_t i = 0;
+    while (i < wire_len && wire[i] != 0) {
+        uint8_t l = wire[i++];
+        for (uint8_t k = 0; k < l; k++, i++) {
+            if (i >= wire_len || *dotted == '\0') return false;
+            if (tolower(wire[i]) != tolower((unsigned char)*dotted++)) return false;
+        }
+        if (i < wire_len && wire[i] != 0) {
+            if (*dotted != '.') return false;
+            dotted++;
+        }
+    }
+    return *dotted == '\0';
+}
+
+size_t dns_packet_build_response(uint8_t *buf, size_t len, size_t cap, dns_reply_kind_t *kind) {
+    dns_reply_kind_t dummy;
+    dns_question_t q;
+    if (!kind) kind = &dummy;
+    *kind = DNS_REPLY_DROP;
+    if (!buf || len > cap) return 0;
+
+    int rc = dns_packet_parse_question(buf, len, &q);
+    if (rc < 0) return 0;
+    if (rc > 0) {
+        dns_set_response_flags(buf, rc);
+        dns_packet_set_counts(buf, 0, 0);
+        *kind = DNS_REPLY_ERROR;
+        return DNS_HEADER_LEN;
+    }
+
+    dns_set_response_flags(buf, 0);
+
+    bool class_ok = (q.qclass == DNS_QCLASS_IN || q.qclass == DNS_QCLASS_ANY);
+    if (class_ok && (q.qtype == DNS_QTYPE_A || q.qtype == DNS_QTYPE_ANY)) {
+        if (q.qend + sizeof(dns_answer_a) > cap) return 0;
+        memcpy(buf + q.qend, dns_answer_a, sizeof(dns_answer_a));
+        dns_packet_set_counts(buf, 1, 1);
+        *kind = DNS_REPLY_A;
+        return q.qend + sizeof(dns_answer_a);
+    }
+
+    // AAAA, HTTPS y demás: NOERROR sin registros, para que el cliente caiga al A del portal
+    dns_packet_set_counts(buf, 1, 0);
+    *kind = DNS_REPLY_EMPTY;
+    return q.qend;
+}
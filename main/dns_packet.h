@@ -0,0 +1,74 @@
+#ifndef DNS_PACKET_H
+#define DNS_PACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lectura y armado de paquetes DNS del responder del portal. Módulo puro (sin FreeRTOS ni sockets):
+ * se compila en el host para el benchmark de replay (test/host).
+ */
+
+#define DNS_HEADER_LEN      12
+#define DNS_MAX_NAME_LEN    255
+
+#define DNS_QTYPE_A         1
+#define DNS_QTYPE_ANY       255
+#define DNS_QCLASS_IN       1
+#define DNS_QCLASS_ANY      255
+
+#define DNS_RCODE_FORMERR   1
+#define DNS_RCODE_NOTIMP    4
+
+typedef struct {
+    size_t name_off;
+    size_t name_len;   /**< Incluye el 0 final */
+    uint16_t qtype;
+    uint16_t qclass;
+    size_t qend;       /**< Offset siguiente a la pregunta */
+} dns_question_t;
+
+/** Qué se hizo con el paquete (el servidor lo usa para sus contadores). */
+typedef enum {
+    DNS_REPLY_DROP = 0,     /**< Se descarta sin responder */
+    DNS_REPLY_ERROR,        /**< FORMERR / NOTIMP */
+    DNS_REPLY_A,            /**< Registro A con la IP del portal */
+    DNS_REPLY_EMPTY,        /**< NOERROR sin registros (AAAA, HTTPS, etc.) */
+} dns_reply_kind_t;
+
+/**
+ * @brief Valida el encabezado y recorre la única pregunta, siempre dentro de 'len'.
+ * @return 0 si es válida, un RCODE (>0) si hay que contestar con error, -1 si se descarta.
+ */
+int dns_packet_parse_question(const uint8_t *buf, size_t len, dns_question_t *q);
+
+/**
+ * @brief Escribe QDCOUNT/ANCOUNT y pone en cero NSCOUNT/ARCOUNT.
+ */
+void dns_packet_set_counts(uint8_t *buf, uint16_t qd, uint16_t an);
+
+/**
+ * @brief Compara un nombre en formato wire con uno en texto ("setup.esp32"), sin distinguir mayúsculas.
+ */
+bool dns_packet_name_equals(const uint8_t *wire, size_t wire_len, const char *dotted);
+
+/**
+ * @brief Construye la respuesta del modo secuestro en el mismo buffer de la consulta.
+ * @param buf Buffer con la consulta recibida (se reescribe con la respuesta).
+ * @param len Bytes válidos de la consulta.
+ * @param cap Capacidad total del buffer.
+ * @param kind Opcional: tipo de respuesta armada.
+ * @return Largo de la respuesta a enviar, o 0 si el paquete debe descartarse.
+ */
+size_t dns_packet_build_response(uint8_t *buf, size_t len, size_t cap, dns_reply_kind_t *kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DNS_PACKET_H
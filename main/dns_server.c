@@ -2,83 +2,317 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "dns_server.h"
+#include "dns_cache.h"
+#include "dns_packet.h"
+#include "dns_forward.h"
+#include "mem_report.h"
+#include "task_topology.h"
 #include <lwip/sockets.h> // Importante para close() y sockets
 
 static const char *TAG = "dns_server";
-static int socket_fd = -1;
 static TaskHandle_t dns_task_handle = NULL;
+static SemaphoreHandle_t dns_stopped_sem = NULL;
+static volatile bool dns_running = false;
 
-#define DNS_PORT 53
+// La tarea se crea una sola vez (memoria estática) y luego solo se suspende/reanuda
+#define DNS_TASK_STACK      TASK_DNS_STACK
+static StackType_t dns_task_stack[DNS_TASK_STACK];
+static StaticTask_t dns_task_tcb;
+static StaticSemaphore_t dns_stopped_sem_buf;
+static dns_server_stats_t dns_stats = {0};
 
-void dns_server_task(void *pvParameters) {
+#define DNS_PORT            53
+#define DNS_POLL_MS         200   // Cada cuánto el bucle revisa la señal de parada
+#define DNS_STOP_TIMEOUT_MS 1000
+
+/* Forwarder (modo APSTA con uplink); la tabla de consultas en vuelo está en dns_forward.c */
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+static uint8_t dns_tx_buffer[512];
+
+// Upstream (resolver del lado STA). Lo escribe el event loop, lo lee la tarea DNS.
+static portMUX_TYPE upstream_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t upstream_ip = 0;     // Orden de red; 0 = secuestrar todos los nombres
+static uint16_t upstream_port = DNS_PORT;
+static bool upstream_changed = false;
+#endif
+
+/* =========================
+   Armado de respuestas (dns_packet.c, sin sockets)
+   ========================= */
+
+static size_t dns_build_response(uint8_t *buf, size_t len, size_t cap) {
+    dns_reply_kind_t kind;
+    size_t resp_len = dns_packet_build_response(buf, len, cap, &kind);
+    switch (kind) {
+        case DNS_REPLY_A:     dns_stats.answered_a++; break;
+        case DNS_REPLY_EMPTY: dns_stats.answered_empty++; break;
+        default:              dns_stats.rejected++; break;
+    }
+    return resp_len;
+}
+
+void dns_server_get_stats(dns_server_stats_t *out) {
+    if (!out) return;
+    memcpy(out, &dns_stats, sizeof(dns_stats));
+    dns_cache_stats_t cs;
+    dns_cache_get_stats(&cs);
+    out->cache_hits = cs.hits;
+    out->cache_misses = cs.misses;
+}
+
+/* =========================
+   Forwarder con caché
+   ========================= */
+
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+
+void dns_server_set_upstream(uint32_t ip4_addr, uint16_t port) {
+    taskENTER_CRITICAL(&upstream_lock);
+    if (ip4_addr != upstream_ip) upstream_changed = true;
+    upstream_ip = ip4_addr;
+    upstream_port = port ? port : DNS_PORT;
+    taskEXIT_CRITICAL(&upstream_lock);
+}
+
+static void dns_forward_query(int sock, int up_sock, const uint8_t *buf, const dns_question_t *q,
+                              const struct sockaddr_in *client, const struct sockaddr_in *up_addr) {
+    uint16_t client_id = (buf[0] << 8) | buf[1];
+    size_t out_len;
+
+    // 1. Caché: se contesta sin salir del equipo
+    if (dns_cache_lookup(buf + q->name_off, q->name_len, q->qtype, (uint32_t)(esp_timer_get_time() / 1000),
+                         dns_tx_buffer, sizeof(dns_tx_buffer), &out_len)) {
+        dns_tx_buffer[0] = client_id >> 8;
+        dns_tx_buffer[1] = client_id & 0xff;
+        sendto(sock, dns_tx_buffer, out_len, 0, (const struct sockaddr *)client, sizeof(*client));
+        return;
+    }
+
+    // 2. Tabla de consultas en vuelo: agrupa la misma pregunta o arma una nueva con ID aleatorio
+    dns_fwd_client_t c = { .ip = client->sin_addr.s_addr, .port = client->sin_port, .id = client_id };
+    uint16_t upstream_id;
+    do {
+        upstream_id = esp_random() & 0xffff; // Nunca un ID ya en vuelo (la tabla es chica: termina enseguida)
+    } while (dns_forward_id_in_use(upstream_id));
+    switch (dns_forward_add(buf, q, &c, upstream_id, esp_timer_get_time(),
+                            dns_tx_buffer, sizeof(dns_tx_buffer), &out_len)) {
+        case DNS_FWD_COALESCED:
+            dns_stats.coalesced++;
+            return;
+        case DNS_FWD_FULL:
+            dns_stats.rejected++; // El cliente reintentará
+            return;
+        case DNS_FWD_SEND:
+            break;
+    }
+
+    if (sendto(up_sock, dns_tx_buffer, out_len, 0, (const struct sockaddr *)up_addr, sizeof(*up_addr)) < 0) {
+        dns_forward_cancel(upstream_id);
+        dns_stats.rejected++;
+        return;
+    }
+    dns_stats.forwarded++;
+}
+
+static void dns_handle_upstream_reply(int sock, uint8_t *buf, size_t len) {
+    dns_fwd_reply_t r;
+    int64_t now = esp_timer_get_time();
+    if (!dns_forward_match_reply(buf, len, now, &r)) return;
+
+    dns_stats.fwd_latency_us_total += r.latency_us;
+    if (r.latency_us > dns_stats.fwd_latency_us_max) dns_stats.fwd_latency_us_max = r.latency_us;
+    dns_stats.fwd_answered++;
+
+    dns_cache_store(buf + r.q.name_off, r.q.name_len, r.q.qtype, buf, len, (uint32_t)(now / 1000));
+
+    for (int w = 0; w < r.n_clients; w++) {
+        struct sockaddr_in to = { .sin_family = AF_INET, .sin_port = r.clients[w].port };
+        to.sin_addr.s_addr = r.clients[w].ip;
+        buf[0] = r.clients[w].id >> 8;
+        buf[1] = r.clients[w].id & 0xff;
+        sendto(sock, buf, len, 0, (struct sockaddr *)&to, sizeof(to));
+    }
+}
+
+#else
+
+void dns_server_set_upstream(uint32_t ip4_addr, uint16_t port) {
+    (void)ip4_addr;
+    (void)port;
+}
+
+#endif // CONFIG_WIFI_MGR_DNS_FORWARDER
+
+/* =========================
+   Tarea del servidor
+   ========================= */
+
+// Atiende consultas mientras dns_running sea true. Retorna al suspenderse o ante un error de socket.
+static void dns_server_serve(void) {
     uint8_t rx_buffer[512];
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_addr_len = sizeof(client_addr);
+    struct sockaddr_in server_addr = {0}, client_addr;
+    socklen_t client_addr_len;
+    int up_sock = -1;
 
-    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-    if (socket_fd < 0) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
         ESP_LOGE(TAG, "No se pudo crear el socket DNS");
-        vTaskDelete(NULL);
-        return;
+        goto exit;
     }
-    
+
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(DNS_PORT);
 
-    if (bind(socket_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
         ESP_LOGE(TAG, "Error en bind puerto 53");
-        close(socket_fd);
-        vTaskDelete(NULL);
-        return;
+        goto exit;
     }
 
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+    up_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (up_sock < 0) ESP_LOGW(TAG, "Sin socket upstream: el forwarder queda deshabilitado");
+    dns_forward_reset();
+#endif
+
     ESP_LOGI(TAG, "DNS Server de Producción iniciado...");
 
-    while (1) {
-        int len = recvfrom(socket_fd, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&client_addr, &client_addr_len);
-        if (len > 12) {
-            // HEADER DNS
-            rx_buffer[2] |= 0x80; // QR = 1 (Respuesta)
-            rx_buffer[2] |= 0x04; // AA = 1 (Autoritativo)
-            
-            // Importante: Copiar el bit de recursión deseada (RD) del cliente al bit de recursión disponible (RA)
-            if (rx_buffer[2] & 0x01) rx_buffer[3] |= 0x80; 
-            
-            rx_buffer[3] &= 0xF0; // RCODE = 0 (No error)
-            rx_buffer[6] = 0; rx_buffer[7] = 1; // 1 Answer
-
-            // ANSWER SECTION
-            uint8_t *answer = &rx_buffer[len];
-            *answer++ = 0xc0; *answer++ = 0x0c; // Pointer a la pregunta
-            *answer++ = 0x00; *answer++ = 0x01; // Type A
-            *answer++ = 0x00; *answer++ = 0x01; // Class IN
-            *answer++ = 0x00; *answer++ = 0x00; *answer++ = 0x00; *answer++ = 0x3c; // TTL 60s
-            *answer++ = 0x00; *answer++ = 0x04; // Len 4
-            *answer++ = 192;  *answer++ = 168;  *answer++ = 4;    *answer++ = 1;
-
-            sendto(socket_fd, rx_buffer, len + 16, 0, (struct sockaddr *)&client_addr, client_addr_len);
+    while (dns_running) {
+        // select() con timeout: la tarea nunca queda bloqueada para siempre en recvfrom
+        fd_set read_fds;
+        FD_ZERO(&read_fds);
+        FD_SET(sock, &read_fds);
+        if (up_sock >= 0) FD_SET(up_sock, &read_fds);
+        struct timeval tv = { .tv_sec = 0, .tv_usec = DNS_POLL_MS * 1000 };
+
+        int ready = select((up_sock > sock ? up_sock : sock) + 1, &read_fds, NULL, NULL, &tv);
+        if (ready < 0) {
+            ESP_LOGE(TAG, "Error en select (errno %d)", errno);
+            break;
+        }
+
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+        struct sockaddr_in up_addr = { .sin_family = AF_INET };
+        taskENTER_CRITICAL(&upstream_lock);
+        up_addr.sin_addr.s_addr = upstream_ip;
+        up_addr.sin_port = htons(upstream_port);
+        bool flush = upstream_changed;
+        upstream_changed = false;
+        taskEXIT_CRITICAL(&upstream_lock);
+
+        if (flush) {
+            dns_cache_init(); // Otro resolver (u otra red): la caché anterior ya no vale
+            dns_forward_reset();
+        }
+        dns_stats.fwd_timeouts += dns_forward_expire(esp_timer_get_time());
+
+        if (up_sock >= 0 && FD_ISSET(up_sock, &read_fds)) {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            int len = recvfrom(up_sock, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&from, &from_len);
+            // Solo el resolver configurado, desde su puerto: otro host de la LAN no puede falsificarlo
+            if (len > 0 && from.sin_addr.s_addr == up_addr.sin_addr.s_addr && from.sin_port == up_addr.sin_port) {
+                dns_handle_upstream_reply(sock, rx_buffer, len);
+            }
+        }
+#endif
+
+        if (!FD_ISSET(sock, &read_fds)) continue;
+
+        client_addr_len = sizeof(client_addr);
+        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer), 0, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (len <= 0) continue;
+
+        int64_t t0 = esp_timer_get_time();
+        dns_stats.queries++;
+
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+        dns_question_t q;
+        if (up_sock >= 0 && up_addr.sin_addr.s_addr != 0 &&
+            dns_packet_parse_question(rx_buffer, len, &q) == 0 && q.qclass == DNS_QCLASS_IN &&
+            !dns_packet_name_equals(rx_buffer + q.name_off, q.name_len, CONFIG_WIFI_MGR_DNS_PORTAL_HOSTNAME)) {
+            dns_forward_query(sock, up_sock, rx_buffer, &q, &client_addr, &up_addr);
+            dns_stats.busy_us += esp_timer_get_time() - t0;
+            continue;
+        }
+#endif
+
+        size_t resp_len = dns_build_response(rx_buffer, len, sizeof(rx_buffer));
+        if (resp_len > 0) {
+            sendto(sock, rx_buffer, resp_len, 0, (struct sockaddr *)&client_addr, client_addr_len);
         }
-        // ELIMINADO: vTaskDelay(pdMS_TO_TICKS(10));
+        dns_stats.busy_us += esp_timer_get_time() - t0;
+    }
+
+exit:
+    if (up_sock >= 0) close(up_sock);
+    if (sock >= 0) close(sock);
+}
+
+static void dns_server_task(void *pvParameters) {
+    while (1) {
+        // Suspendida: sin sockets abiertos, esperando a dns_server_start()
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        dns_server_serve();
+        dns_running = false;
+        xSemaphoreGive(dns_stopped_sem);
     }
 }
 
 void dns_server_start(void) {
+    if (dns_running) return;
+
     if (dns_task_handle == NULL) {
-        xTaskCreate(dns_server_task, "dns_task", 4096, NULL, 5, &dns_task_handle);
+        dns_stopped_sem = xSemaphoreCreateBinaryStatic(&dns_stopped_sem_buf);
+        dns_task_handle = xTaskCreateStaticPinnedToCore(dns_server_task, "dns_task", DNS_TASK_STACK, NULL, TASK_DNS_PRIO,
+                                                        dns_task_stack, &dns_task_tcb, TASK_TOPOLOGY_CORE_ID(TASK_DNS_CORE));
+        size_t static_bytes = sizeof(dns_task_stack) + sizeof(dns_task_tcb) + sizeof(dns_stopped_sem_buf);
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+        static_bytes += dns_forward_static_bytes() + sizeof(dns_tx_buffer);
+#endif
+        mem_report_register("dns_server", dns_task_handle, DNS_TASK_STACK, static_bytes);
+#ifdef CONFIG_WIFI_MGR_DNS_FORWARDER
+        // dns_cache.c es puro (se compila en el host): su dueño lo registra
+        mem_report_register("dns_cache", NULL, 0, dns_cache_static_bytes());
+#endif
     }
+
+    // Si la pasada anterior terminó sola (error de socket), su aviso de parada quedó pendiente
+    xSemaphoreTake(dns_stopped_sem, 0);
+
+    dns_running = true;
+    xTaskNotifyGive(dns_task_handle);
 }
 
 void dns_server_stop(void) {
-    if (dns_task_handle) {
-        vTaskDelete(dns_task_handle);
-        dns_task_handle = NULL;
+    if (!dns_running) return;
+
+    // Señal de parada: la tarea cierra sus sockets en <= DNS_POLL_MS y vuelve a esperar
+    dns_running = false;
+    if (xSemaphoreTake(dns_stopped_sem, pdMS_TO_TICKS(DNS_STOP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "La tarea DNS no confirmó la parada a tiempo");
+    }
+
+    dns_server_stats_t st;
+    dns_server_get_stats(&st);
+    if (st.busy_us > 0) {
+        ESP_LOGI(TAG, "DNS suspendido: %lu consultas (%lu A, %lu vacías, %lu rechazadas), %llu q/s de procesamiento",
+                 (unsigned long)st.queries, (unsigned long)st.answered_a,
+                 (unsigned long)st.answered_empty, (unsigned long)st.rejected,
+                 (unsigned long long)(st.queries * 1000000ULL / st.busy_us));
     }
-    if (socket_fd != -1) {
-        close(socket_fd);
-        socket_fd = -1;
+    uint32_t lookups = st.cache_hits + st.cache_misses;
+    if (lookups > 0) {
+        ESP_LOGI(TAG, "Forwarder: %lu%% aciertos de caché, %lu reenviadas, %lu agrupadas, %lu timeouts, latencia media %lu us (máx %lu us)",
+                 (unsigned long)(st.cache_hits * 100 / lookups), (unsigned long)st.forwarded,
+                 (unsigned long)st.coalesced, (unsigned long)st.fwd_timeouts,
+                 (unsigned long)(st.fwd_answered ? st.fwd_latency_us_total / st.fwd_answered : 0),
+                 (unsigned long)st.fwd_latency_us_max);
     }
-}
\ No newline at end of file
+}
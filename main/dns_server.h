@@ -1,7 +1,56 @@
 #ifndef DNS_SERVER_H
 #define DNS_SERVER_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Contadores del responder DNS (acumulados desde el arranque).
+ */
+typedef struct {
+    uint32_t queries;          /**< Paquetes recibidos */
+    uint32_t answered_a;       /**< Respuestas con registro A (IP del portal) */
+    uint32_t answered_empty;   /**< Respuestas NOERROR sin registros (AAAA, HTTPS, etc.) */
+    uint32_t rejected;         /**< Paquetes malformados o no soportados */
+    uint64_t busy_us;          /**< Tiempo total procesando paquetes (para queries/s) */
+    uint32_t cache_hits;       /**< Forwarder: respuestas servidas desde la caché */
+    uint32_t cache_misses;     /**< Forwarder: consultas que no estaban (o habían vencido) */
+    uint32_t forwarded;        /**< Consultas enviadas al resolver upstream */
+    uint32_t coalesced;        /**< Consultas agrupadas con otra idéntica ya en vuelo */
+    uint32_t fwd_answered;     /**< Respuestas del upstream recibidas a tiempo */
+    uint32_t fwd_timeouts;     /**< Consultas upstream vencidas sin respuesta */
+    uint64_t fwd_latency_us_total;
+    uint32_t fwd_latency_us_max;
+} dns_server_stats_t;
+
+/**
+ * @brief Reanuda el responder DNS. La tarea (estática) se crea en la primera llamada
+ * y nunca se borra. Idempotente.
+ */
 void dns_server_start(void);
+
+/**
+ * @brief Suspende el responder: la tarea cierra sus sockets y queda esperando. Idempotente.
+ */
 void dns_server_stop(void);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Configura el resolver del lado STA para el modo forwarder.
+ * Con ip4_addr = 0 todos los nombres se resuelven a la IP del portal (modo secuestro).
+ * @param ip4_addr Dirección IPv4 en orden de red (como esp_ip4_addr_t.addr).
+ * @param port Puerto UDP del resolver; 0 usa el 53.
+ */
+void dns_server_set_upstream(uint32_t ip4_addr, uint16_t port);
+
+void dns_server_get_stats(dns_server_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
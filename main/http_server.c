@@ -3,6 +3,20 @@
 #include "wifi_manager.h"
 #include "wifi_provisioning.h"
 #include "system_state.h"
+#include "power_save.h"
+#include "conn_bus.h"
+#include "link_probe.h"
+#include "mem_report.h"
+#include "boot_profile.h"
+#include "task_topology.h"
+#include "portal_parse.h"
+#include "wire_codec.h"
+#include "ota_update.h"
+#include "album_refresh.h"
+#include "scan_policy.h"
+#include "telemetry.h"
+#include "req_arena.h"
+#include "esp_timer.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include <string.h>
@@ -11,8 +25,29 @@
 
 static const char *TAG = "http_server";
 static httpd_handle_t server = NULL;
+static volatile bool portal_enabled = false; // El httpd se crea una vez; suspendido responde 503
+// Cómo llegan los clientes al portal: por la API (opción 114) o disparando sondas de conectividad.
+// Solo las escribe la tarea del httpd.
+static uint32_t capport_api_hits = 0;
+static uint32_t captive_probe_hits = 0;
 
 #define WIFI_SCAN_MAX 15
+#define CONNECT_BODY_MAX 256
+#define HTTPD_TASK_STACK TASK_HTTPD_STACK // La tarea la crea esp_http_server (dinámica); se reporta su high-water mark
+#define OTA_RECV_RETRIES 3                 // Timeouts de socket tolerados por chunk durante la subida
+#define OTA_REBOOT_DELAY_MS 1500
+
+// Buffers por request: de un pool fijo propio del servidor, no del heap ni de la pila del httpd.
+// El httpd atiende de a un request, así que alcanza con una sola arena (solo la toca su tarea).
+#define HTTP_ARENA_SIZE CONFIG_WIFI_MGR_HTTP_ARENA
+static uint32_t arena_pool[HTTP_ARENA_SIZE / sizeof(uint32_t)];
+static req_arena_t arena;
+
+// Handler real de una ruta con arena. Va en user_ctx envuelto en un struct: un puntero a función
+// no se puede convertir a void * en C estándar, un puntero a objeto sí.
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t *req);
+} arena_route_t;
 
 /* =========================
    HTML Captive Portal Page (Template)
@@ -45,7 +80,8 @@ static const char *portal_html_bottom =
 "    j.forEach(n=>{"
 "      let d=document.createElement('div');d.className='net-item';"
 "      let rssiIcon = n.rssi > -60 ? '📶' : '⚠️';"
-"      d.innerHTML='<strong>'+rssiIcon+' '+n.ssid+'</strong> <small>'+n.rssi+' dBm</small>';"
+"      let b=document.createElement('strong');b.textContent=rssiIcon+' '+n.ssid;"
+"      let sm=document.createElement('small');sm.textContent=n.rssi+' dBm';d.append(b,' ',sm);"
 "      d.onclick=()=>{document.getElementById('ssid').value=n.ssid; document.getElementById('pass').focus();};"
 "      list.appendChild(d);"
 "    });"
@@ -55,7 +91,16 @@ static const char *portal_html_bottom =
 "  e.preventDefault();let ssid=document.getElementById('ssid').value;let pass=document.getElementById('pass').value;"
 "  if(!ssid){alert('Por favor, seleccione una red');return;}"
 "  await fetch('/connect',{method:'POST',body:JSON.stringify({ssid,pass})});"
-"  document.body.innerHTML='<h2 style=\"text-align:center\">Conectando...</h2><p style=\"text-align:center\">Intentando unir a la red. Si tiene éxito, este AP se cerrará.</p>';"
+"  document.body.innerHTML='<h2 style=\"text-align:center\">Conectando...</h2><p id=\"st\" style=\"text-align:center\">Probando la red. Este portal sigue activo hasta confirmar la conexión.</p>';"
+"  setTimeout(poll,1000);"
+"}"
+"async function poll(){"
+"  try {"
+"    let j=await (await fetch('/status')).json();"
+"    if(j.test=='ok'){document.getElementById('st').innerHTML='✅ Conectado. IP: '+j.ip+'<br>Este AP se cerrará en unos segundos.';return;}"
+"    if(j.test=='fail'){location.reload();return;}"
+"  } catch(e){}"
+"  setTimeout(poll,1000);"
 "}"
 "</script></body></html>";
 
@@ -72,10 +117,11 @@ static esp_err_t send_portal_html(httpd_req_t *req) {
     httpd_resp_sendstr_chunk(req, portal_html_top);
 
     // CAPTURA DINÁMICA DE ERRORES:
-    uint8_t reason = wifi_manager_get_last_disconnect_reason();
+    uint8_t reason = 0;
+    wifi_prov_test_result_t test = wifi_provisioning_get_test_result(&reason);
 
-    // Capturamos 203 (AUTH_FAIL) y 15 (HANDSHAKE_TIMEOUT)
-    if (reason == WIFI_REASON_AUTH_FAIL || reason == 15) {
+    // Prueba de credenciales fallida (203 AUTH_FAIL, 15 HANDSHAKE_TIMEOUT o timeout sin IP)
+    if (test == WIFI_PROV_TEST_FAILED) {
         ESP_LOGW("HTTP_SERVER", "Inyectando alerta de error en el portal (Razón: %d)", reason);
         
         // Inyectamos el cartel con un estilo rojo llamativo
@@ -97,68 +143,152 @@ static esp_err_t send_portal_html(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// Con el portal suspendido, los endpoints del portal contestan 503 sin tocar nada más
+static bool portal_suspended(httpd_req_t *req) {
+    if (portal_enabled) return false;
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_send(req, NULL, 0);
+    return true;
+}
+
+// Negociación de contenido: el formato binario solo si el cliente lo pide explícitamente
+static bool wants_binary(httpd_req_t *req) {
+    char accept[96] = {0};
+    if (httpd_req_get_hdr_value_len(req, "Accept") == 0) return false;
+    httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)); // Si se trunca, alcanza con el prefijo
+    return strstr(accept, WIRE_CONTENT_TYPE) != NULL;
+}
+
+static esp_err_t send_binary(httpd_req_t *req, const uint8_t *buf, size_t len) {
+    httpd_resp_set_type(req, WIRE_CONTENT_TYPE);
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+    return httpd_resp_send(req, (const char *)buf, len);
+}
+
+// Registrado en lugar del handler real (user_ctx): la arena se vacía apenas termina la respuesta
+static esp_err_t arena_dispatch(httpd_req_t *req) {
+    const arena_route_t *route = req->user_ctx;
+    esp_err_t ret = route->handler(req);
+    req_arena_reset(&arena);
+    return ret;
+}
+
+static esp_err_t send_no_arena(httpd_req_t *req) {
+    ESP_LOGW(TAG, "Arena agotada (%u bytes) en %s", (unsigned)HTTP_ARENA_SIZE, req->uri);
+    return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sin memoria");
+}
+
 /* =========================
    HTTP Handlers
    ========================= */
 
 static esp_err_t portal_handler(httpd_req_t *req) {
-    return send_portal_html(req);
+    if (portal_suspended(req)) return ESP_OK;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t ret = send_portal_html(req);
+    task_topology_record_latency(TASK_LATENCY_HTTP_HANDLER, (uint32_t)(esp_timer_get_time() - t0));
+    return ret;
 }
 
 static esp_err_t captive_handler(httpd_req_t *req) {
+    if (portal_suspended(req)) return ESP_OK;
+    captive_probe_hits++;
     return send_portal_html(req);
 }
 
 static esp_err_t http_404_error_handler(httpd_req_t *req, httpd_err_code_t err) {
+    if (portal_suspended(req)) return ESP_OK;
+    captive_probe_hits++;
     return send_portal_html(req);
 }
 
+/**
+ * API de portal cautivo (RFC 8908). El cliente la conoce por la opción 114 del DHCP y abre
+ * user-portal-url sin sondas. Nunca responde 503: con el portal suspendido, o con la prueba de
+ * credenciales ya exitosa (período de gracia), informa captive=false y el sistema cierra la hoja de login.
+ */
+static esp_err_t capport_api_handler(httpd_req_t *req) {
+    capport_api_hits++;
+    bool captive = portal_enabled && wifi_provisioning_get_test_result(NULL) != WIFI_PROV_TEST_SUCCESS;
+
+    httpd_resp_set_type(req, "application/captive+json");
+    httpd_resp_set_hdr(req, "Cache-Control", "private, no-store");
+    if (!captive) return httpd_resp_sendstr(req, "{\"captive\":false}");
+    return httpd_resp_sendstr(req, "{\"captive\":true,\"user-portal-url\":\"http://192.168.4.1/\"}");
+}
+
 static esp_err_t scan_handler(httpd_req_t *req) {
-    wifi_scan_result_t results[WIFI_SCAN_MAX];
+    if (portal_suspended(req)) return ESP_OK;
+    int64_t t0 = esp_timer_get_time();
+    wifi_scan_result_t *results = req_arena_alloc(&arena, sizeof(wifi_scan_result_t) * WIFI_SCAN_MAX);
+    if (!results) return send_no_arena(req);
     int count = wifi_scanner_get_results(results, WIFI_SCAN_MAX);
-    
-    char *json = malloc(2500); 
-    if (!json) return ESP_FAIL;
 
-    int offset = sprintf(json, "[");
+    if (wants_binary(req)) {
+        const size_t bin_cap = WIRE_HEADER_LEN + 1 + WIFI_SCAN_MAX * WIRE_SCAN_REC_MAX;
+        uint8_t *bin = req_arena_alloc(&arena, bin_cap);
+        if (!bin) return send_no_arena(req);
+        send_binary(req, bin, wire_encode_scan(results, count, bin, bin_cap));
+        task_topology_record_latency(TASK_LATENCY_HTTP_HANDLER, (uint32_t)(esp_timer_get_time() - t0));
+        return ESP_OK;
+    }
+    
+    // Una red por chunk: sin malloc por request ni buffer del peor caso.
+    // El SSID lo elige cualquier vecino: se escapa (peor caso 6 bytes por byte)
+    const size_t esc_cap = sizeof(results[0].ssid) * 6;
+    const size_t item_cap = esc_cap + 48;
+    char *ssid_esc = req_arena_alloc(&arena, esc_cap);
+    char *item = req_arena_alloc(&arena, item_cap);
+    if (!ssid_esc || !item) return send_no_arena(req);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+    httpd_resp_sendstr_chunk(req, "[");
     for (int i = 0; i < count; i++) {
-        offset += snprintf(json + offset, 2500 - offset, 
-            "{\"ssid\":\"%s\",\"rssi\":%d,\"auth\":%d}%s",
-            results[i].ssid, results[i].rssi, results[i].authmode,
+        portal_json_escape((const uint8_t *)results[i].ssid, strnlen(results[i].ssid, sizeof(results[i].ssid)),
+                           ssid_esc, esc_cap);
+        snprintf(item, item_cap, "{\"ssid\":\"%s\",\"rssi\":%d,\"auth\":%d,\"band\":%d}%s",
+            ssid_esc, results[i].rssi, results[i].authmode, results[i].band == SCAN_BAND_5G ? 5 : 2,
             (i < count - 1) ? "," : "");
+        httpd_resp_sendstr_chunk(req, item);
     }
-    sprintf(json + offset, "]");
-
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
-    
-    free(json);
+    httpd_resp_sendstr_chunk(req, "]");
+    httpd_resp_sendstr_chunk(req, NULL);
+    task_topology_record_latency(TASK_LATENCY_HTTP_HANDLER, (uint32_t)(esp_timer_get_time() - t0));
     return ESP_OK;
 }
 
 static esp_err_t connect_handler(httpd_req_t *req) {
-    char buf[256];
-    int len = httpd_req_recv(req, buf, sizeof(buf) - 1);
-    if (len <= 0) return ESP_FAIL;
-    buf[len] = '\0';
+    if (portal_suspended(req)) return ESP_OK;
+    if (req->content_len == 0 || req->content_len >= CONNECT_BODY_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Cuerpo inválido");
+        return ESP_OK;
+    }
+    // SSID: hasta 32 bytes; clave: hasta 63 (passphrase WPA)
+    char *buf = req_arena_alloc(&arena, req->content_len);
+    char *ssid = req_arena_alloc(&arena, WIFI_SSID_MAX_LEN + 1);
+    char *pass = req_arena_alloc(&arena, WIFI_PASS_MAX_LEN);
+    if (!buf || !ssid || !pass) return send_no_arena(req);
 
-    char ssid[64] = {0}, pass[64] = {0};
-    char *s = strstr(buf, "\"ssid\":\"");
-    if (s) { s += 8; sscanf(s, "%63[^\"]", ssid); }
+    // httpd_req_recv puede entregar el cuerpo en varias partes
+    size_t len = 0;
+    while (len < req->content_len) {
+        int r = httpd_req_recv(req, buf + len, req->content_len - len);
+        if (r <= 0) return ESP_FAIL; // Timeout o socket cerrado: no retenemos la tarea httpd
+        len += r;
+    }
 
-    char *p = strstr(buf, "\"pass\":\"");
-    if (p) { p += 8; sscanf(p, "%63[^\"]", pass); }
+    int ssid_len = portal_json_get_string(buf, len, "ssid", ssid, WIFI_SSID_MAX_LEN + 1);
+    int pass_len = portal_json_get_string(buf, len, "pass", pass, WIFI_PASS_MAX_LEN); // "" para redes abiertas
 
-    if (strlen(ssid) > 0) {
-        ESP_LOGI(TAG, "Web: Recibido SSID: %s. Saltando a TRY_STA...", ssid);
+    if (ssid_len > 0 && pass_len >= 0) {
+        ESP_LOGI(TAG, "Web: Recibido SSID: %s. Probando credenciales...", ssid);
         
         // Pasamos credenciales a memoria temporal
         wifi_provisioning_set_credentials(ssid, pass); 
         
+        // El sistema de estados toma las credenciales y pasa a TRY_STA con el portal arriba;
+        // el resultado se consulta por /status.
         httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
-
-        vTaskDelay(pdMS_TO_TICKS(500)); 
-        system_state_set(SYSTEM_STATE_TRY_STA); 
     } else {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Datos inválidos");
     }
@@ -166,10 +296,344 @@ static esp_err_t connect_handler(httpd_req_t *req) {
 }
 
 static esp_err_t status_handler(httpd_req_t *req) {
-    char resp[32];
-    snprintf(resp, sizeof(resp), "{\"state\":%d}", system_state_get());
+    static const char *test_names[] = { "idle", "testing", "ok", "fail" };
+    int64_t t0 = esp_timer_get_time();
+    char resp[96];
+    uint8_t reason = 0;
+    wifi_prov_test_result_t test = wifi_provisioning_get_test_result(&reason);
+    conn_status_t link;
+    conn_bus_get_status(&link); // IP copiada bajo lock: nunca a medio escribir
+
+    if (wants_binary(req)) {
+        wifi_ap_record_t ap;
+        system_state_stats_t flow;
+        conn_bus_stats_t bus;
+        link_probe_stats_t probe;
+        system_state_get_stats(&flow);
+        conn_bus_get_stats(&bus);
+        link_probe_get_stats(&probe);
+        wire_status_src_t src = {
+            .state = system_state_get(),
+            .test = test,
+            .test_reason = reason,
+            .link = &link,
+            .ap = (link.connected && esp_wifi_sta_get_ap_info(&ap) == ESP_OK) ? &ap : NULL,
+            .flow = &flow,
+            .bus = &bus,
+            .probe = &probe,
+            .degraded = link_probe_is_degraded(),
+            .uptime_s = (uint32_t)(esp_timer_get_time() / 1000000),
+            .album_age_ms = wifi_scanner_get_album_age_ms(),
+        };
+        uint8_t bin[WIRE_STATUS_LEN];
+        send_binary(req, bin, wire_encode_status(&src, bin, sizeof(bin)));
+        task_topology_record_latency(TASK_LATENCY_HTTP_HANDLER, (uint32_t)(esp_timer_get_time() - t0));
+        return ESP_OK;
+    }
+
+    snprintf(resp, sizeof(resp), "{\"state\":%d,\"test\":\"%s\",\"reason\":%d,\"ip\":\"%s\"}",
+             system_state_get(), test_names[test], reason, link.ip_str);
     httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Vary", "Accept");
     httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+    task_topology_record_latency(TASK_LATENCY_HTTP_HANDLER, (uint32_t)(esp_timer_get_time() - t0));
+    return ESP_OK;
+}
+
+#ifdef CONFIG_WIFI_MGR_OTA
+
+// Token compartido en X-OTA-Token; sin token configurado no se acepta ninguna subida
+static bool ota_authorized(httpd_req_t *req) {
+    static const char token[] = CONFIG_WIFI_MGR_OTA_TOKEN;
+    char got[65] = {0};
+    size_t len = strlen(token);
+    if (len == 0) return false;
+    if (httpd_req_get_hdr_value_str(req, "X-OTA-Token", got, sizeof(got)) != ESP_OK) return false;
+
+    // Comparación en tiempo constante: no revela cuántos caracteres coinciden
+    size_t n = strlen(got);
+    uint8_t diff = (n != len);
+    for (size_t i = 0; i < len; i++) {
+        diff |= (uint8_t)(token[i] ^ (i < n ? got[i] : 0));
+    }
+    return diff == 0;
+}
+
+// Lee el cuerpo directo a los buffers del pipeline: mientras se recibe uno, ota_writer graba el otro
+static esp_err_t ota_upload_handler(httpd_req_t *req) {
+    if (!ota_authorized(req)) {
+        httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Token inválido");
+        return ESP_OK;
+    }
+    esp_err_t err = ota_update_begin(req->content_len);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "OTA rechazada: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                            err == ESP_ERR_INVALID_STATE ? "Subida en curso" : "Imagen de tamaño inválido");
+        return ESP_OK;
+    }
+
+    size_t remaining = req->content_len;
+    while (remaining > 0) {
+        size_t cap = 0;
+        uint8_t *buf = ota_update_acquire_buffer(&cap);
+        if (!buf) break;
+
+        size_t want = remaining < cap ? remaining : cap;
+        size_t fill = 0;
+        int retries = OTA_RECV_RETRIES;
+        while (fill < want) {
+            int r = httpd_req_recv(req, (char *)buf + fill, want - fill);
+            if (r == HTTPD_SOCK_ERR_TIMEOUT && retries-- > 0) continue;
+            if (r <= 0) break;
+            fill += r;
+        }
+        if (fill < want) {
+            ota_update_release_buffer(buf);
+            break;
+        }
+        if (ota_update_submit(buf, fill) != ESP_OK) break;
+        remaining -= fill;
+    }
+
+    if (remaining > 0) {
+        ota_update_abort();
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Subida interrumpida");
+        return ESP_OK;
+    }
+    if (ota_update_finish() != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Imagen inválida");
+        return ESP_OK;
+    }
+
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"ok\":true,\"bytes\":%lu,\"ms\":%lu,\"kbps\":%lu}",
+             (unsigned long)p.written, (unsigned long)p.elapsed_ms, (unsigned long)p.kbps);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+    ota_update_reboot_later(OTA_REBOOT_DELAY_MS);
+    return ESP_OK;
+}
+
+static esp_err_t ota_progress_handler(httpd_req_t *req) {
+    static const char *state_names[] = { "idle", "receiving", "done", "failed" };
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    char resp[160];
+    snprintf(resp, sizeof(resp),
+             "{\"state\":\"%s\",\"total\":%lu,\"received\":%lu,\"written\":%lu,\"pct\":%lu,\"kbps\":%lu,\"stall_ms\":%lu}",
+             state_names[p.state], (unsigned long)p.total, (unsigned long)p.received, (unsigned long)p.written,
+             (unsigned long)(p.total ? (uint64_t)p.written * 100 / p.total : 0),
+             (unsigned long)p.kbps, (unsigned long)p.stall_ms);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+    return ESP_OK;
+}
+
+#endif // CONFIG_WIFI_MGR_OTA
+
+// Formato texto estilo Prometheus; se envía línea a línea sin buffers grandes ni malloc
+static esp_err_t metrics_handler(httpd_req_t *req) {
+    char line[96];
+    wifi_prov_channel_report_t ch;
+    wifi_provisioning_get_channel_report(&ch);
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    snprintf(line, sizeof(line), "wifi_mgr_softap_channel{source=\"%s\"} %d\n",
+             ch.follows_sta ? "sta" : "album", ch.channel);
+    httpd_resp_sendstr_chunk(req, line);
+    for (int c = 1; c <= WIFI_SCANNER_MAX_24G_CHANNEL; c++) {
+        snprintf(line, sizeof(line), "wifi_mgr_channel_score{channel=\"%d\"} %lu\n", c, (unsigned long)ch.score[c]);
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_channel_aps{channel=\"%d\"} %d\n", c, ch.ap_count[c]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+
+    power_save_stats_t ps;
+    power_save_get_stats(&ps);
+    snprintf(line, sizeof(line), "wifi_mgr_ps_mode %d\nwifi_mgr_ps_switches %lu\n", ps.mode, (unsigned long)ps.switches);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_ps_apsta_ms %llu\n", (unsigned long long)ps.apsta_ms);
+    httpd_resp_sendstr_chunk(req, line);
+    for (int m = 0; m < POWER_SAVE_MODES; m++) {
+        snprintf(line, sizeof(line), "wifi_mgr_ps_time_ms{mode=\"%d\"} %llu\n", m, (unsigned long long)ps.time_in_mode_ms[m]);
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_ps_latency_us_avg{mode=\"%d\"} %lu\n", m,
+                 (unsigned long)(ps.latency_samples[m] ? ps.latency_us_total[m] / ps.latency_samples[m] : 0));
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_ps_latency_us_max{mode=\"%d\"} %lu\n", m, (unsigned long)ps.latency_us_max[m]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+
+    static const char *evt_names[CONN_EVT_MAX] = { "sta_connected", "sta_disconnected", "got_ip", "lost_ip", "sta_start" };
+    conn_bus_stats_t bus;
+    conn_bus_get_stats(&bus);
+    for (int e = 0; e < CONN_EVT_MAX; e++) {
+        snprintf(line, sizeof(line), "wifi_mgr_conn_events{type=\"%s\"} %lu\n", evt_names[e], (unsigned long)bus.published[e]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    snprintf(line, sizeof(line), "wifi_mgr_conn_events_dropped %lu\n", (unsigned long)bus.dropped);
+    httpd_resp_sendstr_chunk(req, line);
+
+    link_probe_stats_t lp;
+    link_probe_get_stats(&lp);
+    snprintf(line, sizeof(line), "wifi_mgr_probe_rtt_us{stat=\"last\"} %lu\nwifi_mgr_probe_rtt_us{stat=\"avg\"} %lu\n",
+             (unsigned long)lp.rtt_us_last, (unsigned long)lp.rtt_us_avg);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_probe_rtt_us{stat=\"min\"} %lu\nwifi_mgr_probe_rtt_us{stat=\"max\"} %lu\n",
+             (unsigned long)lp.rtt_us_min, (unsigned long)lp.rtt_us_max);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_probe_loss_pct %d\nwifi_mgr_probe_degraded %d\n",
+             lp.loss_pct, link_probe_is_degraded() ? 1 : 0);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_probe_lost{target=\"gateway\"} %lu\nwifi_mgr_probe_lost{target=\"tcp\"} %lu\n",
+             (unsigned long)lp.gw_lost, (unsigned long)lp.tcp_lost);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_probe_rounds %lu\nwifi_mgr_probe_degraded_events %lu\n",
+             (unsigned long)lp.rounds, (unsigned long)lp.degraded_events);
+    httpd_resp_sendstr_chunk(req, line);
+
+    system_state_stats_t ss;
+    system_state_get_stats(&ss);
+    for (int st = 0; st < SYSTEM_STATE_COUNT; st++) {
+        snprintf(line, sizeof(line), "wifi_mgr_state_entries{state=\"%d\"} %lu\n", st, (unsigned long)ss.entries[st]);
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_state_time_ms{state=\"%d\"} %llu\n", st, (unsigned long long)ss.time_in_state_ms[st]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    snprintf(line, sizeof(line), "wifi_mgr_state_scans %lu\nwifi_mgr_state_transitions %lu\n",
+             (unsigned long)ss.scans, (unsigned long)ss.transitions);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_time_to_ip_ms{stat=\"last\"} %lu\nwifi_mgr_time_to_ip_ms{stat=\"max\"} %lu\n",
+             (unsigned long)ss.time_to_ip_last_ms, (unsigned long)ss.time_to_ip_max_ms);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_state_input_drops %lu\n", (unsigned long)ss.input_drops);
+    httpd_resp_sendstr_chunk(req, line);
+
+    static const char *lat_names[TASK_LATENCY_COUNT] = { "state_event", "http_handler" };
+    for (int l = 0; l < TASK_LATENCY_COUNT; l++) {
+        task_latency_stats_t lat;
+        task_topology_get_latency(l, &lat);
+        snprintf(line, sizeof(line), "wifi_mgr_latency_us_avg{path=\"%s\"} %lu\n", lat_names[l],
+                 (unsigned long)(lat.samples ? lat.total_us / lat.samples : 0));
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_latency_us_max{path=\"%s\"} %lu\n", lat_names[l], (unsigned long)lat.max_us);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+
+    uint32_t boot_ms[BOOT_PHASE_COUNT];
+    boot_profile_get(boot_ms);
+    for (int p = 0; p < BOOT_PHASE_COUNT; p++) {
+        if (boot_ms[p] == BOOT_PHASE_NOT_REACHED) continue;
+        snprintf(line, sizeof(line), "wifi_mgr_boot_phase_ms{phase=\"%s\"} %lu\n", boot_profile_phase_name(p), (unsigned long)boot_ms[p]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    snprintf(line, sizeof(line), "wifi_mgr_boot_over_budget %d\n", boot_profile_over_budget() ? 1 : 0);
+    httpd_resp_sendstr_chunk(req, line);
+
+    static const char *scan_kinds[WIFI_SCANNER_KIND_COUNT] = { "full_active", "full_passive", "slice", "targeted" };
+    wifi_scanner_radio_stats_t radio;
+    wifi_scanner_get_radio_stats(&radio);
+    for (int k = 0; k < WIFI_SCANNER_KIND_COUNT; k++) {
+        snprintf(line, sizeof(line), "wifi_mgr_scan_radio_ms{kind=\"%s\"} %llu\n", scan_kinds[k], (unsigned long long)radio.radio_ms[k]);
+        httpd_resp_sendstr_chunk(req, line);
+        snprintf(line, sizeof(line), "wifi_mgr_scans{kind=\"%s\"} %lu\n", scan_kinds[k], (unsigned long)radio.scans[k]);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+    wifi_scanner_plan_stats_t plan;
+    wifi_scanner_get_plan_stats(&plan);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_plans %lu\nwifi_mgr_scan_plan_early_stops %lu\n",
+             (unsigned long)plan.plans, (unsigned long)plan.early_stops);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_plan_dfs %lu\nwifi_mgr_scan_plan_steps_skipped %lu\n",
+             (unsigned long)plan.dfs_plans, (unsigned long)plan.steps_skipped);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_plan_ms{stat=\"last\"} %lu\n", (unsigned long)plan.last_ms);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_plan_ms{stat=\"max\"} %lu\n", (unsigned long)plan.max_ms);
+    httpd_resp_sendstr_chunk(req, line);
+    scan_policy_stats_t sp;
+    scan_policy_get_stats(&sp);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_empty %lu\nwifi_mgr_scan_backoff_ms %lu\n",
+             (unsigned long)sp.empty_scans, (unsigned long)sp.wait_ms);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_scan_wakeups %lu\n", (unsigned long)sp.wakeups);
+    httpd_resp_sendstr_chunk(req, line);
+
+    wifi_manager_psk_stats_t psk;
+    wifi_manager_get_psk_stats(&psk);
+    snprintf(line, sizeof(line), "wifi_mgr_psk_stored %d\nwifi_mgr_psk_derive_us %lu\n", psk.psk_stored ? 1 : 0,
+             (unsigned long)psk.derive_us);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_sta_configs{secret=\"psk\"} %lu\n", (unsigned long)psk.connects_psk);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_sta_configs{secret=\"passphrase\"} %lu\n", (unsigned long)psk.connects_passphrase);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_sta_connect_us{secret=\"psk\"} %lu\n", (unsigned long)psk.connect_us_psk);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_sta_connect_us{secret=\"passphrase\"} %lu\n", (unsigned long)psk.connect_us_passphrase);
+    httpd_resp_sendstr_chunk(req, line);
+
+    snprintf(line, sizeof(line), "wifi_mgr_portal_requests{via=\"capport_api\"} %lu\n", (unsigned long)capport_api_hits);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_portal_requests{via=\"probe\"} %lu\n", (unsigned long)captive_probe_hits);
+    httpd_resp_sendstr_chunk(req, line);
+
+    album_refresh_stats_t ar;
+    album_refresh_get_stats(&ar);
+    snprintf(line, sizeof(line), "wifi_mgr_album_age_ms %lu\nwifi_mgr_album_slices %lu\n",
+             (unsigned long)wifi_scanner_get_album_age_ms(), (unsigned long)ar.slices);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_album_slices_deferred %lu\nwifi_mgr_album_rotations %lu\n",
+             (unsigned long)ar.deferred, (unsigned long)ar.rotations);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_album_absence_ms{stat=\"last\"} %lu\n", (unsigned long)ar.absence_ms_last);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_album_absence_ms{stat=\"max\"} %lu\n", (unsigned long)ar.absence_ms_max);
+    httpd_resp_sendstr_chunk(req, line);
+
+    telemetry_stats_t tm;
+    telemetry_get_stats(&tm);
+    snprintf(line, sizeof(line), "wifi_mgr_telemetry_datagrams{result=\"sent\"} %lu\n", (unsigned long)tm.datagrams);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_telemetry_datagrams{result=\"dropped\"} %lu\n", (unsigned long)tm.dropped);
+    httpd_resp_sendstr_chunk(req, line);
+
+    ota_progress_t ota;
+    ota_update_get_progress(&ota);
+    snprintf(line, sizeof(line), "wifi_mgr_ota_state %d\nwifi_mgr_ota_bytes_written %lu\n", ota.state, (unsigned long)ota.written);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_ota_kbps %lu\nwifi_mgr_ota_stall_ms %lu\n", (unsigned long)ota.kbps, (unsigned long)ota.stall_ms);
+    httpd_resp_sendstr_chunk(req, line);
+
+    mem_report_heap_t heap;
+    mem_report_heap(&heap);
+    snprintf(line, sizeof(line), "wifi_mgr_heap_free_bytes %u\nwifi_mgr_heap_largest_block_bytes %u\n",
+             (unsigned)heap.free_bytes, (unsigned)heap.largest_block);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_heap_frag_pct %u\n", heap.frag_pct);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_http_arena_bytes{stat=\"capacity\"} %u\n", (unsigned)arena.cap);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_http_arena_bytes{stat=\"high_water\"} %u\n", (unsigned)arena.high_water);
+    httpd_resp_sendstr_chunk(req, line);
+    snprintf(line, sizeof(line), "wifi_mgr_http_arena_failures %lu\n", (unsigned long)arena.failures);
+    httpd_resp_sendstr_chunk(req, line);
+
+    mem_report_entry_t mem[MEM_REPORT_MAX_ENTRIES];
+    size_t n_mem = mem_report_snapshot(mem, MEM_REPORT_MAX_ENTRIES);
+    for (size_t i = 0; i < n_mem; i++) {
+        snprintf(line, sizeof(line), "wifi_mgr_ram_static_bytes{module=\"%s\"} %u\n", mem[i].module, (unsigned)mem[i].static_bytes);
+        httpd_resp_sendstr_chunk(req, line);
+        if (!mem[i].task) continue;
+        snprintf(line, sizeof(line), "wifi_mgr_stack_free_min_bytes{module=\"%s\"} %lu\n", mem[i].module, (unsigned long)mem[i].stack_free_min);
+        httpd_resp_sendstr_chunk(req, line);
+    }
+
+    httpd_resp_sendstr_chunk(req, NULL);
     return ESP_OK;
 }
 
@@ -177,33 +641,66 @@ static esp_err_t status_handler(httpd_req_t *req) {
    Server Control
    ========================= */
 
-void http_server_start(void) {
+// Crea la instancia una sola vez; el portal puede seguir suspendido
+static void server_create(void) {
     if (server) return;
-    ESP_LOGI(TAG, "Iniciando servidor HTTP...");
+    ESP_LOGI(TAG, "Iniciando servidor HTTP (única vez)...");
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.stack_size = 10240;
+    config.stack_size = HTTPD_TASK_STACK;
+    config.task_priority = TASK_HTTPD_PRIO;
+    config.core_id = TASK_TOPOLOGY_CORE_ID(TASK_HTTPD_CORE);
     config.lru_purge_enable = true;
+    config.max_uri_handlers = 16;
+    req_arena_init(&arena, arena_pool, sizeof(arena_pool));
 
     if (httpd_start(&server, &config) == ESP_OK) {
+        static const arena_route_t scan_route = { .handler = scan_handler };
+        static const arena_route_t connect_route = { .handler = connect_handler };
         httpd_uri_t uri_root = { .uri = "/", .method = HTTP_GET, .handler = portal_handler };
-        httpd_uri_t uri_scan = { .uri = "/scan", .method = HTTP_GET, .handler = scan_handler };
-        httpd_uri_t uri_conn = { .uri = "/connect", .method = HTTP_POST, .handler = connect_handler };
+        httpd_uri_t uri_scan = { .uri = "/scan", .method = HTTP_GET, .handler = arena_dispatch,
+                                 .user_ctx = (void *)&scan_route };
+        httpd_uri_t uri_conn = { .uri = "/connect", .method = HTTP_POST, .handler = arena_dispatch,
+                                 .user_ctx = (void *)&connect_route };
         httpd_uri_t uri_stat = { .uri = "/status", .method = HTTP_GET, .handler = status_handler };
+        httpd_uri_t uri_metrics = { .uri = "/metrics", .method = HTTP_GET, .handler = metrics_handler };
+#ifdef CONFIG_WIFI_MGR_OTA
+        httpd_uri_t uri_ota = { .uri = "/ota", .method = HTTP_POST, .handler = ota_upload_handler };
+        httpd_uri_t uri_ota_progress = { .uri = "/ota", .method = HTTP_GET, .handler = ota_progress_handler };
+#endif
+        httpd_uri_t uri_capport = { .uri = HTTP_CAPPORT_API_PATH, .method = HTTP_GET, .handler = capport_api_handler };
         httpd_uri_t uri_captive = { .uri = "*", .method = HTTP_GET, .handler = captive_handler };
 
         httpd_register_uri_handler(server, &uri_root);
         httpd_register_uri_handler(server, &uri_scan);
         httpd_register_uri_handler(server, &uri_conn);
         httpd_register_uri_handler(server, &uri_stat);
+        httpd_register_uri_handler(server, &uri_metrics);
+#ifdef CONFIG_WIFI_MGR_OTA
+        httpd_register_uri_handler(server, &uri_ota);
+        httpd_register_uri_handler(server, &uri_ota_progress);
+#endif
+        httpd_register_uri_handler(server, &uri_capport);
         httpd_register_uri_handler(server, &uri_captive);
         
         httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, http_404_error_handler);
+        mem_report_register("httpd", xTaskGetHandle("httpd"), HTTPD_TASK_STACK, sizeof(arena_pool));
     }
 }
 
+void http_server_start(void) {
+    portal_enabled = true;
+    server_create();
+}
+
+void http_server_ensure_running(void) {
+    server_create();
+}
+
 void http_server_stop(void) {
-    if (server) {
-        httpd_stop(server);
-        server = NULL;
-    }
+    // No se destruye la instancia (stack, tabla de handlers, socket de escucha): solo se suspende
+    portal_enabled = false;
+}
+
+bool http_server_is_running(void) {
+    return server != NULL && portal_enabled;
 }
\ No newline at end of file
@@ -8,20 +8,30 @@
 extern "C" {
 #endif
 
+/** Ruta de la API de portal cautivo (RFC 8908); la anuncia el DHCP del SoftAP (opción 114, RFC 8910). */
+#define HTTP_CAPPORT_API_PATH "/captive-portal/api"
+
 /**
- * @brief Inicia el servidor HTTP para el portal cautivo.
- * Registra los manejadores para /, /scan, /connect y /status.
+ * @brief Reanuda el portal cautivo. En la primera llamada crea el servidor HTTP
+ * y registra los manejadores para /, /scan, /connect, /status, /metrics, /ota y la API de portal
+ * cautivo. Idempotente.
  */
 void http_server_start(void);
 
 /**
- * @brief Detiene el servidor HTTP y libera sus recursos.
+ * @brief Crea el servidor HTTP si todavía no existe, sin habilitar el portal. Con la estación
+ * conectada quedan atendiendo /status, /metrics y /ota; los endpoints del portal responden 503.
+ */
+void http_server_ensure_running(void);
+
+/**
+ * @brief Suspende el portal: la instancia sigue viva pero los endpoints del portal responden 503.
  */
 void http_server_stop(void);
 
 /**
- * @brief Verifica si el servidor HTTP está actualmente en ejecución.
- * @return true si el servidor está activo, false de lo contrario.
+ * @brief Verifica si el portal HTTP está actualmente atendiendo.
+ * @return true si el servidor existe y no está suspendido, false de lo contrario.
  */
 bool http_server_is_running(void);
 
@@ -1,63 +1,149 @@
 #include "led_status.h"
-#include "driver/gpio.h"
+#include "mem_report.h"
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 
-#define LED_GPIO 2 
+#define LED_GPIO 2
 
-static volatile led_status_t current_status = LED_STATUS_BOOTING;
+// LEDC: el hardware hace los fundidos; nosotros solo encadenamos pasos con un esp_timer one-shot
+#define LED_LEDC_MODE     LEDC_LOW_SPEED_MODE
+#define LED_LEDC_TIMER    LEDC_TIMER_0
+#define LED_LEDC_CHANNEL  LEDC_CHANNEL_0
+#define LED_LEDC_RES      LEDC_TIMER_10_BIT
+#define LED_LEDC_FREQ_HZ  5000
+#define LED_DUTY_MAX      ((1 << LED_LEDC_RES) - 1)
+
+static const char *TAG = "led_status";
+
+/**
+ * Un paso del patrón: llevar el brillo a 'level' (0-100 %) en 'ramp_ms' (0 = salto)
+ * y quedarse 'hold_ms'. Los patrones son tablas constantes en flash.
+ */
+typedef struct {
+    uint8_t level;
+    uint16_t ramp_ms;
+    uint16_t hold_ms;
+} led_step_t;
+
+typedef struct {
+    const led_step_t *steps;
+    uint8_t n_steps;    // 1 paso = patrón fijo, sin timer
+} led_pattern_t;
+
+static const led_step_t steps_off[]        = { {   0,    0,    0 } };
+static const led_step_t steps_booting[]    = { { 100,    0,  500 }, { 0, 0, 500 } };                 // Parpadeo lento
+static const led_step_t steps_scanning[]   = { { 100,    0,  100 }, { 0, 0, 100 },
+                                               { 100,    0,  100 }, { 0, 0, 700 } };               // Dos destellos y pausa
+static const led_step_t steps_connecting[] = { { 100,    0,  250 }, { 0, 0, 250 } };                 // Parpadeo medio
+static const led_step_t steps_connected[]  = { { 100,    0,    0 } };                                // Fijo
+static const led_step_t steps_breath[]     = { {  25,  500,    0 }, { 100, 900, 150 },
+                                               {  25,  900,    0 }, {   0, 500, 400 } };            // Respiración (curva en dos tramos)
+static const led_step_t steps_error[]      = { { 100,    0,  100 }, { 0, 0, 100 },
+                                               { 100,    0,  100 }, { 0, 0, 100 },
+                                               { 100,    0,  100 }, { 0, 0, 1000 } };              // Tres pulsos y pausa larga
+
+#define PATTERN(s) { s, sizeof(s) / sizeof(s[0]) }
+
+static const led_pattern_t patterns[] = {
+    [LED_STATUS_OFF]               = PATTERN(steps_off),
+    [LED_STATUS_BOOTING]           = PATTERN(steps_booting),
+    [LED_STATUS_SCANNING]          = PATTERN(steps_scanning),
+    [LED_STATUS_WIFI_CONNECTING]   = PATTERN(steps_connecting),
+    [LED_STATUS_WIFI_CONNECTED]    = PATTERN(steps_connected),
+    [LED_STATUS_WIFI_DISCONNECTED] = PATTERN(steps_off),
+    [LED_STATUS_PROVISIONING]      = PATTERN(steps_breath),
+    [LED_STATUS_ERROR]             = PATTERN(steps_error),
+};
+
+static esp_timer_handle_t step_timer = NULL;
+static portMUX_TYPE led_lock = portMUX_INITIALIZER_UNLOCKED;
+static led_status_t requested_status = LED_STATUS_BOOTING;
+static led_status_t playing_status = LED_STATUS_OFF;
+static uint8_t step_index = 0;
+
+/* =========================
+   Reproducción
+   ========================= */
+
+// Corre siempre en la tarea de esp_timer: es el único lugar que toca el LEDC
+static void step_cb(void *arg) {
+    taskENTER_CRITICAL(&led_lock);
+    bool changed = (requested_status != playing_status);
+    if (changed) {
+        playing_status = requested_status;
+        step_index = 0;
+    }
+    const led_pattern_t *p = &patterns[playing_status];
+    const led_step_t *step = &p->steps[step_index];
+    step_index = (step_index + 1) % p->n_steps;
+    taskEXIT_CRITICAL(&led_lock);
+
+    uint32_t duty = (uint32_t)step->level * LED_DUTY_MAX / 100;
+    if (changed) ledc_fade_stop(LED_LEDC_MODE, LED_LEDC_CHANNEL); // Un fundido a medias no debe pisar el patrón nuevo
+    if (step->ramp_ms > 0) {
+        ledc_set_fade_time_and_start(LED_LEDC_MODE, LED_LEDC_CHANNEL, duty, step->ramp_ms, LEDC_FADE_NO_WAIT);
+    } else {
+        ledc_set_duty_and_update(LED_LEDC_MODE, LED_LEDC_CHANNEL, duty, 0);
+    }
+
+    uint32_t next_ms = step->ramp_ms + step->hold_ms;
+    if (p->n_steps > 1 && next_ms > 0) {
+        esp_timer_start_once(step_timer, (uint64_t)next_ms * 1000);
+    }
+}
+
+/* =========================
+   API
+   ========================= */
 
 void led_status_init(void) {
-    gpio_reset_pin(LED_GPIO);
-    gpio_set_direction(LED_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_level(LED_GPIO, 0);
+    if (step_timer) return;
+
+    ledc_timer_config_t timer_cfg = {
+        .speed_mode = LED_LEDC_MODE,
+        .duty_resolution = LED_LEDC_RES,
+        .timer_num = LED_LEDC_TIMER,
+        .freq_hz = LED_LEDC_FREQ_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    ledc_channel_config_t ch_cfg = {
+        .gpio_num = LED_GPIO,
+        .speed_mode = LED_LEDC_MODE,
+        .channel = LED_LEDC_CHANNEL,
+        .timer_sel = LED_LEDC_TIMER,
+        .duty = 0,
+    };
+    if (ledc_timer_config(&timer_cfg) != ESP_OK || ledc_channel_config(&ch_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "No se pudo configurar LEDC en GPIO %d", LED_GPIO);
+        return;
+    }
+    ledc_fade_func_install(0);
+
+    const esp_timer_create_args_t args = {
+        .callback = step_cb,
+        .name = "led_step",
+    };
+    if (esp_timer_create(&args, &step_timer) != ESP_OK) return;
+    mem_report_register("led_status", NULL, 0, MEM_REPORT_ESP_TIMER_BYTES); // Los patrones son const (flash)
+    esp_timer_start_once(step_timer, 0);
 }
 
 void led_status_set(led_status_t status) {
-    current_status = status;
-}
+    if ((unsigned)status >= sizeof(patterns) / sizeof(patterns[0])) status = LED_STATUS_OFF;
+
+    taskENTER_CRITICAL(&led_lock);
+    bool same = (status == requested_status);
+    requested_status = status;
+    taskEXIT_CRITICAL(&led_lock);
 
-void led_status_task(void *pvParameters) {
-    while (1) {
-        switch (current_status) {
-            case LED_STATUS_BOOTING:      // Parpadeo lento y constante
-                gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(500));
-                gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(500));
-                break;
-
-            case LED_STATUS_SCANNING:     // Dos destellos rápidos y pausa
-                for(int i=0; i<2; i++){
-                    gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(100));
-                    gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(600));
-                break;
-
-            case LED_STATUS_WIFI_CONNECTING: // Parpadeo rítmico medio
-                gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(250));
-                gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(250));
-                break;
-
-            case LED_STATUS_WIFI_CONNECTED:  // Encendido fijo
-                gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(1000));
-                break;
-
-            case LED_STATUS_PROVISIONING:    // Parpadeo tipo "frenético" (muy rápido)
-                gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(80));
-                gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(80));
-                break;
-
-            case LED_STATUS_ERROR:           // Tres pulsos cortos y pausa larga
-                for(int i=0; i<3; i++){
-                    gpio_set_level(LED_GPIO, 1); vTaskDelay(pdMS_TO_TICKS(100));
-                    gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(100));
-                }
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                break;
-
-            default:
-                gpio_set_level(LED_GPIO, 0); vTaskDelay(pdMS_TO_TICKS(500));
-                break;
-        }
+    // El state machine lo llama en cada vuelta: solo un cambio real reinicia la secuencia
+    if (same || !step_timer) return;
+
+    // Cambio inmediato: cortamos la espera del paso actual (si el callback justo se re-armó, lo reiniciamos)
+    esp_timer_stop(step_timer);
+    if (esp_timer_start_once(step_timer, 0) == ESP_ERR_INVALID_STATE) {
+        esp_timer_restart(step_timer, 0);
     }
-}
\ No newline at end of file
+}
@@ -18,8 +18,15 @@ typedef enum {
     LED_STATUS_ERROR
 } led_status_t;
 
+/**
+ * @brief Configura el LEDC y arranca la reproducción de patrones. No crea tareas:
+ * cada paso lo encadena un esp_timer one-shot y los fundidos los hace el hardware.
+ */
 void led_status_init(void);
-void led_status_task(void *pvParameters);
+
+/**
+ * @brief Cambia el patrón. El cambio se aplica de inmediato; repetir el mismo estado no reinicia la secuencia.
+ */
 void led_status_set(led_status_t status);
 
 #ifdef __cplusplus
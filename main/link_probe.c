@@ -0,0 +1,302 @@
+#include "link_probe.h"
+#include "conn_bus.h"
+#include "power_save.h"
+#include "mem_report.h"
+#include "task_topology.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <lwip/sockets.h>
+
+static const char *TAG = "link_probe";
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static link_probe_stats_t stats = {0};
+static volatile bool degraded = false;
+
+#ifdef CONFIG_WIFI_MGR_LINK_PROBE
+
+#define PROBE_TASK_STACK   TASK_PROBE_STACK
+#define PROBE_QUEUE_LEN    4
+#define PROBE_TIMEOUT_MS   1000
+#define PROBE_ICMP_ID      0x4c50 // "LP"
+#define PROBE_ICMP_LEN     24     // Cabecera (8) + 16 bytes de carga
+#define PROBE_MIN_SAMPLES  8      // Ventana mínima antes de juzgar por porcentaje
+#define PROBE_LOST         (-1)
+
+static StackType_t probe_task_stack[PROBE_TASK_STACK];
+static StaticTask_t probe_task_tcb;
+static StaticQueue_t probe_queue_buf;
+static uint8_t probe_queue_storage[PROBE_QUEUE_LEN * sizeof(conn_event_t)];
+static QueueHandle_t probe_queue = NULL;
+
+// Ventana circular de rondas: RTT en us o PROBE_LOST
+static int32_t window[LINK_PROBE_WINDOW];
+static uint8_t window_head = 0;
+static uint8_t window_count = 0;
+static uint16_t icmp_seq = 0;
+
+/* =========================
+   Ventana RTT / pérdida
+   ========================= */
+
+static void window_reset(void) {
+    window_head = 0;
+    window_count = 0;
+    taskENTER_CRITICAL(&stats_lock);
+    stats.window_samples = 0;
+    stats.loss_pct = 0;
+    stats.consecutive_fail = 0;
+    stats.gw_answers = false;
+    stats.rtt_us_last = stats.rtt_us_avg = stats.rtt_us_min = stats.rtt_us_max = 0;
+    taskEXIT_CRITICAL(&stats_lock);
+    degraded = false;
+}
+
+static void window_push(int32_t rtt_us) {
+    window[window_head] = rtt_us;
+    window_head = (window_head + 1) % LINK_PROBE_WINDOW;
+    if (window_count < LINK_PROBE_WINDOW) window_count++;
+
+    uint32_t lost = 0, ok = 0, min = UINT32_MAX, max = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < window_count; i++) {
+        if (window[i] == PROBE_LOST) { lost++; continue; }
+        uint32_t v = (uint32_t)window[i];
+        ok++;
+        total += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.window_samples = window_count;
+    stats.loss_pct = (uint8_t)(lost * 100 / window_count);
+    stats.consecutive_fail = (rtt_us == PROBE_LOST) ? stats.consecutive_fail + 1 : 0;
+    if (rtt_us != PROBE_LOST) stats.rtt_us_last = (uint32_t)rtt_us;
+    stats.rtt_us_avg = ok ? (uint32_t)(total / ok) : 0;
+    stats.rtt_us_min = ok ? min : 0;
+    stats.rtt_us_max = max;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+// Degradado: varias rondas perdidas seguidas o pérdida sostenida en una ventana suficientemente llena
+static void evaluate(void) {
+    link_probe_stats_t s;
+    link_probe_get_stats(&s);
+    if (degraded) return;
+    if (s.consecutive_fail >= CONFIG_WIFI_MGR_LINK_PROBE_FAIL_ROUNDS ||
+        (s.window_samples >= PROBE_MIN_SAMPLES && s.loss_pct >= CONFIG_WIFI_MGR_LINK_PROBE_LOSS_PCT)) {
+        ESP_LOGW(TAG, "Uplink degradado: %d rondas fallidas seguidas, pérdida %d%% en %d rondas",
+                 s.consecutive_fail, s.loss_pct, s.window_samples);
+        taskENTER_CRITICAL(&stats_lock);
+        stats.degraded_events++;
+        taskEXIT_CRITICAL(&stats_lock);
+        degraded = true;
+    }
+}
+
+/* =========================
+   Sondas
+   ========================= */
+
+static uint16_t icmp_checksum(const uint8_t *data, size_t len) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) sum += (data[i] << 8) | data[i + 1];
+    if (len & 1) sum += data[len - 1] << 8;
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+/**
+ * Echo ICMP al gateway (la primera vez también resuelve su ARP).
+ * @return RTT en us, o PROBE_LOST si no hubo respuesta a tiempo.
+ */
+static int32_t probe_gateway(uint32_t gw_addr) {
+    int sock = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (sock < 0) return PROBE_LOST;
+
+    struct sockaddr_in to = { .sin_family = AF_INET, .sin_addr.s_addr = gw_addr };
+    uint8_t pkt[PROBE_ICMP_LEN] = { 8, 0 }; // Echo request
+    uint16_t seq = ++icmp_seq;
+    pkt[4] = PROBE_ICMP_ID >> 8; pkt[5] = PROBE_ICMP_ID & 0xff;
+    pkt[6] = seq >> 8;           pkt[7] = seq & 0xff;
+    uint16_t ck = icmp_checksum(pkt, sizeof(pkt));
+    pkt[2] = ck >> 8; pkt[3] = ck & 0xff;
+
+    int64_t t0 = esp_timer_get_time();
+    int32_t rtt = PROBE_LOST;
+    if (sendto(sock, pkt, sizeof(pkt), 0, (struct sockaddr *)&to, sizeof(to)) == sizeof(pkt)) {
+        uint8_t buf[64];
+        int64_t deadline = t0 + PROBE_TIMEOUT_MS * 1000LL;
+        int64_t now;
+        while ((now = esp_timer_get_time()) < deadline) {
+            int64_t left = deadline - now;
+            struct timeval tv = { .tv_sec = left / 1000000, .tv_usec = left % 1000000 };
+            fd_set rfds;
+            FD_ZERO(&rfds);
+            FD_SET(sock, &rfds);
+            if (select(sock + 1, &rfds, NULL, NULL, &tv) <= 0) break;
+
+            int len = recv(sock, buf, sizeof(buf), 0);
+            if (len < 20) continue;
+            int ihl = (buf[0] & 0x0f) * 4; // El socket raw entrega también la cabecera IP
+            if (len < ihl + 8) continue;
+            const uint8_t *icmp = &buf[ihl];
+            if (icmp[0] == 0 && ((icmp[4] << 8) | icmp[5]) == PROBE_ICMP_ID && ((icmp[6] << 8) | icmp[7]) == seq) {
+                rtt = (int32_t)(esp_timer_get_time() - t0);
+                break;
+            }
+        }
+    }
+    close(sock);
+    return rtt;
+}
+
+#define PROBE_HAS_TCP (sizeof(CONFIG_WIFI_MGR_LINK_PROBE_TCP_HOST) > 1)
+
+/**
+ * connect() no bloqueante al host configurado: valida DNS + ruta más allá del gateway.
+ * @return Tiempo de handshake en us, o PROBE_LOST.
+ */
+static int32_t probe_tcp(void) {
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(CONFIG_WIFI_MGR_LINK_PROBE_TCP_HOST, NULL, &hints, &res) != 0 || res == NULL) {
+        return PROBE_LOST; // Sin DNS tampoco hay uplink útil
+    }
+    struct sockaddr_in to;
+    memcpy(&to, res->ai_addr, sizeof(to));
+    to.sin_port = htons(CONFIG_WIFI_MGR_LINK_PROBE_TCP_PORT);
+    freeaddrinfo(res);
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) return PROBE_LOST;
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    int64_t t0 = esp_timer_get_time();
+    int32_t rtt = PROBE_LOST;
+    int r = connect(sock, (struct sockaddr *)&to, sizeof(to));
+    if (r == 0) {
+        rtt = (int32_t)(esp_timer_get_time() - t0);
+    } else if (errno == EINPROGRESS) {
+        struct timeval tv = { .tv_sec = PROBE_TIMEOUT_MS / 1000, .tv_usec = (PROBE_TIMEOUT_MS % 1000) * 1000 };
+        fd_set wfds;
+        FD_ZERO(&wfds);
+        FD_SET(sock, &wfds);
+        if (select(sock + 1, NULL, &wfds, NULL, &tv) > 0) {
+            int err = 0;
+            socklen_t elen = sizeof(err);
+            if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &elen) == 0 && err == 0) {
+                rtt = (int32_t)(esp_timer_get_time() - t0);
+            }
+        }
+    }
+    close(sock);
+    return rtt;
+}
+
+/**
+ * Una ronda: echo al gateway y, si hay host configurado, connect TCP.
+ * Un gateway que nunca contestó ICMP (filtrado) no cuenta como pérdida; sin ninguna señal
+ * utilizable la ronda no se registra.
+ */
+static void probe_round(uint32_t gw_addr) {
+    int32_t gw_rtt = probe_gateway(gw_addr);
+    int32_t tcp_rtt = PROBE_LOST;
+    if (PROBE_HAS_TCP) tcp_rtt = probe_tcp();
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.rounds++;
+    stats.gw_sent++;
+    if (gw_rtt == PROBE_LOST) stats.gw_lost++;
+    else stats.gw_answers = true;
+    if (PROBE_HAS_TCP) {
+        stats.tcp_sent++;
+        if (tcp_rtt == PROBE_LOST) stats.tcp_lost++;
+    }
+    bool gw_counts = stats.gw_answers;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (gw_rtt != PROBE_LOST) power_save_record_latency((uint32_t)gw_rtt);
+
+    bool failed = (PROBE_HAS_TCP && tcp_rtt == PROBE_LOST) || (gw_counts && gw_rtt == PROBE_LOST);
+    if (!PROBE_HAS_TCP && !gw_counts) return;
+
+    window_push(failed ? PROBE_LOST : (gw_rtt != PROBE_LOST ? gw_rtt : tcp_rtt));
+    evaluate();
+}
+
+// Contexto del publicador: el veredicto es de la asociación que terminó. Se limpia aquí y no al
+// consumir la cola, para que la tarea de estados no lea un "degradado" viejo tras reconectar.
+static void on_conn_event(const conn_event_t *evt, void *arg) {
+    if (evt->type == CONN_EVT_STA_DISCONNECTED || evt->type == CONN_EVT_LOST_IP || evt->type == CONN_EVT_GOT_IP) {
+        degraded = false;
+    }
+}
+
+static void link_probe_task(void *pvParameters) {
+    uint32_t gw_addr = 0;
+    conn_event_t evt;
+
+    while (1) {
+        TickType_t wait = gw_addr ? pdMS_TO_TICKS(CONFIG_WIFI_MGR_LINK_PROBE_INTERVAL_S * 1000) : portMAX_DELAY;
+        if (xQueueReceive(probe_queue, &evt, wait) == pdTRUE) {
+            if (evt.type == CONN_EVT_GOT_IP) {
+                esp_netif_ip_info_t info = {0};
+                esp_netif_t *sta = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+                gw_addr = (sta && esp_netif_get_ip_info(sta, &info) == ESP_OK) ? info.gw.addr : 0;
+                window_reset();
+                ESP_LOGI(TAG, "Sondeo activo (gateway " IPSTR ")", IP2STR(&info.gw));
+            } else if (evt.type == CONN_EVT_STA_DISCONNECTED || evt.type == CONN_EVT_LOST_IP) {
+                gw_addr = 0; // Sin IP no se sondea
+            }
+            continue;
+        }
+        if (gw_addr) probe_round(gw_addr);
+    }
+}
+
+#endif // CONFIG_WIFI_MGR_LINK_PROBE
+
+/* =========================
+   API
+   ========================= */
+
+void link_probe_init(void) {
+#ifdef CONFIG_WIFI_MGR_LINK_PROBE
+    if (probe_queue) return;
+    probe_queue = xQueueCreateStatic(PROBE_QUEUE_LEN, sizeof(conn_event_t), probe_queue_storage, &probe_queue_buf);
+    conn_bus_subscribe_queue(probe_queue);
+    conn_bus_subscribe_cb(on_conn_event, NULL);
+    // Fast boot: la IP puede haber llegado antes de suscribirnos; se encola un GOT_IP desde la foto
+    conn_status_t st;
+    conn_bus_get_status(&st);
+    if (st.connected) {
+        conn_event_t evt = { .type = CONN_EVT_GOT_IP, .ip = st.ip, .timestamp_us = esp_timer_get_time() };
+        xQueueSend(probe_queue, &evt, 0);
+    }
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(link_probe_task, "link_probe", PROBE_TASK_STACK, NULL, TASK_PROBE_PRIO,
+                                                      probe_task_stack, &probe_task_tcb, TASK_TOPOLOGY_CORE_ID(TASK_PROBE_CORE));
+    mem_report_register("link_probe", task, PROBE_TASK_STACK,
+                        sizeof(probe_task_stack) + sizeof(probe_task_tcb) + sizeof(probe_queue_storage) +
+                        sizeof(probe_queue_buf) + sizeof(window));
+#endif
+}
+
+bool link_probe_is_degraded(void) {
+    return degraded;
+}
+
+void link_probe_get_stats(link_probe_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,49 @@
+#ifndef LINK_PROBE_H
+#define LINK_PROBE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_PROBE_WINDOW 16 // Rondas recordadas para RTT y pérdida
+
+typedef struct {
+    uint32_t rounds;            /**< Rondas de sondeo ejecutadas desde el arranque */
+    uint32_t gw_sent;           /**< Echo ICMP enviados al gateway */
+    uint32_t gw_lost;           /**< Echo sin respuesta a tiempo */
+    uint32_t tcp_sent;          /**< Intentos de connect() al host configurado */
+    uint32_t tcp_lost;          /**< connect() fallidos o vencidos */
+    uint32_t degraded_events;   /**< Veces que se declaró el enlace degradado */
+    uint8_t  window_samples;    /**< Rondas válidas en la ventana actual */
+    uint8_t  loss_pct;          /**< Pérdida en la ventana (0-100) */
+    uint8_t  consecutive_fail;  /**< Rondas fallidas seguidas */
+    bool     gw_answers;        /**< El gateway respondió al menos un echo en esta asociación */
+    uint32_t rtt_us_last;
+    uint32_t rtt_us_avg;        /**< Promedio de la ventana (solo rondas exitosas) */
+    uint32_t rtt_us_min;
+    uint32_t rtt_us_max;
+} link_probe_stats_t;
+
+/**
+ * @brief Crea la tarea de sondeo (memoria estática) y la suscribe a conn_bus.
+ * Sondea solo mientras hay IP; cada GOT_IP reinicia la ventana. Llamar después de conn_bus_init.
+ */
+void link_probe_init(void);
+
+/**
+ * @brief true si el uplink se declaró degradado (pérdida sostenida en la ventana).
+ * El estado CONNECTED lo usa para forzar una re-asociación. Se limpia al publicarse
+ * STA_DISCONNECTED, LOST_IP o GOT_IP (cada asociación empieza sin veredicto).
+ */
+bool link_probe_is_degraded(void);
+
+void link_probe_get_stats(link_probe_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_PROBE_H
@@ -11,6 +11,18 @@
 #include "system_state.h"
 #include "wifi_manager.h"
 #include "wifi_provisioning.h"
+#include "portal_services.h"
+#include "power_save.h"
+#include "conn_bus.h"
+#include "link_probe.h"
+#include "mem_report.h"
+#include "wifi_scanner.h"
+#include "boot_profile.h"
+#include "task_topology.h"
+#include "ota_update.h"
+#include "http_server.h"
+#include "roaming.h"
+#include "telemetry.h"
 
 // Necesario para la línea de interfaz que vamos a agregar
 #include "esp_netif.h"
@@ -19,30 +31,61 @@ static const char *TAG = "MAIN_APP";
 
 void app_main(void)
 {
+    boot_profile_mark(BOOT_PHASE_APP_MAIN);
     ESP_LOGI(TAG, "== ARRANCANDO ESP32 PROVISIONING SYSTEM ==");
 
-    // 1. Capa de Datos: Disco duro (NVS) y Periféricos (LED)
+    // 1. Capa de Datos: Disco duro (NVS). El driver Wi-Fi la necesita para la calibración.
     storage_nvs_init();
-    led_status_init();
+    boot_profile_mark(BOOT_PHASE_NVS_READY);
 
     // 2. Capa de Red: Inicializa Pilas, Eventos, Interfaces (AP/STA) y Driver en modo RAM.
-    // Aquí es donde se silencia el auto-conectado.
+    // El bus de conectividad va antes que cualquier suscriptor.
+    task_topology_init();
+    conn_bus_init();
+    boot_profile_init();
     wifi_manager_init();
+    boot_profile_mark(BOOT_PHASE_WIFI_INIT);
+
+    // La radio arranca ya (calibración y, en fast boot, el primer connect) y el resto del init corre en paralelo
+    wifi_manager_start();
+    boot_profile_mark(BOOT_PHASE_RADIO_START);
 
-    // 3. Capa de Aplicación: Prepara buffers de credenciales y Scanner.
+    // 3. Periféricos y Capa de Aplicación, solapados con el arranque de la radio
+    led_status_init();
+    power_save_init();
+    roaming_init();
+    telemetry_init();
+    link_probe_init();
     wifi_provisioning_init();
-    // wifi_scanner_init(); // Asegúrate de llamar al init del scanner si lo tienes separado
+    portal_services_init();
+    wifi_scanner_init();
+    ota_update_init();
 
-    // 4. Feedback Visual: Lanzamos el LED antes del flujo lógico.
-    xTaskCreate(led_status_task, "led_task", 2048, NULL, 5, NULL);
-    
-    // 5. El Cerebro: Inicia el Flowchart (BOOT -> SCANNING -> ...)
+    // 4. El Cerebro: Inicia el Flowchart (BOOT -> SCANNING -> ...)
     // Importante: No llamar antes de wifi_manager_init.
     system_state_init();
 
     /* BUCLE DE SUPERVISIÓN */
+    bool ram_reported = false;
     while (1) {
-        if (system_state_get() == SYSTEM_STATE_ERROR) {
+        system_state_t state = system_state_get();
+
+        // Imagen recién actualizada: se confirma al llegar a un estado sano; si antes hay un reset, el bootloader vuelve atrás
+        if (state == SYSTEM_STATE_CONNECTED || state == SYSTEM_STATE_PROVISIONING) {
+            ota_update_confirm_running();
+        }
+
+#ifdef CONFIG_WIFI_MGR_OTA
+        // /ota también sin portal. Idempotente: si httpd_start falló, se reintenta en la próxima vuelta conectada
+        if (state == SYSTEM_STATE_CONNECTED) http_server_ensure_running();
+#endif
+
+        // Reporte de RAM una vez por arranque, al llegar a CONNECTED (las pilas ya pasaron por su peor camino conocido)
+        if (!ram_reported && state == SYSTEM_STATE_CONNECTED) {
+            mem_report_log();
+            ram_reported = true;
+        }
+        if (state == SYSTEM_STATE_ERROR) {
             ESP_LOGE(TAG, "Estado de ERROR crítico. Reiniciando en 5s...");
             vTaskDelay(pdMS_TO_TICKS(5000));
             esp_restart();
@@ -0,0 +1,75 @@
+#include "mem_report.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "mem_report";
+
+#define MEM_STACK_MARGIN 512 // Margen sobre el uso pico al sugerir el tamaño de pila
+
+static portMUX_TYPE report_lock = portMUX_INITIALIZER_UNLOCKED;
+static mem_report_entry_t entries[MEM_REPORT_MAX_ENTRIES];
+static size_t n_entries = 0;
+
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes) {
+    bool ok = false;
+    taskENTER_CRITICAL(&report_lock);
+    if (n_entries < MEM_REPORT_MAX_ENTRIES) {
+        entries[n_entries].module = module;
+        entries[n_entries].task = task;
+        entries[n_entries].stack_bytes = stack_bytes;
+        entries[n_entries].stack_free_min = stack_bytes;
+        entries[n_entries].static_bytes = static_bytes;
+        n_entries++;
+        ok = true;
+    }
+    taskEXIT_CRITICAL(&report_lock);
+    if (!ok) ESP_LOGW(TAG, "Tabla llena, '%s' no se reporta", module);
+}
+
+size_t mem_report_snapshot(mem_report_entry_t *out, size_t max) {
+    if (!out) return 0;
+    taskENTER_CRITICAL(&report_lock);
+    size_t n = (n_entries < max) ? n_entries : max;
+    memcpy(out, entries, n * sizeof(mem_report_entry_t));
+    taskEXIT_CRITICAL(&report_lock);
+
+    // El high-water mark se lee fuera del lock (recorre la pila de la tarea)
+    for (size_t i = 0; i < n; i++) {
+        if (out[i].task) out[i].stack_free_min = uxTaskGetStackHighWaterMark(out[i].task);
+    }
+    return n;
+}
+
+void mem_report_heap(mem_report_heap_t *out) {
+    if (!out) return;
+    out->free_bytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    out->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    out->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    out->frag_pct = (out->free_bytes > 0) ? (uint8_t)(100 - out->largest_block * 100 / out->free_bytes) : 0;
+}
+
+void mem_report_log(void) {
+    mem_report_entry_t snap[MEM_REPORT_MAX_ENTRIES];
+    size_t n = mem_report_snapshot(snap, MEM_REPORT_MAX_ENTRIES);
+    size_t total_static = 0, total_stack = 0;
+
+    ESP_LOGI(TAG, "%-14s %8s %8s %8s %10s", "modulo", "estatico", "pila", "pico", "sugerida");
+    for (size_t i = 0; i < n; i++) {
+        total_static += snap[i].static_bytes;
+        if (snap[i].task == NULL) {
+            ESP_LOGI(TAG, "%-14s %8u %8s %8s %10s", snap[i].module, (unsigned)snap[i].static_bytes, "-", "-", "-");
+            continue;
+        }
+        total_stack += snap[i].stack_bytes;
+        uint32_t used = snap[i].stack_bytes - snap[i].stack_free_min;
+        ESP_LOGI(TAG, "%-14s %8u %8lu %8lu %10lu", snap[i].module, (unsigned)snap[i].static_bytes,
+                 (unsigned long)snap[i].stack_bytes, (unsigned long)used, (unsigned long)(used + MEM_STACK_MARGIN));
+    }
+    ESP_LOGI(TAG, "Total: %u bytes estáticos, %u bytes de pila reservada",
+             (unsigned)total_static, (unsigned)total_stack);
+    mem_report_heap_t heap;
+    mem_report_heap(&heap);
+    ESP_LOGI(TAG, "Heap interno: libre %u, mínimo histórico %u, bloque mayor %u (fragmentación %u %%)",
+             (unsigned)heap.free_bytes, (unsigned)heap.min_free, (unsigned)heap.largest_block, heap.frag_pct);
+}
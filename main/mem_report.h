@@ -0,0 +1,67 @@
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_REPORT_MAX_ENTRIES 16
+
+// Los esp_timer se crean en el heap: struct esp_timer más la cabecera del bloque (aprox.)
+#define MEM_REPORT_ESP_TIMER_BYTES 48
+
+/**
+ * @brief Huella de RAM de un módulo. En ESP-IDF la pila se mide en bytes.
+ */
+typedef struct {
+    const char *module;
+    TaskHandle_t task;          /**< NULL si el módulo no tiene tarea propia */
+    uint32_t stack_bytes;       /**< Pila reservada para la tarea */
+    uint32_t stack_free_min;    /**< High-water mark: lo que nunca se llegó a usar */
+    size_t static_bytes;        /**< .bss/.data propios (pila estática incluida) */
+} mem_report_entry_t;
+
+/**
+ * @brief Registra la memoria de un módulo. Cada módulo lo llama una vez, en su init.
+ * @param task Tarea del módulo (NULL si no tiene); se usa para leer el high-water mark.
+ * @param stack_bytes Pila reservada para la tarea (0 sin tarea).
+ * @param static_bytes Buffers estáticos del módulo (sizeof de sus arrays, TCB y pila estática), más los
+ *        objetos que crea una sola vez en el heap (n * MEM_REPORT_ESP_TIMER_BYTES por timer).
+ */
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes);
+
+/**
+ * @brief Copia las entradas con el high-water mark actualizado.
+ * @return Cantidad de entradas copiadas.
+ */
+size_t mem_report_snapshot(mem_report_entry_t *out, size_t max);
+
+/**
+ * @brief Estado del heap interno. La fragmentación es la parte del heap libre que no está en
+ * el bloque mayor: 0 % = todo contiguo; cerca de 100 % = hay memoria pero en pedazos chicos.
+ */
+typedef struct {
+    size_t free_bytes;
+    size_t largest_block;
+    size_t min_free;            /**< Mínimo histórico */
+    uint8_t frag_pct;
+} mem_report_heap_t;
+
+void mem_report_heap(mem_report_heap_t *out);
+
+/**
+ * @brief Imprime por log la tabla por módulo, los totales y el estado del heap,
+ * con la pila sugerida (uso pico + margen) para cada tarea.
+ */
+void mem_report_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_REPORT_H
@@ -0,0 +1,293 @@
+#include "ota_update.h"
+#include "mem_report.h"
+#include "task_topology.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "ota_update";
+
+static portMUX_TYPE progress_lock = portMUX_INITIALIZER_UNLOCKED;
+static ota_progress_t progress = { .state = OTA_STATE_IDLE };
+
+#ifdef CONFIG_WIFI_MGR_OTA
+
+#define OTA_CHUNK          CONFIG_WIFI_MGR_OTA_CHUNK
+#define OTA_BUFFERS        2
+#define OTA_TASK_STACK     TASK_OTA_STACK
+#define OTA_BUFFER_WAIT_MS 10000 // Más que el peor borrado de sector encadenado
+
+// Un chunk con buf == NULL marca el fin del pipeline. 'session' descarta lo que quedó de una subida anterior.
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    uint32_t session;
+} ota_chunk_t;
+
+static uint8_t chunk_bufs[OTA_BUFFERS][OTA_CHUNK];
+
+static StackType_t writer_stack[OTA_TASK_STACK];
+static StaticTask_t writer_tcb;
+static StaticQueue_t free_q_buf, full_q_buf;
+static uint8_t free_q_storage[OTA_BUFFERS * sizeof(uint8_t *)];
+static uint8_t full_q_storage[OTA_BUFFERS * sizeof(ota_chunk_t)];
+static QueueHandle_t free_q = NULL;   // Buffers libres para recibir
+static QueueHandle_t full_q = NULL;   // Buffers llenos para grabar
+static StaticSemaphore_t flushed_buf;
+static SemaphoreHandle_t flushed = NULL;
+
+static esp_ota_handle_t ota_handle = 0;
+static const esp_partition_t *target = NULL;
+static volatile esp_err_t write_err = ESP_OK;
+static volatile uint32_t session = 0; // Se incrementa en cada begin
+static int64_t start_us = 0;
+static uint8_t last_decile = 0;
+static esp_timer_handle_t reboot_timer = NULL;
+
+/* =========================
+   Tarea de escritura
+   ========================= */
+
+// Un chunk de la cola: lo graba (si la sesión sigue viva y sin error) y devuelve el buffer
+static void writer_step(const ota_chunk_t *chunk) {
+    bool current = (chunk->session == session);
+    if (chunk->buf == NULL) {
+        if (current) xSemaphoreGive(flushed); // Todo lo anterior ya está en flash
+        return;
+    }
+
+    if (current && write_err == ESP_OK) {
+        esp_err_t err = esp_ota_write(ota_handle, chunk->buf, chunk->len);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_write: %s", esp_err_to_name(err));
+            write_err = err;
+        }
+        taskENTER_CRITICAL(&progress_lock);
+        if (err == ESP_OK) progress.written += chunk->len;
+        uint8_t decile = progress.total ? (uint8_t)((uint64_t)progress.written * 10 / progress.total) : 0;
+        uint32_t written = progress.written;
+        taskEXIT_CRITICAL(&progress_lock);
+
+        if (decile != last_decile) {
+            last_decile = decile;
+            ESP_LOGI(TAG, "Grabado %u%% (%lu bytes)", decile * 10, (unsigned long)written);
+        }
+    }
+    uint8_t *buf = chunk->buf;
+    xQueueSend(free_q, &buf, portMAX_DELAY);
+}
+
+static void ota_writer_task(void *arg) {
+    ota_chunk_t chunk;
+    while (1) {
+        xQueueReceive(full_q, &chunk, portMAX_DELAY);
+        writer_step(&chunk);
+    }
+}
+
+// Espera a que la tarea de escritura consuma todo lo encolado
+static bool pipeline_drain(void) {
+    ota_chunk_t end = { .buf = NULL, .len = 0, .session = session };
+    xQueueSend(full_q, &end, portMAX_DELAY);
+    return xSemaphoreTake(flushed, pdMS_TO_TICKS(OTA_BUFFER_WAIT_MS)) == pdTRUE;
+}
+
+static void set_finished(ota_state_t state, esp_err_t err) {
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    taskENTER_CRITICAL(&progress_lock);
+    progress.state = state;
+    progress.last_err = err;
+    progress.elapsed_ms = elapsed_ms;
+    progress.kbps = elapsed_ms ? (uint32_t)((uint64_t)progress.written * 1000 / 1024 / elapsed_ms) : 0;
+    taskEXIT_CRITICAL(&progress_lock);
+}
+
+static void reboot_cb(void *arg) {
+    esp_restart();
+}
+
+#endif // CONFIG_WIFI_MGR_OTA
+
+/* =========================
+   API
+   ========================= */
+
+void ota_update_init(void) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (full_q) return;
+    free_q = xQueueCreateStatic(OTA_BUFFERS, sizeof(uint8_t *), free_q_storage, &free_q_buf);
+    full_q = xQueueCreateStatic(OTA_BUFFERS, sizeof(ota_chunk_t), full_q_storage, &full_q_buf);
+    flushed = xSemaphoreCreateBinaryStatic(&flushed_buf);
+    for (int i = 0; i < OTA_BUFFERS; i++) {
+        uint8_t *b = chunk_bufs[i];
+        xQueueSend(free_q, &b, 0);
+    }
+
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(ota_writer_task, "ota_writer", OTA_TASK_STACK, NULL, TASK_OTA_PRIO,
+                                                      writer_stack, &writer_tcb, TASK_TOPOLOGY_CORE_ID(TASK_OTA_CORE));
+    mem_report_register("ota_update", task, OTA_TASK_STACK,
+                        sizeof(chunk_bufs) + sizeof(writer_stack) + sizeof(writer_tcb) +
+                        sizeof(free_q_storage) + sizeof(full_q_storage));
+
+    const esp_partition_t *invalid = esp_ota_get_last_invalid_partition();
+    if (invalid) ESP_LOGW(TAG, "La imagen de '%s' no se confirmó: se volvió a la anterior (rollback)", invalid->label);
+    ESP_LOGI(TAG, "Ejecutando desde '%s'", esp_ota_get_running_partition()->label);
+#endif
+}
+
+esp_err_t ota_update_begin(size_t image_size) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (!full_q) return ESP_ERR_INVALID_STATE;
+    taskENTER_CRITICAL(&progress_lock);
+    bool busy = (progress.state == OTA_STATE_RECEIVING);
+    taskEXIT_CRITICAL(&progress_lock);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    target = esp_ota_get_next_update_partition(NULL);
+    if (!target) return ESP_ERR_NOT_FOUND;
+    if (image_size == 0 || image_size > target->size) return ESP_ERR_INVALID_SIZE;
+
+    // Borrado sector a sector sobre la marcha: no bloquea varios segundos antes del primer chunk
+    esp_err_t err = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
+    if (err != ESP_OK) return err;
+
+    // Un give tardío de una sesión anterior (drain vencido) adelantaría el drain de esta; sus chunks
+    // todavía encolados se descartan por el número de sesión
+    xSemaphoreTake(flushed, 0);
+    session++;
+    write_err = ESP_OK;
+    last_decile = 0;
+    start_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&progress_lock);
+    memset(&progress, 0, sizeof(progress));
+    progress.state = OTA_STATE_RECEIVING;
+    progress.total = (uint32_t)image_size;
+    taskEXIT_CRITICAL(&progress_lock);
+
+    ESP_LOGI(TAG, "Recibiendo imagen de %u bytes hacia '%s'", (unsigned)image_size, target->label);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint8_t *ota_update_acquire_buffer(size_t *cap) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    uint8_t *buf = NULL;
+    if (write_err != ESP_OK) return NULL;
+
+    int64_t t0 = esp_timer_get_time();
+    if (xQueueReceive(free_q, &buf, pdMS_TO_TICKS(OTA_BUFFER_WAIT_MS)) != pdTRUE) return NULL;
+    uint32_t waited_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+    taskENTER_CRITICAL(&progress_lock);
+    progress.stall_ms += waited_ms;
+    taskEXIT_CRITICAL(&progress_lock);
+    if (cap) *cap = OTA_CHUNK;
+    return buf;
+#else
+    return NULL;
+#endif
+}
+
+esp_err_t ota_update_submit(uint8_t *buf, size_t len) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    ota_chunk_t chunk = { .buf = buf, .len = len, .session = session };
+    taskENTER_CRITICAL(&progress_lock);
+    progress.received += len;
+    taskEXIT_CRITICAL(&progress_lock);
+    xQueueSend(full_q, &chunk, portMAX_DELAY); // Nunca bloquea: hay tantos lugares como buffers
+    return write_err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void ota_update_release_buffer(uint8_t *buf) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (buf) xQueueSend(free_q, &buf, 0);
+#endif
+}
+
+esp_err_t ota_update_finish(void) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    esp_err_t err = pipeline_drain() ? write_err : ESP_ERR_TIMEOUT;
+    if (err != ESP_OK) {
+        write_err = err; // Con el drain vencido, la tarea ya no graba sobre el handle abortado
+        esp_ota_abort(ota_handle);
+        set_finished(OTA_STATE_FAILED, err);
+        return err;
+    }
+
+    // esp_ota_end valida la imagen (cabecera, checksum y SHA-256; firma con secure boot)
+    err = esp_ota_end(ota_handle);
+    if (err == ESP_OK) err = esp_ota_set_boot_partition(target);
+    set_finished(err == ESP_OK ? OTA_STATE_DONE : OTA_STATE_FAILED, err);
+
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Imagen lista en '%s': %lu bytes en %lu ms (%lu KB/s, %lu ms esperando a la flash)",
+                 target->label, (unsigned long)p.written, (unsigned long)p.elapsed_ms,
+                 (unsigned long)p.kbps, (unsigned long)p.stall_ms);
+    } else {
+        ESP_LOGE(TAG, "Imagen rechazada: %s", esp_err_to_name(err));
+    }
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void ota_update_abort(void) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (!pipeline_drain() && write_err == ESP_OK) write_err = ESP_ERR_TIMEOUT;
+    esp_ota_abort(ota_handle);
+    set_finished(OTA_STATE_FAILED, write_err != ESP_OK ? write_err : ESP_FAIL);
+    ESP_LOGW(TAG, "Subida abortada");
+#endif
+}
+
+void ota_update_reboot_later(uint32_t delay_ms) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (!reboot_timer) {
+        const esp_timer_create_args_t args = { .callback = reboot_cb, .name = "ota_reboot" };
+        if (esp_timer_create(&args, &reboot_timer) != ESP_OK) {
+            esp_restart();
+            return;
+        }
+    }
+    ESP_LOGI(TAG, "Reiniciando en %lu ms con la imagen nueva", (unsigned long)delay_ms);
+    esp_timer_start_once(reboot_timer, (uint64_t)delay_ms * 1000);
+#endif
+}
+
+void ota_update_confirm_running(void) {
+#ifdef CONFIG_WIFI_MGR_OTA
+    esp_ota_img_states_t state;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        ESP_LOGI(TAG, "Imagen de '%s' confirmada: rollback cancelado", running->label);
+    }
+#endif
+}
+
+void ota_update_get_progress(ota_progress_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&progress_lock);
+    memcpy(out, &progress, sizeof(progress));
+    taskEXIT_CRITICAL(&progress_lock);
+#ifdef CONFIG_WIFI_MGR_OTA
+    if (out->state == OTA_STATE_RECEIVING) {
+        out->elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+        out->kbps = out->elapsed_ms ? (uint32_t)((uint64_t)out->written * 1000 / 1024 / out->elapsed_ms) : 0;
+    }
+#endif
+}
@@ -0,0 +1,91 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Actualización de firmware en streaming. Pipeline de dos buffers: mientras la tarea httpd llena
+ * uno desde el socket, la tarea ota_writer graba el otro en la partición OTA siguiente.
+ * Uso: begin -> (acquire_buffer, recv, submit)* -> finish | abort. Una sola subida a la vez.
+ */
+
+typedef enum {
+    OTA_STATE_IDLE = 0,
+    OTA_STATE_RECEIVING,
+    OTA_STATE_DONE,         /**< Imagen validada y marcada para el próximo arranque */
+    OTA_STATE_FAILED
+} ota_state_t;
+
+typedef struct {
+    ota_state_t state;
+    uint32_t total;         /**< Largo de la imagen (Content-Length) */
+    uint32_t received;      /**< Bytes entregados por la tarea httpd */
+    uint32_t written;       /**< Bytes ya grabados en flash */
+    uint32_t elapsed_ms;    /**< Desde begin (o duración total si terminó) */
+    uint32_t kbps;          /**< Throughput extremo a extremo, KB/s */
+    uint32_t stall_ms;      /**< Tiempo que la recepción esperó a la flash (ambos buffers ocupados) */
+    esp_err_t last_err;
+} ota_progress_t;
+
+/**
+ * @brief Crea la tarea de escritura y los buffers (estáticos). Informa si el arranque anterior
+ * terminó en rollback.
+ */
+void ota_update_init(void);
+
+/**
+ * @brief Abre la partición OTA siguiente para una imagen de 'image_size' bytes.
+ * @return ESP_ERR_INVALID_STATE si ya hay una subida en curso, ESP_ERR_INVALID_SIZE si no entra.
+ */
+esp_err_t ota_update_begin(size_t image_size);
+
+/**
+ * @brief Toma un buffer libre para recibir (espera si la flash va atrás).
+ * @param cap Capacidad del buffer.
+ * @return NULL si la escritura falló o venció la espera.
+ */
+uint8_t *ota_update_acquire_buffer(size_t *cap);
+
+/**
+ * @brief Entrega 'len' bytes del buffer a la tarea de escritura (el buffer vuelve a estar libre al grabarse).
+ * @return Error pegajoso de la escritura anterior, si lo hubo.
+ */
+esp_err_t ota_update_submit(uint8_t *buf, size_t len);
+
+/**
+ * @brief Devuelve un buffer sin datos (recepción abortada).
+ */
+void ota_update_release_buffer(uint8_t *buf);
+
+/**
+ * @brief Vacía el pipeline, valida la imagen y la marca como partición de arranque.
+ */
+esp_err_t ota_update_finish(void);
+
+void ota_update_abort(void);
+
+/**
+ * @brief Reinicia el equipo tras 'delay_ms' (deja salir la respuesta HTTP).
+ */
+void ota_update_reboot_later(uint32_t delay_ms);
+
+/**
+ * @brief Si la imagen en ejecución está a prueba (recién actualizada), la confirma y cancela el rollback.
+ * Se llama cuando el sistema llega a un estado sano (CONNECTED o portal arriba).
+ */
+void ota_update_confirm_running(void);
+
+void ota_update_get_progress(ota_progress_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_UPDATE_H
@@ -0,0 +1,174 @@
+#include "portal_parse.h"
+#include <string.h>
+#include <stdbool.h>
+
+/* =========================
+   Lectura
+   ========================= */
+
+static size_t skip_ws(const char *s, size_t len, size_t i) {
+    while (i < len && (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) i++;
+    return i;
+}
+
+static int hex_val(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * Decodifica el string que empieza en s[i] == '"'. Con out == NULL solo lo valida y lo salta.
+ * Retorna el índice siguiente a la comilla de cierre, o 0 si es inválido o no entra en 'cap'.
+ */
+static size_t parse_string(const char *s, size_t len, size_t i, char *out, size_t cap, size_t *out_len) {
+    size_t n = 0;
+    if (i >= len || s[i] != '"') return 0;
+    i++;
+
+    while (i < len) {
+        uint8_t c = (uint8_t)s[i++];
+        uint8_t utf8[3];
+        size_t w = 1;
+
+        if (c == '"') {
+            if (out) out[n] = '\0';
+            if (out_len) *out_len = n;
+            return i;
+        }
+        if (c < 0x20) return 0; // Control crudo: JSON inválido
+        utf8[0] = c;
+
+        if (c == '\\') {
+            if (i >= len) return 0;
+            char e = s[i++];
+            switch (e) {
+                case '"': case '\\': case '/': utf8[0] = (uint8_t)e; break;
+                case 'b': utf8[0] = '\b'; break;
+                case 'f': utf8[0] = '\f'; break;
+                case 'n': utf8[0] = '\n'; break;
+                case 'r': utf8[0] = '\r'; break;
+                case 't': utf8[0] = '\t'; break;
+                case 'u': {
+                    if (len - i < 4) return 0;
+                    uint32_t cp = 0;
+                    for (int k = 0; k < 4; k++) {
+                        int h = hex_val(s[i++]);
+                        if (h < 0) return 0;
+                        cp = (cp << 4) | (uint32_t)h;
+                    }
+                    if (cp == 0 || (cp >= 0xd800 && cp <= 0xdfff)) return 0; // NUL o surrogate
+                    if (cp < 0x80) {
+                        utf8[0] = (uint8_t)cp;
+                    } else if (cp < 0x800) {
+                        utf8[0] = 0xc0 | (cp >> 6);
+                        utf8[1] = 0x80 | (cp & 0x3f);
+                        w = 2;
+                    } else {
+                        utf8[0] = 0xe0 | (cp >> 12);
+                        utf8[1] = 0x80 | ((cp >> 6) & 0x3f);
+                        utf8[2] = 0x80 | (cp & 0x3f);
+                        w = 3;
+                    }
+                    break;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+        if (out) {
+            if (n + w >= cap) return 0; // Siempre queda lugar para el '\0'
+            memcpy(&out[n], utf8, w);
+        }
+        n += w;
+    }
+    return 0; // Sin comilla de cierre
+}
+
+// Salta un valor escalar (string, número, true/false/null). Anidados no se aceptan.
+static size_t skip_value(const char *s, size_t len, size_t i) {
+    if (i >= len) return 0;
+    if (s[i] == '"') return parse_string(s, len, i, NULL, 0, NULL);
+    size_t start = i;
+    while (i < len && (s[i] == '-' || s[i] == '+' || s[i] == '.' ||
+                       (s[i] >= '0' && s[i] <= '9') || (s[i] >= 'a' && s[i] <= 'z') || (s[i] >= 'A' && s[i] <= 'Z'))) {
+        i++;
+    }
+    return (i > start) ? i : 0;
+}
+
+int portal_json_get_string(const char *json, size_t len, const char *key, char *out, size_t cap) {
+    if (!json || !key || !out || cap == 0) return -1;
+    size_t key_len = strlen(key);
+    char name[32];
+    size_t name_len;
+
+    size_t i = skip_ws(json, len, 0);
+    if (i >= len || json[i] != '{') return -1;
+    i = skip_ws(json, len, i + 1);
+    if (i < len && json[i] == '}') return -1; // Objeto vacío
+
+    while (i < len) {
+        // Clave (las más largas que 'name' no pueden ser la buscada: se validan y se saltan)
+        size_t next = parse_string(json, len, i, name, sizeof(name), &name_len);
+        bool match = (next != 0 && name_len == key_len && memcmp(name, key, key_len) == 0);
+        if (next == 0) next = parse_string(json, len, i, NULL, 0, NULL);
+        if (next == 0) return -1;
+
+        i = skip_ws(json, len, next);
+        if (i >= len || json[i] != ':') return -1;
+        i = skip_ws(json, len, i + 1);
+
+        if (match) {
+            size_t out_len;
+            if (parse_string(json, len, i, out, cap, &out_len) == 0) return -1;
+            return (int)out_len;
+        }
+
+        next = skip_value(json, len, i);
+        if (next == 0) return -1;
+        i = skip_ws(json, len, next);
+        if (i >= len) return -1;
+        if (json[i] == '}') return -1; // Fin del objeto sin la clave
+        if (json[i] != ',') return -1;
+        i = skip_ws(json, len, i + 1);
+    }
+    return -1;
+}
+
+/* =========================
+   Escritura
+   ========================= */
+
+size_t portal_json_escape(const uint8_t *in, size_t in_len, char *out, size_t cap) {
+    static const char hex[] = "0123456789abcdef";
+    size_t n = 0;
+    if (!out || cap == 0) return 0;
+
+    for (size_t i = 0; i < in_len; i++) {
+        uint8_t c = in[i];
+        char esc[6];
+        size_t w;
+
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\'; esc[1] = (char)c; w = 2;
+        } else if (c < 0x20 || c == 0x7f) {
+            esc[0] = '\\'; esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+            esc[4] = hex[c >> 4]; esc[5] = hex[c & 0x0f]; w = 6;
+        } else if (c == '<' || c == '>') {
+            // Por si el valor termina dentro de HTML: "<" es JSON válido y nunca abre una etiqueta
+            esc[0] = '\\'; esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+            esc[4] = hex[c >> 4]; esc[5] = hex[c & 0x0f]; w = 6;
+        } else {
+            esc[0] = (char)c; w = 1;
+        }
+
+        if (n + w >= cap) break;
+        memcpy(&out[n], esc, w);
+        n += w;
+    }
+    out[n] = '\0';
+    return n;
+}
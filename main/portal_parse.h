@@ -0,0 +1,36 @@
+#ifndef PORTAL_PARSE_H
+#define PORTAL_PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parsers de los datos no confiables del portal (cuerpo de /connect, SSIDs vecinos en /scan).
+ * Módulo puro, sin ESP-IDF: se puede compilar en el host para fuzzing y micro-benchmarks.
+ */
+
+/**
+ * @brief Extrae el valor string de 'key' en un objeto JSON plano ({"k":"v",...}).
+ * Decodifica los escapes (\" \\ \/ \b \f \n \r \t \uXXXX a UTF-8). Respeta 'len': el cuerpo no necesita terminar en '\0'.
+ * Objetos o arrays anidados, caracteres de control crudos y surrogates se rechazan.
+ * @return Largo decodificado (out queda terminado en '\0'), o -1 si falta la clave, el JSON es inválido
+ *         o el valor no entra en 'cap'.
+ */
+int portal_json_get_string(const char *json, size_t len, const char *key, char *out, size_t cap);
+
+/**
+ * @brief Escapa bytes arbitrarios (p. ej. un SSID) para insertarlos entre comillas en un JSON.
+ * Comillas, barras y caracteres de control se escapan; nunca corta una secuencia de escape a la mitad.
+ * @return Bytes escritos en 'out' (sin contar el '\0' final).
+ */
+size_t portal_json_escape(const uint8_t *in, size_t in_len, char *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PORTAL_PARSE_H
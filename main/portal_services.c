@@ -0,0 +1,70 @@
+#include "portal_services.h"
+#include "http_server.h"
+#include "dns_server.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "portal_services";
+
+static SemaphoreHandle_t lock = NULL;
+static StaticSemaphore_t lock_buf;
+static uint32_t owners = 0;
+static portal_services_stats_t stats = {0};
+
+void portal_services_init(void) {
+    if (lock == NULL) lock = xSemaphoreCreateMutexStatic(&lock_buf);
+}
+
+static void services_resume(void) {
+    uint32_t heap_before = esp_get_free_heap_size();
+    int64_t t0 = esp_timer_get_time();
+
+    http_server_start();
+    dns_server_start();
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - t0);
+    stats.last_heap_delta = (int32_t)(heap_before - esp_get_free_heap_size());
+    stats.last_resume_us = elapsed;
+    if (stats.resumes++ == 0) stats.cold_start_us = elapsed;
+
+    ESP_LOGI(TAG, "Portal reanudado en %lu us (heap consumido: %ld bytes, reanudación #%lu)",
+             (unsigned long)elapsed, (long)stats.last_heap_delta, (unsigned long)stats.resumes);
+}
+
+static void services_suspend(void) {
+    http_server_stop();
+    dns_server_stop();
+    stats.suspends++;
+    ESP_LOGI(TAG, "Portal suspendido (recursos conservados)");
+}
+
+void portal_services_acquire(portal_owner_t owner) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool was_idle = (owners == 0);
+    owners |= owner;
+    if (was_idle && owners != 0) services_resume();
+    xSemaphoreGive(lock);
+}
+
+void portal_services_release(portal_owner_t owner) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool was_active = (owners != 0);
+    owners &= ~(uint32_t)owner;
+    if (was_active && owners == 0) services_suspend();
+    xSemaphoreGive(lock);
+}
+
+bool portal_services_is_active(void) {
+    return owners != 0;
+}
+
+void portal_services_get_stats(portal_services_stats_t *out) {
+    if (!out) return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    memcpy(out, &stats, sizeof(stats));
+    xSemaphoreGive(lock);
+}
@@ -0,0 +1,46 @@
+#ifndef PORTAL_SERVICES_H
+#define PORTAL_SERVICES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Dueños de los servicios del portal (HTTP + DNS). Cada uno cuenta una sola vez,
+ * así que pedir o soltar dos veces con el mismo dueño no tiene efecto.
+ */
+typedef enum {
+    PORTAL_OWNER_PROVISIONING = (1 << 0),
+} portal_owner_t;
+
+typedef struct {
+    uint32_t resumes;           /**< Veces que se reanudaron los servicios */
+    uint32_t suspends;          /**< Veces que se suspendieron */
+    uint32_t cold_start_us;     /**< Primera reanudación (crea httpd y la tarea DNS) */
+    uint32_t last_resume_us;    /**< Última reanudación (reingreso a provisión) */
+    int32_t  last_heap_delta;   /**< Heap consumido por la última reanudación (bytes) */
+} portal_services_stats_t;
+
+void portal_services_init(void);
+
+/**
+ * @brief Registra un dueño. Con el primero, se reanudan httpd y DNS.
+ */
+void portal_services_acquire(portal_owner_t owner);
+
+/**
+ * @brief Libera un dueño. Cuando no queda ninguno, se suspenden (sin liberar memoria).
+ */
+void portal_services_release(portal_owner_t owner);
+
+bool portal_services_is_active(void);
+void portal_services_get_stats(portal_services_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PORTAL_SERVICES_H
@@ -0,0 +1,137 @@
+#include "power_save.h"
+#include "wifi_manager.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/stats.h"
+#include <string.h>
+
+static const char *TAG = "power_save";
+
+#define PS_SAMPLE_MS 1000
+
+static esp_timer_handle_t sample_timer = NULL;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static power_save_stats_t stats = { .mode = WIFI_PS_NONE };
+static uint32_t prev_packets = 0;
+static int64_t last_sample_us = 0;
+static uint32_t idle_seconds = 0;
+
+#ifdef CONFIG_WIFI_MGR_PS_IDLE_MAX_MODEM
+#define PS_IDLE_MODE WIFI_PS_MAX_MODEM
+#else
+#define PS_IDLE_MODE WIFI_PS_MIN_MODEM
+#endif
+
+// Paquetes totales (rx + tx) de todas las netif según lwIP. Requiere CONFIG_LWIP_STATS.
+static bool read_packet_counter(uint32_t *out) {
+#if LWIP_STATS && LINK_STATS
+    *out = (uint32_t)lwip_stats.link.recv + (uint32_t)lwip_stats.link.xmit;
+    return true;
+#else
+    (void)out;
+    return false;
+#endif
+}
+
+// El driver solo aplica power save en modo STA puro: con el AP del portal arriba el radio queda despierto
+static bool sta_only(void) {
+    wifi_mode_t mode;
+    return esp_wifi_get_mode(&mode) == ESP_OK && mode == WIFI_MODE_STA;
+}
+
+#ifdef CONFIG_WIFI_MGR_PS_POLICY
+
+static void apply_mode(wifi_ps_type_t mode, uint32_t pps) {
+    if (mode == stats.mode) return;
+    if (esp_wifi_set_ps(mode) != ESP_OK) return;
+    ESP_LOGI(TAG, "Power save: %d -> %d (%lu paq/s)", stats.mode, mode, (unsigned long)pps);
+    taskENTER_CRITICAL(&stats_lock);
+    stats.mode = mode;
+    stats.switches++;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+static void sample_cb(void *arg) {
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = (uint32_t)((now - last_sample_us) / 1000);
+    last_sample_us = now;
+
+    uint32_t packets = 0;
+    bool have_counter = read_packet_counter(&packets);
+    uint32_t pps = (have_counter && elapsed_ms > 0) ? (packets - prev_packets) * 1000 / elapsed_ms : 0;
+    prev_packets = packets;
+
+    bool connected = wifi_manager_is_connected();
+    bool active = connected && sta_only();
+    taskENTER_CRITICAL(&stats_lock);
+    stats.last_pps = pps;
+    if (active) stats.time_in_mode_ms[stats.mode] += elapsed_ms;
+    else if (connected) stats.apsta_ms += elapsed_ms;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    // Sin enlace, con el portal arriba (APSTA) o sin contadores no hay nada que adaptar: radio despierto
+    if (!active || !have_counter) {
+        idle_seconds = 0;
+        apply_mode(WIFI_PS_NONE, pps);
+        return;
+    }
+
+    if (pps >= CONFIG_WIFI_MGR_PS_BUSY_PPS) {
+        // Carga: despertamos de inmediato
+        idle_seconds = 0;
+        apply_mode(WIFI_PS_NONE, pps);
+    } else if (pps <= CONFIG_WIFI_MGR_PS_IDLE_PPS) {
+        // Inactivo: solo bajamos tras el hold-down, para no oscilar con ráfagas cortas
+        if (idle_seconds < CONFIG_WIFI_MGR_PS_HOLD_S) idle_seconds++;
+        if (idle_seconds >= CONFIG_WIFI_MGR_PS_HOLD_S) apply_mode(PS_IDLE_MODE, pps);
+    } else {
+        idle_seconds = 0; // Zona intermedia: se mantiene el modo actual
+    }
+}
+
+#endif // CONFIG_WIFI_MGR_PS_POLICY
+
+void power_save_init(void) {
+    if (sample_timer) return;
+
+    esp_wifi_set_ps(WIFI_PS_NONE);
+    stats.mode = WIFI_PS_NONE;
+
+    uint32_t dummy;
+    if (!read_packet_counter(&dummy)) {
+        ESP_LOGW(TAG, "CONFIG_LWIP_STATS deshabilitado: power save fijo en WIFI_PS_NONE");
+        return;
+    }
+
+#ifdef CONFIG_WIFI_MGR_PS_POLICY
+    const esp_timer_create_args_t args = {
+        .callback = sample_cb,
+        .name = "ps_policy",
+    };
+    if (esp_timer_create(&args, &sample_timer) != ESP_OK) return;
+    last_sample_us = esp_timer_get_time();
+    read_packet_counter(&prev_packets);
+    esp_timer_start_periodic(sample_timer, PS_SAMPLE_MS * 1000);
+    ESP_LOGI(TAG, "Política de ahorro activa (ocupado >= %d paq/s, inactivo <= %d paq/s por %d s)",
+             CONFIG_WIFI_MGR_PS_BUSY_PPS, CONFIG_WIFI_MGR_PS_IDLE_PPS, CONFIG_WIFI_MGR_PS_HOLD_S);
+#endif
+}
+
+void power_save_record_latency(uint32_t latency_us) {
+    if (!sta_only()) return; // En APSTA no hay modo de ahorro al que atribuirla
+    taskENTER_CRITICAL(&stats_lock);
+    wifi_ps_type_t m = stats.mode;
+    stats.latency_samples[m]++;
+    stats.latency_us_total[m] += latency_us;
+    if (latency_us > stats.latency_us_max[m]) stats.latency_us_max[m] = latency_us;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void power_save_get_stats(power_save_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,42 @@
+#ifndef POWER_SAVE_H
+#define POWER_SAVE_H
+
+#include <stdint.h>
+#include "esp_wifi_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POWER_SAVE_MODES 3 // WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM
+
+typedef struct {
+    wifi_ps_type_t mode;                          /**< Modo aplicado actualmente */
+    uint32_t switches;                            /**< Cambios de modo realizados */
+    uint32_t last_pps;                            /**< Paquetes/s de la última muestra */
+    uint64_t time_in_mode_ms[POWER_SAVE_MODES];   /**< Tiempo acumulado conectado (solo STA) en cada modo */
+    uint64_t apsta_ms;                            /**< Tiempo conectado con el portal arriba: sin ahorro posible */
+    uint32_t latency_samples[POWER_SAVE_MODES];   /**< Muestras de latencia registradas por modo */
+    uint64_t latency_us_total[POWER_SAVE_MODES];
+    uint32_t latency_us_max[POWER_SAVE_MODES];
+} power_save_stats_t;
+
+/**
+ * @brief Arranca la política: muestrea el tráfico de las netif cada segundo y elige el modo.
+ * Reemplaza el WIFI_PS_NONE fijo de wifi_manager_init. Llamar después de esp_wifi_init.
+ */
+void power_save_init(void);
+
+/**
+ * @brief Registra una medición de latencia (por ejemplo, el RTT de una sonda)
+ * y la atribuye al modo de ahorro vigente. En APSTA se descarta.
+ */
+void power_save_record_latency(uint32_t latency_us);
+
+void power_save_get_stats(power_save_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POWER_SAVE_H
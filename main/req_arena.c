@@ -0,0 +1,27 @@
+#include "req_arena.h"
+
+void req_arena_init(req_arena_t *a, void *pool, size_t cap) {
+    if (!a) return;
+    a->base = (uint8_t *)pool;
+    a->cap = pool ? cap : 0;
+    a->used = 0;
+    a->high_water = 0;
+    a->failures = 0;
+}
+
+void *req_arena_alloc(req_arena_t *a, size_t size) {
+    if (!a || size == 0) return NULL;
+    size_t start = (a->used + (REQ_ARENA_ALIGN - 1)) & ~(size_t)(REQ_ARENA_ALIGN - 1);
+    if (start > a->cap || size > a->cap - start) {
+        a->failures++;
+        return NULL;
+    }
+    a->used = start + size;
+    return a->base + start;
+}
+
+void req_arena_reset(req_arena_t *a) {
+    if (!a) return;
+    if (a->used > a->high_water) a->high_water = a->used;
+    a->used = 0;
+}
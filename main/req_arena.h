@@ -0,0 +1,44 @@
+#ifndef REQ_ARENA_H
+#define REQ_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Arena "bump" para los buffers de un request HTTP: se pide memoria avanzando un índice sobre
+ * un pool fijo y se libera todo junto al terminar la respuesta. Sin free individual, sin heap.
+ * Módulo puro, sin ESP-IDF: se puede compilar en el host.
+ */
+
+#define REQ_ARENA_ALIGN 4
+
+typedef struct {
+    uint8_t *base;
+    size_t cap;
+    size_t used;
+    size_t high_water;      /**< Mayor uso en un request desde el arranque */
+    uint32_t failures;      /**< Pedidos que no entraron */
+} req_arena_t;
+
+void req_arena_init(req_arena_t *a, void *pool, size_t cap);
+
+/**
+ * @brief Reserva 'size' bytes alineados a REQ_ARENA_ALIGN (sin inicializar).
+ * @return NULL si no entra en lo que queda del pool.
+ */
+void *req_arena_alloc(req_arena_t *a, size_t size);
+
+/**
+ * @brief Libera todo lo reservado (fin del request). Actualiza el high-water mark.
+ */
+void req_arena_reset(req_arena_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REQ_ARENA_H
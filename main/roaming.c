@@ -0,0 +1,130 @@
+#include "roaming.h"
+#include "wifi_manager.h"
+#include "wifi_scanner.h"
+#include "mem_report.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "roaming";
+
+#define ROAM_LOW_HOLD_MS      10000  // La señal debe seguir baja este tiempo antes de buscar
+#define ROAM_RETRY_MS         60000  // Espera entre búsquedas que no encontraron candidato
+#define ROAM_ALBUM_MAX_AGE_MS 30000  // Entradas de un canal más viejas que esto no cuentan como candidatas
+#define ROAM_SCAN_MAX         8
+
+static TickType_t assoc_tick = 0;
+static TickType_t low_since = 0;
+static TickType_t last_search = 0;
+static int32_t rssi_avg_x4 = 0;      // Promedio exponencial (alfa = 1/4) en punto fijo
+static bool have_avg = false;
+static roaming_stats_t stats = {0};
+
+void roaming_reset(void) {
+    assoc_tick = xTaskGetTickCount();
+    low_since = 0;
+    last_search = 0;
+    have_avg = false;
+}
+
+void roaming_get_stats(roaming_stats_t *out) {
+    if (out) memcpy(out, &stats, sizeof(stats));
+}
+
+#ifdef CONFIG_WIFI_MGR_ROAMING
+
+// Buffers estáticos: solo los usa la tarea de estados y no cargan su stack
+static wifi_scan_result_t album[20];
+static wifi_ap_record_t scan_records[ROAM_SCAN_MAX];
+
+/**
+ * Busca otro BSSID del mismo SSID que supere al actual por al menos la histéresis.
+ * Primero en el álbum, solo entre las entradas de canales escaneados o refrescados hace poco (el
+ * refresco incremental renueva el álbum canal a canal), y si no, con un escaneo corto dirigido.
+ */
+static bool find_candidate(const wifi_ap_record_t *cur, int required_rssi, uint8_t bssid_out[6], uint8_t *channel_out) {
+    int best_rssi = required_rssi - 1;
+    const char *ssid = (const char *)cur->ssid;
+
+    int n = wifi_scanner_get_results(album, sizeof(album) / sizeof(album[0]));
+    for (int i = 0; i < n; i++) {
+        if (strcmp(album[i].ssid, ssid) != 0 || memcmp(album[i].bssid, cur->bssid, 6) == 0) continue;
+        if (wifi_scanner_get_channel_age_ms(album[i].channel) >= ROAM_ALBUM_MAX_AGE_MS) continue;
+        if (album[i].rssi > best_rssi) {
+            best_rssi = album[i].rssi;
+            memcpy(bssid_out, album[i].bssid, 6);
+            *channel_out = album[i].channel;
+        }
+    }
+    if (best_rssi >= required_rssi) return true;
+
+    n = wifi_scanner_scan_ssid(ssid, scan_records, ROAM_SCAN_MAX);
+    for (int i = 0; i < n; i++) {
+        if (memcmp(scan_records[i].bssid, cur->bssid, 6) == 0) continue;
+        if (scan_records[i].rssi > best_rssi) {
+            best_rssi = scan_records[i].rssi;
+            memcpy(bssid_out, scan_records[i].bssid, 6);
+            *channel_out = scan_records[i].primary;
+        }
+    }
+    return best_rssi >= required_rssi;
+}
+
+bool roaming_tick(void) {
+    wifi_ap_record_t cur;
+    if (esp_wifi_sta_get_ap_info(&cur) != ESP_OK) return false;
+
+    if (!have_avg) {
+        rssi_avg_x4 = cur.rssi * 4;
+        have_avg = true;
+    } else {
+        rssi_avg_x4 += cur.rssi - rssi_avg_x4 / 4;
+    }
+    int avg = rssi_avg_x4 / 4;
+    stats.rssi_avg = avg;
+
+    TickType_t now = xTaskGetTickCount();
+    if (avg >= CONFIG_WIFI_MGR_ROAM_RSSI_THRESHOLD) {
+        low_since = 0;
+        return false;
+    }
+
+    // Histéresis temporal: señal baja sostenida, dwell mínimo en el AP actual y espera entre búsquedas
+    if (low_since == 0) low_since = now;
+    if ((now - low_since) < pdMS_TO_TICKS(ROAM_LOW_HOLD_MS)) return false;
+    if ((now - assoc_tick) < pdMS_TO_TICKS(CONFIG_WIFI_MGR_ROAM_MIN_DWELL_S * 1000)) return false;
+    if (last_search != 0 && (now - last_search) < pdMS_TO_TICKS(ROAM_RETRY_MS)) return false;
+
+    last_search = now;
+    stats.evaluations++;
+
+    uint8_t bssid[6];
+    uint8_t channel = 0;
+    if (!find_candidate(&cur, avg + CONFIG_WIFI_MGR_ROAM_HYSTERESIS_DB, bssid, &channel)) {
+        stats.no_candidate++;
+        ESP_LOGI(TAG, "Señal baja (%d dBm) pero no hay un AP mejor de '%s'.", avg, (char *)cur.ssid);
+        return false;
+    }
+
+    ESP_LOGW(TAG, "Roaming: " MACSTR " (%d dBm) -> " MACSTR " (canal %d)",
+             MAC2STR(cur.bssid), avg, MAC2STR(bssid), channel);
+    wifi_manager_connect_bssid(bssid, channel);
+    stats.roams++;
+    return true;
+}
+
+#else
+
+bool roaming_tick(void) {
+    return false;
+}
+
+#endif // CONFIG_WIFI_MGR_ROAMING
+
+void roaming_init(void) {
+#ifdef CONFIG_WIFI_MGR_ROAMING
+    mem_report_register("roaming", NULL, 0, sizeof(album) + sizeof(scan_records) + sizeof(stats));
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef ROAMING_H
+#define ROAMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t evaluations;     /**< Veces que la señal quedó bajo el umbral el tiempo requerido */
+    uint32_t roams;           /**< Re-asociaciones a otro BSSID iniciadas */
+    uint32_t no_candidate;    /**< Evaluaciones sin un AP mejor que el actual */
+    int8_t   rssi_avg;        /**< RSSI promediado del AP actual (dBm) */
+} roaming_stats_t;
+
+/**
+ * @brief Registra los buffers del módulo en mem_report. Llamar una vez al arranque.
+ */
+void roaming_init(void);
+
+/**
+ * @brief Reinicia el seguimiento. Se llama en cada nueva asociación (inicio del dwell mínimo).
+ */
+void roaming_reset(void);
+
+/**
+ * @brief Evalúa la señal del AP actual. Se llama periódicamente en SYSTEM_STATE_CONNECTED.
+ * @return true si se inició una re-asociación a otro BSSID (el llamador debe esperar GOT_IP).
+ */
+bool roaming_tick(void);
+
+void roaming_get_stats(roaming_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROAMING_H
@@ -0,0 +1,50 @@
+#include "scan_plan.h"
+#include <string.h>
+
+static void add_group(scan_plan_t *out, const uint8_t *ch, uint8_t n, scan_band_t band, bool passive, bool dfs,
+                      uint16_t dwell_ms) {
+    uint8_t added = 0;
+    if (!ch) return;
+    for (uint8_t i = 0; i < n && out->n_steps < SCAN_PLAN_MAX_STEPS; i++) {
+        scan_plan_step_t *s = &out->steps[out->n_steps++];
+        s->channel = ch[i];
+        s->band = (uint8_t)band;
+        s->passive = passive || dfs;
+        s->dfs = dfs;
+        s->dwell_ms = s->passive ? dwell_ms : 0;
+        s->checkpoint = false;
+        added++;
+    }
+    if (added > 0) out->steps[out->n_steps - 1].checkpoint = true;
+}
+
+size_t scan_plan_build(const scan_plan_input_t *in, scan_plan_t *out) {
+    if (!out) return 0;
+    memset(out, 0, sizeof(*out));
+    if (!in) return 0;
+
+    bool has_5g = (in->ch_5g && in->n_5g > 0) || (in->ch_dfs && in->n_dfs > 0);
+    if (!has_5g) {
+        if (!in->ch_2g || in->n_2g == 0) return 0;
+        static const uint8_t all = SCAN_PLAN_CHANNEL_ALL;
+        add_group(out, &all, 1, SCAN_BAND_2G, in->passive, false, in->passive_dwell_ms);
+        return out->n_steps;
+    }
+
+    // Doble banda: un paso por canal (el escaneo "todos los canales" del driver mezcla ambas bandas)
+    if (in->preferred == SCAN_BAND_5G) {
+        add_group(out, in->ch_5g, in->n_5g, SCAN_BAND_5G, in->passive, false, in->passive_dwell_ms);
+        add_group(out, in->ch_2g, in->n_2g, SCAN_BAND_2G, in->passive, false, in->passive_dwell_ms);
+    } else {
+        add_group(out, in->ch_2g, in->n_2g, SCAN_BAND_2G, in->passive, false, in->passive_dwell_ms);
+        add_group(out, in->ch_5g, in->n_5g, SCAN_BAND_5G, in->passive, false, in->passive_dwell_ms);
+    }
+    add_group(out, in->ch_dfs, in->n_dfs, SCAN_BAND_5G, true, true, in->dfs_dwell_ms);
+    return out->n_steps;
+}
+
+bool scan_plan_should_stop(const scan_plan_t *plan, size_t step, bool have_known, bool known_seen) {
+    if (!plan || step + 1 >= plan->n_steps) return false;  // Último paso (o fuera del plan): nada que saltar
+    if (!plan->steps[step].checkpoint) return false;        // A mitad de un grupo la banda queda incompleta
+    return have_known && known_seen;
+}
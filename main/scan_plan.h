@@ -0,0 +1,76 @@
+#ifndef SCAN_PLAN_H
+#define SCAN_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Planificación de un escaneo completo por bandas: qué canales, en qué orden y dónde se puede
+ * cortar. Módulo puro, sin ESP-IDF: se puede compilar en el host con listas de canales simuladas.
+ */
+
+#define SCAN_PLAN_MAX_STEPS 48
+#define SCAN_PLAN_CHANNEL_ALL 0 // Paso único que barre toda la banda (objetivos de una sola banda)
+
+typedef enum {
+    SCAN_BAND_2G = 0,
+    SCAN_BAND_5G,
+    SCAN_BAND_COUNT
+} scan_band_t;
+
+typedef struct {
+    uint8_t channel;        /**< Canal a escanear, o SCAN_PLAN_CHANNEL_ALL */
+    uint8_t band;           /**< scan_band_t */
+    bool passive;           /**< Sin probe requests (DFS siempre, o escaneo pasivo pedido) */
+    bool dfs;
+    uint16_t dwell_ms;      /**< Escucha por canal de los pasos pasivos (0 en los activos) */
+    bool checkpoint;        /**< Último paso de su grupo: ahí se decide si seguir */
+} scan_plan_step_t;
+
+typedef struct {
+    scan_plan_step_t steps[SCAN_PLAN_MAX_STEPS];
+    uint8_t n_steps;
+} scan_plan_t;
+
+/**
+ * @brief Canales disponibles (ya filtrados por país/capacidad del chip). Una lista vacía
+ * deja la banda fuera del plan.
+ */
+typedef struct {
+    const uint8_t *ch_2g;
+    uint8_t n_2g;
+    const uint8_t *ch_5g;   /**< 5 GHz sin DFS */
+    uint8_t n_5g;
+    const uint8_t *ch_dfs;  /**< 5 GHz con DFS: solo pasivo, dwell largo */
+    uint8_t n_dfs;
+    scan_band_t preferred;
+    bool passive;
+    uint16_t passive_dwell_ms;  /**< Pasos pasivos fuera de DFS */
+    uint16_t dfs_dwell_ms;      /**< Pasos DFS: APs con intervalos de beacon más largos o CSA en curso */
+} scan_plan_input_t;
+
+/**
+ * @brief Arma el plan: grupo de la banda preferida, grupo de la otra banda y, al final, DFS.
+ * Sin 5 GHz el plan es un único paso que barre la banda de 2.4 GHz (igual que un escaneo plano).
+ * @return Cantidad de pasos.
+ */
+size_t scan_plan_build(const scan_plan_input_t *in, scan_plan_t *out);
+
+/**
+ * @brief Decisión tras ejecutar plan->steps[step]. Solo se corta en el checkpoint de un grupo (nunca a
+ * mitad de una banda) y si quedan pasos por saltar: con la red conocida ya vista el resto sobra (en
+ * particular los canales DFS, los más lentos). Sin red conocida se barre todo: el álbum es para el portal.
+ * @return true si hay que saltar los pasos restantes.
+ */
+bool scan_plan_should_stop(const scan_plan_t *plan, size_t step, bool have_known, bool known_seen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCAN_PLAN_H
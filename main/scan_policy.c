@@ -0,0 +1,49 @@
+#include "scan_policy.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+#define SCAN_WAIT_MIN_MS ((uint32_t)CONFIG_WIFI_MGR_SCAN_BACKOFF_MIN_S * 1000)
+#define SCAN_WAIT_MAX_MS ((uint32_t)CONFIG_WIFI_MGR_SCAN_BACKOFF_MAX_S * 1000)
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static scan_policy_stats_t stats = {0};
+
+void scan_policy_reset(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.streak = 0;
+    stats.wait_ms = 0;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+void scan_policy_wake(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.wakeups++;
+    stats.streak = 0;
+    stats.wait_ms = 0;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+bool scan_policy_next_is_passive(void) {
+    // Solo lo consulta la tarea de estados: la racha no cambia entre lectura y uso
+    uint8_t streak = stats.streak;
+    return streak != 0 && (streak % CONFIG_WIFI_MGR_SCAN_ACTIVE_EVERY) != 0;
+}
+
+uint32_t scan_policy_on_empty(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.empty_scans++;
+    if (stats.streak < UINT8_MAX) stats.streak++;
+    // 30 s, 60 s, 120 s... hasta el techo
+    uint32_t wait = (stats.wait_ms == 0) ? SCAN_WAIT_MIN_MS : stats.wait_ms * 2;
+    if (wait > SCAN_WAIT_MAX_MS) wait = SCAN_WAIT_MAX_MS;
+    stats.wait_ms = wait;
+    taskEXIT_CRITICAL(&stats_lock);
+    return wait;
+}
+
+void scan_policy_get_stats(scan_policy_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,51 @@
+#ifndef SCAN_POLICY_H
+#define SCAN_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cadencia de escaneo cuando el entorno está vacío (SCANNING sin redes): la espera crece
+ * exponencialmente hasta un techo y entre escaneos activos completos se intercalan pasivos.
+ */
+
+typedef struct {
+    uint32_t empty_scans;       /**< Escaneos sin redes desde el arranque */
+    uint32_t wakeups;           /**< Esperas cortadas por un evento (botón) */
+    uint32_t wait_ms;           /**< Espera actual tras el último escaneo vacío */
+    uint8_t  streak;            /**< Escaneos vacíos seguidos */
+} scan_policy_stats_t;
+
+/**
+ * @brief Hubo redes: la racha se corta y la próxima espera vuelve al mínimo.
+ */
+void scan_policy_reset(void);
+
+/**
+ * @brief Un evento externo (botón) interrumpe la espera: alguien está presente, se escanea activo ya.
+ */
+void scan_policy_wake(void);
+
+/**
+ * @brief true si el próximo escaneo debe ser pasivo. El primero de cada racha y uno de cada
+ * CONFIG_WIFI_MGR_SCAN_ACTIVE_EVERY son activos.
+ */
+bool scan_policy_next_is_passive(void);
+
+/**
+ * @brief Registra un escaneo vacío.
+ * @return Espera en ms hasta el próximo escaneo.
+ */
+uint32_t scan_policy_on_empty(void);
+
+void scan_policy_get_stats(scan_policy_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCAN_POLICY_H
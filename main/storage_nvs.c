@@ -3,6 +3,7 @@
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include "mbedtls/sha256.h"
 
 #include <string.h>
 
@@ -11,6 +12,26 @@ static const char *TAG = "storage_nvs";
 static const char *NVS_NAMESPACE = "wifi_storage";
 static const char *KEY_SSID = "ssid";
 static const char *KEY_PASS = "password";
+static const char *KEY_PSK = "psk";
+
+// La PSK viaja atada a las credenciales de las que salió: si el guardado de credenciales falló,
+// la PMK de otra red no pasa por válida junto a las credenciales viejas
+typedef struct {
+    uint8_t psk[WIFI_PSK_LEN];
+    uint8_t binding[32]; // SHA-256 de ssid '\0' password
+} psk_record_t;
+
+static void psk_binding(const char *ssid, const char *password, uint8_t out[32])
+{
+    char buf[WIFI_SSID_MAX_LEN + WIFI_PASS_MAX_LEN];
+    size_t ssid_len = strnlen(ssid, WIFI_SSID_MAX_LEN - 1);
+    size_t pass_len = strnlen(password, WIFI_PASS_MAX_LEN - 1);
+
+    memcpy(buf, ssid, ssid_len);
+    buf[ssid_len] = '\0';
+    memcpy(buf + ssid_len + 1, password, pass_len);
+    mbedtls_sha256((const unsigned char *)buf, ssid_len + 1 + pass_len, out, 0);
+}
 
 /* Initialize NVS */
 void storage_nvs_init(void)
@@ -64,6 +85,9 @@ bool storage_save_wifi_credentials(const char *ssid, const char *password)
     err = nvs_set_str(handle, KEY_PASS, password);
     if (err != ESP_OK) goto fail;
 
+    // La PSK derivada era de las credenciales anteriores
+    nvs_erase_key(handle, KEY_PSK);
+
     err = nvs_commit(handle);
     if (err != ESP_OK) goto fail;
 
@@ -121,6 +145,80 @@ fail:
     return false;
 }
 
+/* Save derived PSK, bound to the credentials it was derived from */
+bool storage_save_wifi_psk(const char *ssid, const char *password, const uint8_t psk[WIFI_PSK_LEN])
+{
+    if (!ssid || !password || !psk) return false;
+
+    psk_record_t rec;
+    memcpy(rec.psk, psk, WIFI_PSK_LEN);
+    psk_binding(ssid, password, rec.binding);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS (%s)", esp_err_to_name(err));
+        return false;
+    }
+
+    err = nvs_set_blob(handle, KEY_PSK, &rec, sizeof(rec));
+    if (err == ESP_OK) err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save PSK (%s)", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+/* Load derived PSK */
+bool storage_load_wifi_psk(const char *ssid, const char *password, uint8_t psk_out[WIFI_PSK_LEN])
+{
+    if (!ssid || !password || !psk_out) return false;
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) return false;
+
+    psk_record_t rec;
+    size_t len = sizeof(rec);
+    esp_err_t err = nvs_get_blob(handle, KEY_PSK, &rec, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len != sizeof(rec)) return false; // También descarta el formato viejo (solo la PSK)
+
+    // La PSK solo vale para las credenciales de las que se derivó
+    uint8_t binding[32];
+    psk_binding(ssid, password, binding);
+    if (memcmp(binding, rec.binding, sizeof(binding)) != 0) return false;
+
+    memcpy(psk_out, rec.psk, WIFI_PSK_LEN);
+    return true;
+}
+
+/* Erase derived PSK (the AP rejected it) */
+bool storage_clear_wifi_psk(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS (%s)", esp_err_to_name(err));
+        return false;
+    }
+
+    err = nvs_erase_key(handle, KEY_PSK);
+    if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+    if (err == ESP_OK) err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase PSK (%s)", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
 /* Clear WiFi credentials */
 bool storage_clear_wifi_credentials(void)
 {
@@ -134,6 +232,7 @@ bool storage_clear_wifi_credentials(void)
 
     nvs_erase_key(handle, KEY_SSID);
     nvs_erase_key(handle, KEY_PASS);
+    nvs_erase_key(handle, KEY_PSK);
 
     err = nvs_commit(handle);
     nvs_close(handle);
@@ -2,9 +2,11 @@
 #define STORAGE_NVS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define WIFI_SSID_MAX_LEN 32
 #define WIFI_PASS_MAX_LEN 64
+#define WIFI_PSK_LEN 32 // PMK de WPA2-PSK (PBKDF2-SHA1 de passphrase + SSID)
 
 /* Initialize NVS storage */
 void storage_nvs_init(void);
@@ -15,6 +17,15 @@ bool storage_save_wifi_credentials(const char *ssid, const char *password);
 /* Load Wi-Fi credentials */
 bool storage_load_wifi_credentials(char *ssid_out, char *password_out);
 
+/* Save the PSK derived from ssid/password, bound to them (saving new credentials erases it) */
+bool storage_save_wifi_psk(const char *ssid, const char *password, const uint8_t psk[WIFI_PSK_LEN]);
+
+/* Load the stored PSK, only if it was derived from exactly ssid/password */
+bool storage_load_wifi_psk(const char *ssid, const char *password, uint8_t psk_out[WIFI_PSK_LEN]);
+
+/* Erase the stored PSK (the connects go back to the passphrase) */
+bool storage_clear_wifi_psk(void);
+
 /* Clear stored Wi-Fi credentials */
 bool storage_clear_wifi_credentials(void);
 
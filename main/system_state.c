@@ -4,129 +4,339 @@
 #include "wifi_scanner.h" 
 #include "storage_nvs.h"
 #include "led_status.h"
-#include "dns_server.h"
-#include "http_server.h"
+#include "roaming.h"
+#include "album_refresh.h"
+#include "scan_policy.h"
+#include "telemetry.h"
+#include "conn_bus.h"
+#include "link_probe.h"
+#include "mem_report.h"
+#include "boot_profile.h"
+#include "task_topology.h"
+#include "button.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
-#include "driver/gpio.h"
 #include <string.h>
 
 static const char *TAG = "system_state";
 static system_state_t current_state = SYSTEM_STATE_BOOT;
 static bool force_provisioning = false;
 static bool es_nueva_config = false; // Solo true si viene del portal
-static bool modo_espera_scan = false;
-static int contador_espera = 0;
+static TickType_t scan_wait_until = 0; // != 0: entorno vacío, próximo escaneo no antes de este tick
+static bool fast_boot_attempt = false; // Primer intento directo con credenciales NVS, sin álbum
+static TickType_t portal_grace_start = 0; // != 0: portal pendiente de cierre tras GOT_IP
+
+// Entradas de la tarea de estados: eventos de conn_bus y gestos del botón en una sola cola
+// (sin event group ni polling de globales ni del GPIO)
+typedef enum {
+    STATE_INPUT_CONN = 0,
+    STATE_INPUT_BUTTON,
+} state_input_src_t;
+
+typedef struct {
+    state_input_src_t src;
+    union {
+        conn_event_t conn;
+        button_event_t button;
+    };
+} state_input_t;
+
+#define INPUT_QUEUE_LEN 8
+static StaticQueue_t input_queue_buf;
+static uint8_t input_queue_storage[INPUT_QUEUE_LEN * sizeof(state_input_t)];
+static QueueHandle_t input_queue = NULL;
+#define STATE_TASK_STACK TASK_STATE_STACK
+static StackType_t state_task_stack[STATE_TASK_STACK];
+static StaticTask_t state_task_tcb;
+static bool link_up = false;      // Con IP, según el último evento consumido
+static uint8_t link_reason = 0;   // Última razón de desconexión consumida
+static volatile bool input_dropped = false; // Cola llena: link_up se resincroniza con conn_bus
 
 #define STA_CONNECT_TIMEOUT_MS 15000
 #define RETRY_DELAY_MS         5000 
 #define MAX_STA_RETRIES        3
+#define PORTAL_GRACE_MS        5000
+#define STA_START_TIMEOUT_MS   3000
 
-// Bit de conexión (definido aquí para consistencia)
-#define WIFI_CONNECTED_BIT BIT0 
+// Métricas: las escribe la tarea de estados, las lee /metrics
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static system_state_stats_t stats = {0};
+static int64_t state_enter_us = 0;
+static int64_t offline_since_us = 0;   // Inicio del episodio sin IP actual (0 = arranque)
+static uint32_t episode_scans = 0;
+static uint64_t episode_prov_ms = 0;
 
 void system_state_set(system_state_t state) {
+    system_state_t prev = current_state;
     current_state = state;
+    if (state == prev && state_enter_us != 0) return; // Auto-salto: no es una transición
+
+    int64_t now = esp_timer_get_time();
+    uint32_t spent_ms = (uint32_t)((now - state_enter_us) / 1000);
+    bool got_ip = false;
+    uint32_t tti_ms = 0;
+
+    taskENTER_CRITICAL(&stats_lock);
+    if (state_enter_us != 0) {
+        stats.time_in_state_ms[prev] += spent_ms;
+        if (prev == SYSTEM_STATE_PROVISIONING) episode_prov_ms += spent_ms;
+    }
+    stats.transitions++;
+    stats.entries[state]++;
+    if (state == SYSTEM_STATE_CONNECTED) {
+        tti_ms = (uint32_t)((now - offline_since_us) / 1000);
+        stats.time_to_ip_last_ms = tti_ms;
+        if (tti_ms > stats.time_to_ip_max_ms) stats.time_to_ip_max_ms = tti_ms;
+        got_ip = true;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    state_enter_us = now;
+
     ESP_LOGI(TAG, "Cambiando estado del sistema -> %d", state);
+    if (got_ip) {
+        ESP_LOGI(TAG, "Conectado en %lu ms (escaneos: %lu, en provisión: %llu ms)", (unsigned long)tti_ms,
+                 (unsigned long)episode_scans, (unsigned long long)episode_prov_ms);
+    } else if (prev == SYSTEM_STATE_CONNECTED) {
+        offline_since_us = now; // Empieza un episodio nuevo sin IP
+        episode_scans = 0;
+        episode_prov_ms = 0;
+    }
 }
 
 system_state_t system_state_get(void) {
     return current_state;
 }
 
+/**
+ * Prueba de credenciales nuevas fallida: se descartan y el STA vuelve a las últimas
+ * credenciales válidas de la NVS (si existen). La NVS nunca se tocó, así que no hay nada que deshacer allí.
+ */
+static void rollback_new_credentials(uint8_t reason) {
+    char ssid[32], pass[64];
+
+    es_nueva_config = false;
+    esp_wifi_disconnect(); // Cortamos los intentos contra la red equivocada
+    if (storage_load_wifi_credentials(ssid, pass)) {
+        wifi_manager_set_credentials(ssid, pass);
+        ESP_LOGW(TAG, "Rollback: se restauran las credenciales guardadas ('%s').", ssid);
+    }
+    wifi_provisioning_set_test_result(WIFI_PROV_TEST_FAILED, reason);
+}
+
+// Publicadores (conn_bus y timers del botón): solo encolan, sin bloquear. Una entrada perdida se cuenta
+// y, si era de conectividad, la tarea relee la foto de conn_bus en vez de quedarse con un link_up viejo.
+static void count_input_drop(void) {
+    taskENTER_CRITICAL(&stats_lock);
+    stats.input_drops++;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+static void on_conn_event(const conn_event_t *evt, void *arg) {
+    state_input_t in = { .src = STATE_INPUT_CONN, .conn = *evt };
+    if (xQueueSend(input_queue, &in, 0) != pdTRUE) {
+        input_dropped = true;
+        count_input_drop();
+    }
+}
+
+static void on_button(button_event_t evt, void *arg) {
+    state_input_t in = { .src = STATE_INPUT_BUTTON, .button = evt };
+    if (xQueueSend(input_queue, &in, 0) != pdTRUE) count_input_drop();
+}
+
+/**
+ * Gestos del botón:
+ * - corta: forzar el portal (pasando por SCANNING para armar el álbum), como siempre;
+ * - doble: re-escaneo inmediato si estamos buscando red (espera de backoff o reintentos);
+ * - larga: olvidar la red guardada (NVS y RAM) y abrir el portal.
+ */
+static void handle_button(button_event_t evt) {
+    switch (evt) {
+        case BUTTON_EVT_LONG:
+            ESP_LOGW(TAG, "Pulsación larga: borrando credenciales y abriendo el portal.");
+            storage_clear_wifi_credentials();
+            wifi_manager_set_credentials("", "");
+            es_nueva_config = false;
+            fast_boot_attempt = false;
+            link_up = false;
+            esp_wifi_disconnect();
+            // fall through
+        case BUTTON_EVT_SHORT:
+            ESP_LOGW(TAG, "¡Botón detectado! Forzando Modo Configuración.");
+            force_provisioning = true;
+            system_state_set(SYSTEM_STATE_SCANNING); // Saltamos a Scanning para decidir
+            break;
+        case BUTTON_EVT_DOUBLE:
+            if (current_state == SYSTEM_STATE_SCANNING || current_state == SYSTEM_STATE_DISCONNECTED) {
+                ESP_LOGI(TAG, "Doble pulsación: re-escaneo inmediato.");
+                scan_policy_wake();
+                scan_wait_until = 0;
+                system_state_set(SYSTEM_STATE_SCANNING);
+            } else {
+                ESP_LOGI(TAG, "Doble pulsación ignorada en el estado %d.", current_state);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Espera hasta 'wait' la próxima entrada y consume las que estén encoladas
+static void consume_inputs(TickType_t wait) {
+    state_input_t in;
+    while (xQueueReceive(input_queue, &in, wait) == pdTRUE) {
+        wait = 0;
+        if (in.src == STATE_INPUT_BUTTON) {
+            handle_button(in.button);
+            continue;
+        }
+        const conn_event_t *evt = &in.conn;
+        task_topology_record_latency(TASK_LATENCY_STATE_EVENT, (uint32_t)(esp_timer_get_time() - evt->timestamp_us));
+        switch (evt->type) {
+            case CONN_EVT_GOT_IP:
+                link_up = true;
+                link_reason = 0;
+                break;
+            case CONN_EVT_STA_DISCONNECTED:
+                link_reason = evt->reason;
+                // fall through
+            case CONN_EVT_LOST_IP:
+                link_up = false;
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Solo tras una pérdida: sin ella, la foto puede ir atrasada respecto de un link_up = false
+    // puesto a propósito antes de reconectar (el DISCONNECTED todavía no se publicó).
+    if (input_dropped) {
+        input_dropped = false;
+        conn_status_t st;
+        conn_bus_get_status(&st);
+        link_up = st.connected;
+        link_reason = st.last_reason;
+        ESP_LOGW(TAG, "Cola de entradas llena: enlace releído de conn_bus (%s, razón %d)",
+                 link_up ? "con IP" : "sin IP", link_reason);
+    }
+}
+
 void system_state_init(void) {
     ESP_LOGI(TAG, "Inicializando gestor de estados...");
     system_state_set(SYSTEM_STATE_BOOT);
-    xTaskCreate(system_state_task, "system_state_task", 4096, NULL, 5, NULL);
+    input_queue = xQueueCreateStatic(INPUT_QUEUE_LEN, sizeof(state_input_t), input_queue_storage, &input_queue_buf);
+    conn_bus_subscribe_cb(on_conn_event, NULL);
+    button_init(on_button, NULL);
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(system_state_task, "system_state_task", STATE_TASK_STACK, NULL,
+                                                      TASK_STATE_PRIO, state_task_stack, &state_task_tcb,
+                                                      TASK_TOPOLOGY_CORE_ID(TASK_STATE_CORE));
+    mem_report_register("system_state", task, STATE_TASK_STACK,
+                        sizeof(state_task_stack) + sizeof(state_task_tcb) + sizeof(input_queue_storage) + sizeof(input_queue_buf));
 }
 
 void system_state_task(void *pvParameters) {
     TickType_t connect_start_time = 0;
+    TickType_t boot_wait_start = 0;
     int retry_count = 0;
     char ssid[32], pass[64]; // Buffers siempre listos arriba
 
-    // 1. Configuración del GPIO 0 (Vigilante)
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << GPIO_NUM_0),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-    };
-    gpio_config(&io_conf);
-
     while (1) {
-        // --- VIGILANTE DE BOTÓN (En cada iteración) ---
-        if (gpio_get_level(GPIO_NUM_0) == 0) {
-            vTaskDelay(pdMS_TO_TICKS(50)); // Debounce
-            if (gpio_get_level(GPIO_NUM_0) == 0) {
-                ESP_LOGW(TAG, "¡Botón detectado! Forzando Modo Configuración.");
-                force_provisioning = true;
-                system_state_set(SYSTEM_STATE_SCANNING); // Saltamos a Scanning para decidir
-            }
-        }
-
         system_state_t state = system_state_get();
         switch (state) {
             case SYSTEM_STATE_BOOT:
                 led_status_set(LED_STATUS_BOOTING);
-                esp_err_t ret = esp_wifi_start();
-                if (ret != ESP_OK) {
-                    ESP_LOGE(TAG, "Fallo crítico al iniciar radio");
+                {
+                    // La radio la arranca app_main; aquí solo esperamos STA_START (sin sleeps fijos)
+                    conn_status_t st;
+                    conn_bus_get_status(&st);
+                    if (!st.sta_started) {
+                        if (boot_wait_start == 0) {
+                            boot_wait_start = xTaskGetTickCount();
+                            // Idempotente si app_main ya la arrancó; cubre el regreso desde ERROR
+                            if (esp_wifi_start() != ESP_OK) ESP_LOGE(TAG, "Fallo crítico al iniciar radio");
+                        } else if ((xTaskGetTickCount() - boot_wait_start) > pdMS_TO_TICKS(STA_START_TIMEOUT_MS)) {
+                            ESP_LOGE(TAG, "STA_START no llegó en %d ms", STA_START_TIMEOUT_MS);
+                            boot_wait_start = 0;
+                            system_state_set(SYSTEM_STATE_ERROR);
+                        }
+                        break;
+                    }
+                    boot_wait_start = 0;
+
+                    wifi_manager_get_credentials(ssid, pass);
+#ifdef CONFIG_WIFI_MGR_FAST_BOOT
+                    if (ssid[0] != '\0' && !force_provisioning) {
+                        // El connect ya salió en STA_START con la red guardada: vamos directo a esperar la IP.
+                        // Lo publicado antes de suscribirnos (GOT_IP o la caída) solo está en la foto.
+                        link_up = st.connected;
+                        link_reason = st.last_reason;
+                        fast_boot_attempt = true;
+                        retry_count = 0;
+                        connect_start_time = xTaskGetTickCount();
+                        boot_profile_mark(BOOT_PHASE_CONNECT);
+                        system_state_set(SYSTEM_STATE_TRY_STA);
+                        break;
+                    }
+#endif
+                    system_state_set(SYSTEM_STATE_SCANNING);
                 }
-                vTaskDelay(pdMS_TO_TICKS(500));
-                system_state_set(SYSTEM_STATE_SCANNING);
                 break;
 
             case SYSTEM_STATE_SCANNING:
-                // --- PASO 1: EL VIGILANTE DEL TIEMPO ---
-                if (modo_espera_scan) {
-                    // AGREGAMOS ESTO: Si presionan el botón, abortamos la espera para ir a escanear YA
+                // --- PASO 1: EL VIGILANTE DEL TIEMPO (backoff en entorno vacío) ---
+                if (scan_wait_until != 0) {
                     if (force_provisioning) {
+                        // Si presionan el botón, abortamos la espera para ir a escanear YA (y activo)
                         ESP_LOGI(TAG, "Botón detectado. Abortando espera para escanear...");
-                        modo_espera_scan = false;
-                        contador_espera = 0;
-                        // No hacemos break, dejamos que caiga directamente al Paso 2 (Escaneo)
+                        scan_policy_wake();
+                        scan_wait_until = 0;
                     }
-                    else if (contador_espera < 30) {
-                        contador_espera++;
-                        // Log cada 5s para no inundar la consola
-                        if (contador_espera % 5 == 0) ESP_LOGI(TAG, "Esperando... (%d/30s)", contador_espera);
-            
-                        vTaskDelay(pdMS_TO_TICKS(500));
-                        system_state_set(SYSTEM_STATE_SCANNING); // "Auto-salto" para re-entrar
-                        break; 
+                    else if ((int32_t)(scan_wait_until - xTaskGetTickCount()) > 0) {
+                        // Radio quieta: el loop duerme en la cola de entradas hasta la próxima vuelta
+                        break;
                     } else {
-                    // Se acabó el tiempo de espera
-                    modo_espera_scan = false;
-                    contador_espera = 0;
-                    // No hacemos break, dejamos que fluya al escaneo abajo
+                        scan_wait_until = 0; // Se acabó el tiempo de espera: fluye al escaneo
                     }
                 }
                 
                 // --- PASO 2: EL ESCANEO REAL ---
-                ESP_LOGI(TAG, "Estado: SCANNING (Armando álbum)");
-                int redes_encontradas = wifi_scanner_execute_actual_scan();
+                bool pasivo = scan_policy_next_is_passive();
+                ESP_LOGI(TAG, "Estado: SCANNING (Armando álbum%s)", pasivo ? ", pasivo" : "");
+                // Con la red guardada a la vista el plan puede cortar temprano; forzando el portal, álbum completo
+                bool hay_guardada = !force_provisioning && storage_load_wifi_credentials(ssid, pass);
+                int redes_encontradas = wifi_scanner_execute_scan(pasivo, hay_guardada ? ssid : NULL);
+                episode_scans++;
+                taskENTER_CRITICAL(&stats_lock);
+                stats.scans++;
+                taskEXIT_CRITICAL(&stats_lock);
+                boot_profile_mark(BOOT_PHASE_SCAN_DONE);
 
                 if (redes_encontradas <= 0) {
-                    ESP_LOGW(TAG, "No hay redes. Iniciando cuenta de 30s...");
-                    modo_espera_scan = true;
-                    contador_espera = 0;
-                    system_state_set(SYSTEM_STATE_SCANNING);
+                    uint32_t espera_ms = scan_policy_on_empty();
+                    ESP_LOGW(TAG, "No hay redes. Próximo escaneo en %lu s...", (unsigned long)(espera_ms / 1000));
+                    scan_wait_until = xTaskGetTickCount() + pdMS_TO_TICKS(espera_ms);
+                    if (scan_wait_until == 0) scan_wait_until = 1; // 0 significa "sin espera"
                 }
                 else {
+                    scan_policy_reset();
                     // --- PASO 3 NODO DE DECISIÓN - BOTÓN
                     if (force_provisioning) {
                         ESP_LOGW(TAG, "Banderín activo. Saltando a Provisión.");
                         force_provisioning = false; // Bajamos banderín
                         system_state_set(SYSTEM_STATE_PROVISIONING);
                     }
-                    else if (storage_load_wifi_credentials(ssid, pass)) {
+                    else if (hay_guardada) {
                         // REVISIÓN DEL ÁLBUM: ¿La red guardada está presente?
                         if (wifi_scanner_is_network_available(ssid)) {
                             ESP_LOGI(TAG, "Red '%s' hallada en el lugar. Conectando...", ssid);
                             wifi_manager_set_credentials(ssid, pass);
+                            link_up = false; // reconnect() corta primero: no confiar en un GOT_IP viejo
                             wifi_manager_reconnect(); 
+                            boot_profile_mark(BOOT_PHASE_CONNECT);
                             system_state_set(SYSTEM_STATE_TRY_STA);
                             connect_start_time = xTaskGetTickCount();
                         } else {
@@ -143,9 +353,7 @@ void system_state_task(void *pvParameters) {
             case SYSTEM_STATE_PROVISIONING:
                 led_status_set(LED_STATUS_PROVISIONING);
                 if (!wifi_provisioning_is_active()) {
-                    wifi_provisioning_start(); 
-                    dns_server_start();
-                    http_server_start();
+                    wifi_provisioning_start(); // Reanuda HTTP + DNS vía portal_services
                 }
                 
                 if (wifi_provisioning_has_new_credentials()) {
@@ -154,54 +362,89 @@ void system_state_task(void *pvParameters) {
                     wifi_manager_set_credentials(creds.ssid, creds.password);
                     es_nueva_config = true;
 
-                    http_server_stop();
-                    dns_server_stop();
-                    wifi_provisioning_stop();
-                    
+                    // El portal sigue arriba: probamos en APSTA y el resultado se informa en vivo por /status.
+                    // Solo se desarma tras un GOT_IP confirmado (ver CONNECTED).
+                    wifi_provisioning_set_test_result(WIFI_PROV_TEST_RUNNING, 0);
+                    wifi_manager_reset_last_disconnect_reason();
+                    link_up = false;
+                    link_reason = 0;
                     wifi_manager_reconnect();
                     retry_count = 0; 
                     connect_start_time = 0; 
-                    wifi_manager_reset_last_disconnect_reason();
                     system_state_set(SYSTEM_STATE_TRY_STA);
                 }
                 break;
 
             case SYSTEM_STATE_TRY_STA:
                 led_status_set(LED_STATUS_WIFI_CONNECTING);
-                EventGroupHandle_t ev_grp = wifi_manager_get_event_group();
-
-                if (ev_grp != NULL) {
-                    EventBits_t bits = xEventGroupWaitBits(ev_grp, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(100));
-
-                    if (bits & WIFI_CONNECTED_BIT) { // 1. ¿Estamos conectados?
+                {
+                    if (link_up) { // 1. ¿Estamos conectados?
     
                         // 2. Solo si es una configuración nueva, guardamos en la Flash
+                        bool en_nvs = true;
                         if (es_nueva_config) {
                             wifi_manager_get_credentials(ssid, pass); 
-                            storage_save_wifi_credentials(ssid, pass); 
+                            en_nvs = storage_save_wifi_credentials(ssid, pass);
                             es_nueva_config = false; // Cerramos el seguro
-                            ESP_LOGI(TAG, "Nuevas credenciales guardadas en NVS.");
+                            if (en_nvs) ESP_LOGI(TAG, "Nuevas credenciales guardadas en NVS.");
+                            else ESP_LOGE(TAG, "No se pudieron guardar las credenciales: la red no sobrevive al reinicio.");
                         } else {
                             ESP_LOGI(TAG, "Conexión exitosa con datos conocidos (No se escribe Flash).");
                         }
+                        // Solo con las credenciales confirmadas en NVS: la PSK se deriva una sola vez (no-op si ya existe)
+                        if (en_nvs) wifi_manager_cache_psk();
 
-                        // 3. Siempre pasamos al estado conectado, sea nueva o vieja la red
+                        // 3. Si el portal quedó arriba durante la prueba, avisamos y programamos su cierre
+                        if (wifi_provisioning_is_active()) {
+                            wifi_provisioning_set_test_result(WIFI_PROV_TEST_SUCCESS, 0);
+                            portal_grace_start = xTaskGetTickCount();
+                            ESP_LOGI(TAG, "Portal se cierra en %d ms (período de gracia).", PORTAL_GRACE_MS);
+                        }
+
+                        // 4. Siempre pasamos al estado conectado, sea nueva o vieja la red
+                        fast_boot_attempt = false;
+                        roaming_reset(); // Arranca el dwell mínimo en este AP
+                        album_refresh_reset();
+                        telemetry_reset();
                         system_state_set(SYSTEM_STATE_CONNECTED);
                         retry_count = 0;
                         connect_start_time = 0;
                         } else {
-                        uint8_t reason = wifi_manager_get_last_disconnect_reason();
+                        uint8_t reason = link_reason;
 
-                        if (reason == WIFI_REASON_AUTH_FAIL || reason == 15) { 
+                        if ((reason == WIFI_REASON_AUTH_FAIL || reason == 15) && wifi_manager_forget_psk()) {
+                            // Rechazo con la PSK guardada (p. ej. el AP pasó a WPA3): un intento más con la passphrase
+                            ESP_LOGW(TAG, "PSK rechazada (Razón: %d). Reintentando con la passphrase.", reason);
+                            link_reason = 0;
+                            connect_start_time = 0;
+                            wifi_manager_reconnect();
+                        } else if (reason == WIFI_REASON_AUTH_FAIL || reason == 15) { 
                             ESP_LOGE(TAG, "Fallo de credenciales (Razón: %d). Regresando a Provisión.", reason);
+                            if (es_nueva_config) rollback_new_credentials(reason);
+                            fast_boot_attempt = false;
                             system_state_set(SYSTEM_STATE_PROVISIONING);
+                        } else if (fast_boot_attempt && reason == WIFI_REASON_NO_AP_FOUND) {
+                            // La red guardada no está: volvemos al camino normal (álbum y decisión)
+                            ESP_LOGW(TAG, "Fast boot: red guardada no encontrada. Escaneando...");
+                            fast_boot_attempt = false;
+                            connect_start_time = 0;
+                            system_state_set(SYSTEM_STATE_SCANNING);
                         } else {
                             if (connect_start_time == 0) connect_start_time = xTaskGetTickCount();
                             
                             if ((xTaskGetTickCount() - connect_start_time) > pdMS_TO_TICKS(STA_CONNECT_TIMEOUT_MS)) {
                                 ESP_LOGW(TAG, "Timeout alcanzado");
                                 connect_start_time = 0;
-                                system_state_set(SYSTEM_STATE_DISCONNECTED);
+                                if (es_nueva_config) {
+                                    // Credenciales nuevas sin éxito: volvemos al portal (que sigue arriba)
+                                    rollback_new_credentials(reason);
+                                    system_state_set(SYSTEM_STATE_PROVISIONING);
+                                } else if (fast_boot_attempt) {
+                                    fast_boot_attempt = false;
+                                    system_state_set(SYSTEM_STATE_SCANNING);
+                                } else {
+                                    system_state_set(SYSTEM_STATE_DISCONNECTED);
+                                }
                             }
                         }
                     }
@@ -210,10 +453,38 @@ void system_state_task(void *pvParameters) {
 
             case SYSTEM_STATE_CONNECTED:
                 led_status_set(LED_STATUS_WIFI_CONNECTED);
-                if (!wifi_manager_is_connected()) {
+                boot_profile_report(); // Una sola vez por arranque; no-op el resto del tiempo
+
+                // Cierre diferido del portal: el teléfono alcanza a ver el resultado antes de perder el AP
+                if (portal_grace_start != 0 &&
+                    (xTaskGetTickCount() - portal_grace_start) > pdMS_TO_TICKS(PORTAL_GRACE_MS)) {
+                    ESP_LOGI(TAG, "Fin del período de gracia. Cerrando portal.");
+                    wifi_provisioning_stop();
+                    portal_grace_start = 0;
+                }
+
+                if (!link_up) {
                     ESP_LOGW(TAG, "Conexión perdida.");
                     system_state_set(SYSTEM_STATE_DISCONNECTED);
                 }
+                else if (roaming_tick()) {
+                    // Re-asociación a un AP mejor en curso: esperamos el nuevo GOT_IP
+                    link_up = false;
+                    connect_start_time = xTaskGetTickCount();
+                    system_state_set(SYSTEM_STATE_TRY_STA);
+                }
+                else if (link_probe_is_degraded()) {
+                    // Hay IP pero el uplink no responde: forzamos re-asociación (el driver elige el mejor AP)
+                    ESP_LOGW(TAG, "Uplink degradado. Re-asociando...");
+                    link_up = false;
+                    retry_count = 0;
+                    system_state_set(SYSTEM_STATE_DISCONNECTED);
+                }
+                else {
+                    // Enlace sano: el álbum se mantiene fresco de a un canal, sin cortar el tráfico
+                    album_refresh_tick();
+                    telemetry_tick();
+                }
                 break;
 
             case SYSTEM_STATE_DISCONNECTED:
@@ -225,6 +496,7 @@ void system_state_task(void *pvParameters) {
                     retry_count++;
                     ESP_LOGI(TAG, "Reintento %d de %d...", retry_count, MAX_STA_RETRIES);
                     vTaskDelay(pdMS_TO_TICKS(RETRY_DELAY_MS));
+                    link_up = false;
                     wifi_manager_reconnect();
                     system_state_set(SYSTEM_STATE_TRY_STA);
                 }
@@ -240,6 +512,17 @@ void system_state_task(void *pvParameters) {
                 system_state_set(SYSTEM_STATE_ERROR);
                 break;
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
+        // Un evento de conectividad o del botón despierta al estado de inmediato; si no hay, seguimos al ritmo de 500 ms.
+        // Tras una transición no se espera: el estado nuevo corre en la vuelta siguiente.
+        consume_inputs(system_state_get() == state ? pdMS_TO_TICKS(500) : 0);
     }
-}
\ No newline at end of file
+}
+
+void system_state_get_stats(system_state_stats_t *out) {
+    if (!out) return;
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    if (state_enter_us != 0) out->time_in_state_ms[current_state] += (uint64_t)((now - state_enter_us) / 1000);
+    taskEXIT_CRITICAL(&stats_lock);
+}
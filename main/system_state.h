@@ -2,6 +2,7 @@
 #define SYSTEM_STATE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,21 @@ typedef enum {
     SYSTEM_STATE_ERROR
 } system_state_t;
 
+#define SYSTEM_STATE_COUNT (SYSTEM_STATE_ERROR + 1)
+
+/**
+ * @brief Métricas del flujo de estados, para comparar cambios en system_state.c con números.
+ */
+typedef struct {
+    uint32_t transitions;                           /**< Cambios reales de estado */
+    uint32_t entries[SYSTEM_STATE_COUNT];           /**< Entradas a cada estado */
+    uint64_t time_in_state_ms[SYSTEM_STATE_COUNT];  /**< Tiempo acumulado (incluye el estado actual) */
+    uint32_t scans;                                 /**< Escaneos completos ejecutados */
+    uint32_t time_to_ip_last_ms;                    /**< Desde el arranque o la última caída hasta CONNECTED */
+    uint32_t time_to_ip_max_ms;
+    uint32_t input_drops;                           /**< Entradas (eventos/botón) perdidas con la cola llena */
+} system_state_stats_t;
+
 void system_state_init(void);
 void system_state_set(system_state_t state);
 system_state_t system_state_get(void);
@@ -24,6 +40,7 @@ void system_state_task(void *pvParameters);
 
 bool system_state_is_connected(void);
 bool system_state_is_provisioning(void);
+void system_state_get_stats(system_state_stats_t *out);
 
 #ifdef __cplusplus
 }
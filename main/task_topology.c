@@ -0,0 +1,85 @@
+#include "task_topology.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "task_topology";
+
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static task_latency_stats_t latency[TASK_LATENCY_COUNT];
+
+typedef struct {
+    const char *name;
+    int core;
+    int prio;
+    int stack;
+} topology_entry_t;
+
+static const topology_entry_t topology[] = {
+    { "system_state", TASK_STATE_CORE, TASK_STATE_PRIO, TASK_STATE_STACK },
+    { "dns_task",     TASK_DNS_CORE,   TASK_DNS_PRIO,   TASK_DNS_STACK },
+    { "httpd",        TASK_HTTPD_CORE, TASK_HTTPD_PRIO, TASK_HTTPD_STACK },
+    { "link_probe",   TASK_PROBE_CORE, TASK_PROBE_PRIO, TASK_PROBE_STACK },
+    { "ota_writer",   TASK_OTA_CORE,   TASK_OTA_PRIO,   TASK_OTA_STACK },
+};
+
+#ifdef CONFIG_WIFI_MGR_LOAD_GEN
+
+#define LOAD_PERIOD_MS   10
+#define LOAD_TASK_STACK  2048
+
+#ifdef CONFIG_FREERTOS_UNICORE
+#define LOAD_CORES 1
+#else
+#define LOAD_CORES 2
+#endif
+
+static StackType_t load_stacks[LOAD_CORES][LOAD_TASK_STACK];
+static StaticTask_t load_tcbs[LOAD_CORES];
+
+// Ocupa la CPU el porcentaje configurado de cada período y cede el resto
+static void load_task(void *arg) {
+    const int64_t busy_us = LOAD_PERIOD_MS * 1000LL * CONFIG_WIFI_MGR_LOAD_GEN_DUTY / 100;
+    while (1) {
+        int64_t end = esp_timer_get_time() + busy_us;
+        while (esp_timer_get_time() < end) { }
+        vTaskDelay(pdMS_TO_TICKS(LOAD_PERIOD_MS));
+    }
+}
+
+#endif // CONFIG_WIFI_MGR_LOAD_GEN
+
+void task_topology_init(void) {
+    for (size_t i = 0; i < sizeof(topology) / sizeof(topology[0]); i++) {
+        ESP_LOGI(TAG, "%-12s core=%2d prio=%2d stack=%d", topology[i].name,
+                 topology[i].core, topology[i].prio, topology[i].stack);
+        if (topology[i].core > TASK_TOPOLOGY_MAX_CORE) {
+            ESP_LOGW(TAG, "%s: el núcleo %d no existe, corre sin afinidad", topology[i].name, topology[i].core);
+        }
+    }
+
+#ifdef CONFIG_WIFI_MGR_LOAD_GEN
+    ESP_LOGW(TAG, "Carga sintética activa: %d%% por núcleo, prioridad %d",
+             CONFIG_WIFI_MGR_LOAD_GEN_DUTY, CONFIG_WIFI_MGR_LOAD_GEN_PRIO);
+    for (int core = 0; core < LOAD_CORES; core++) {
+        xTaskCreateStaticPinnedToCore(load_task, "load_gen", LOAD_TASK_STACK, NULL, CONFIG_WIFI_MGR_LOAD_GEN_PRIO,
+                                      load_stacks[core], &load_tcbs[core], core);
+    }
+#endif
+}
+
+void task_topology_record_latency(task_latency_t which, uint32_t us) {
+    if (which >= TASK_LATENCY_COUNT) return;
+    taskENTER_CRITICAL(&latency_lock);
+    latency[which].samples++;
+    latency[which].total_us += us;
+    if (us > latency[which].max_us) latency[which].max_us = us;
+    taskEXIT_CRITICAL(&latency_lock);
+}
+
+void task_topology_get_latency(task_latency_t which, task_latency_stats_t *out) {
+    if (!out || which >= TASK_LATENCY_COUNT) return;
+    taskENTER_CRITICAL(&latency_lock);
+    memcpy(out, &latency[which], sizeof(*out));
+    taskEXIT_CRITICAL(&latency_lock);
+}
@@ -0,0 +1,77 @@
+#ifndef TASK_TOPOLOGY_H
+#define TASK_TOPOLOGY_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Topología de tareas del componente: núcleo, prioridad y pila de cada tarea, desde Kconfig.
+ * Las pilas son constantes de compilación porque dimensionan los arrays estáticos de cada módulo.
+ * Núcleo -1 = sin afinidad.
+ */
+#define TASK_STATE_CORE        CONFIG_WIFI_MGR_TASK_STATE_CORE
+#define TASK_STATE_PRIO        CONFIG_WIFI_MGR_TASK_STATE_PRIO
+#define TASK_STATE_STACK       CONFIG_WIFI_MGR_TASK_STATE_STACK
+
+#define TASK_DNS_CORE          CONFIG_WIFI_MGR_TASK_DNS_CORE
+#define TASK_DNS_PRIO          CONFIG_WIFI_MGR_TASK_DNS_PRIO
+#define TASK_DNS_STACK         CONFIG_WIFI_MGR_TASK_DNS_STACK
+
+#define TASK_HTTPD_CORE        CONFIG_WIFI_MGR_TASK_HTTPD_CORE
+#define TASK_HTTPD_PRIO        CONFIG_WIFI_MGR_TASK_HTTPD_PRIO
+#define TASK_HTTPD_STACK       CONFIG_WIFI_MGR_TASK_HTTPD_STACK
+
+#define TASK_PROBE_CORE        CONFIG_WIFI_MGR_TASK_PROBE_CORE
+#define TASK_PROBE_PRIO        CONFIG_WIFI_MGR_TASK_PROBE_PRIO
+#define TASK_PROBE_STACK       CONFIG_WIFI_MGR_TASK_PROBE_STACK
+
+#define TASK_OTA_CORE          CONFIG_WIFI_MGR_TASK_OTA_CORE
+#define TASK_OTA_PRIO          CONFIG_WIFI_MGR_TASK_OTA_PRIO
+#define TASK_OTA_STACK         CONFIG_WIFI_MGR_TASK_OTA_STACK
+
+#ifdef CONFIG_FREERTOS_UNICORE
+#define TASK_TOPOLOGY_MAX_CORE 0
+#else
+#define TASK_TOPOLOGY_MAX_CORE 1
+#endif
+
+// Núcleo Kconfig (-1..1) -> BaseType_t de FreeRTOS. Un núcleo inexistente (sdkconfig armado para dual core
+// y luego pasado a unicore) se trata como sin afinidad en vez de fallar al crear la tarea.
+#define TASK_TOPOLOGY_CORE_ID(core) \
+    (((core) < 0 || (core) > TASK_TOPOLOGY_MAX_CORE) ? tskNO_AFFINITY : (BaseType_t)(core))
+
+typedef enum {
+    TASK_LATENCY_STATE_EVENT = 0,   /**< Evento de conn_bus publicado -> consumido por system_state */
+    TASK_LATENCY_HTTP_HANDLER,      /**< Duración de los handlers del portal */
+    TASK_LATENCY_COUNT
+} task_latency_t;
+
+typedef struct {
+    uint32_t samples;
+    uint64_t total_us;
+    uint32_t max_us;
+} task_latency_stats_t;
+
+/**
+ * @brief Registra una muestra de latencia (en us) para el indicador dado.
+ */
+void task_topology_record_latency(task_latency_t which, uint32_t us);
+
+void task_topology_get_latency(task_latency_t which, task_latency_stats_t *out);
+
+/**
+ * @brief Imprime la tabla de topología configurada. Con CONFIG_WIFI_MGR_LOAD_GEN además arranca
+ * una tarea de carga sintética por núcleo, para comparar latencias entre distintas topologías.
+ */
+void task_topology_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_TOPOLOGY_H
@@ -0,0 +1,171 @@
+#include "telemetry.h"
+#include "system_state.h"
+#include "wifi_scanner.h"
+#include "wifi_manager.h"
+#include "link_probe.h"
+#include "album_refresh.h"
+#include "mem_report.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <lwip/sockets.h>
+#include <stdio.h>
+#include <string.h>
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_stats_t stats = {0};
+
+#ifdef CONFIG_WIFI_MGR_TELEMETRY
+
+static const char *TAG = "telemetry";
+
+#define TELEMETRY_PAYLOAD CONFIG_WIFI_MGR_TELEMETRY_PAYLOAD // Por debajo del MTU: nunca se fragmenta
+#define TELEMETRY_LINE_MAX 80
+
+static char batch[TELEMETRY_PAYLOAD];
+static size_t batch_len = 0;
+static int sock = -1;
+static struct sockaddr_in collector;
+static bool collector_ok = false;
+static char prefix[24];              // "wifimgr.a1b2c3.": los últimos 3 bytes de la MAC identifican al equipo
+static TickType_t next_push = 0;
+static uint32_t sent_connects = 0;   // Entradas a CONNECTED ya reportadas como muestra de time-to-IP
+
+// Solo con IP literal: resolver un nombre bloquearía la tarea de estados
+static bool open_socket(void) {
+    if (sock >= 0) return true;
+    if (!collector_ok) {
+        memset(&collector, 0, sizeof(collector));
+        collector.sin_family = AF_INET;
+        collector.sin_port = htons(CONFIG_WIFI_MGR_TELEMETRY_PORT);
+        if (inet_pton(AF_INET, CONFIG_WIFI_MGR_TELEMETRY_HOST, &collector.sin_addr) != 1) {
+            ESP_LOGE(TAG, "Colector inválido '%s' (se espera una IPv4)", CONFIG_WIFI_MGR_TELEMETRY_HOST);
+            return false;
+        }
+        uint8_t mac[6] = {0};
+        esp_wifi_get_mac(WIFI_IF_STA, mac);
+        snprintf(prefix, sizeof(prefix), "wifimgr.%02x%02x%02x.", mac[3], mac[4], mac[5]);
+        collector_ok = true;
+    }
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGW(TAG, "Sin socket UDP (errno %d)", errno);
+        return false;
+    }
+    return true;
+}
+
+static void flush(void) {
+    if (batch_len == 0) return;
+    int r = sendto(sock, batch, batch_len, MSG_DONTWAIT, (struct sockaddr *)&collector, sizeof(collector));
+    taskENTER_CRITICAL(&stats_lock);
+    if (r == (int)batch_len) {
+        stats.datagrams++;
+        stats.bytes += (uint64_t)r;
+    } else {
+        stats.dropped++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    batch_len = 0;
+}
+
+// Una línea StatsD; si no entra en el datagrama en curso, se despacha el actual y se empieza otro
+static void put(const char *name, long long value, const char *type) {
+    char line[TELEMETRY_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "%s%s:%lld|%s\n", prefix, name, value, type);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    if (batch_len + (size_t)n > sizeof(batch)) flush();
+    memcpy(batch + batch_len, line, (size_t)n);
+    batch_len += (size_t)n;
+}
+
+static void push(void) {
+    char name[40];
+
+    system_state_stats_t ss;
+    system_state_get_stats(&ss);
+    put("state.current", system_state_get(), "g");
+    put("state.transitions", ss.transitions, "g");
+    put("state.scans", ss.scans, "g");
+    // El time-to-IP es una muestra por conexión: se envía una sola vez como timing
+    if (ss.entries[SYSTEM_STATE_CONNECTED] != sent_connects) {
+        sent_connects = ss.entries[SYSTEM_STATE_CONNECTED];
+        put("state.time_to_ip", ss.time_to_ip_last_ms, "ms");
+    }
+
+    static const char *scan_kinds[WIFI_SCANNER_KIND_COUNT] = { "full_active", "full_passive", "slice", "targeted" };
+    wifi_scanner_radio_stats_t radio;
+    wifi_scanner_get_radio_stats(&radio);
+    for (int k = 0; k < WIFI_SCANNER_KIND_COUNT; k++) {
+        snprintf(name, sizeof(name), "scan.%s.count", scan_kinds[k]);
+        put(name, radio.scans[k], "g");
+        snprintf(name, sizeof(name), "scan.%s.radio_ms", scan_kinds[k]);
+        put(name, (long long)radio.radio_ms[k], "g");
+    }
+    album_refresh_stats_t ar;
+    album_refresh_get_stats(&ar);
+    uint32_t album_age = wifi_scanner_get_album_age_ms();
+    if (album_age != WIFI_SCANNER_ALBUM_NEVER) put("scan.album_age_ms", album_age, "g");
+    put("scan.album_deferred", ar.deferred, "g");
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        put("wifi.rssi", ap.rssi, "g");
+        put("wifi.channel", ap.primary, "g");
+    }
+    wifi_manager_psk_stats_t psk;
+    wifi_manager_get_psk_stats(&psk);
+    put("wifi.connects_psk", psk.connects_psk, "g");
+    put("wifi.connects_passphrase", psk.connects_passphrase, "g");
+    if (psk.connect_us_psk) put("wifi.connect_us_psk", psk.connect_us_psk, "g");
+    if (psk.connect_us_passphrase) put("wifi.connect_us_passphrase", psk.connect_us_passphrase, "g");
+
+    link_probe_stats_t lp;
+    link_probe_get_stats(&lp);
+    put("probe.rtt_avg_us", lp.rtt_us_avg, "g");
+    put("probe.loss_pct", lp.loss_pct, "g");
+
+    put("heap.free", heap_caps_get_free_size(MALLOC_CAP_INTERNAL), "g");
+
+    telemetry_stats_t own;
+    telemetry_get_stats(&own);
+    put("telemetry.dropped", own.dropped, "g");
+    flush();
+}
+
+#endif // CONFIG_WIFI_MGR_TELEMETRY
+
+void telemetry_init(void) {
+#ifdef CONFIG_WIFI_MGR_TELEMETRY
+    mem_report_register("telemetry", NULL, 0, sizeof(batch) + sizeof(prefix) + sizeof(collector) + sizeof(stats));
+#endif
+}
+
+void telemetry_reset(void) {
+#ifdef CONFIG_WIFI_MGR_TELEMETRY
+    next_push = xTaskGetTickCount();
+#endif
+}
+
+void telemetry_tick(void) {
+#ifdef CONFIG_WIFI_MGR_TELEMETRY
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(now - next_push) < 0) return;
+    next_push = now + pdMS_TO_TICKS(CONFIG_WIFI_MGR_TELEMETRY_INTERVAL_S * 1000);
+    if (!open_socket()) return;
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.pushes++;
+    taskEXIT_CRITICAL(&stats_lock);
+    push();
+#endif
+}
+
+void telemetry_get_stats(telemetry_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(stats));
+    taskEXIT_CRITICAL(&stats_lock);
+}
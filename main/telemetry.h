@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t pushes;            /**< Rondas de envío ejecutadas */
+    uint32_t datagrams;         /**< Datagramas aceptados por el stack */
+    uint32_t dropped;           /**< Datagramas descartados (sin buffers, sin ruta): nunca se reintentan */
+    uint64_t bytes;
+} telemetry_stats_t;
+
+/**
+ * @brief Registra los buffers del exportador en mem_report. Llamar una vez al arranque.
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Reinicia la planificación (nueva asociación): la primera ronda sale en el próximo tick,
+ * así el colector recibe el time-to-IP de esta conexión de inmediato.
+ */
+void telemetry_reset(void);
+
+/**
+ * @brief Paso del exportador. Lo llama la tarea de estados en CONNECTED; cada
+ * CONFIG_WIFI_MGR_TELEMETRY_INTERVAL_S arma líneas StatsD en un buffer estático y las envía por UDP
+ * sin bloquear (lo que no entra en el stack se descarta).
+ */
+void telemetry_tick(void);
+
+void telemetry_get_stats(telemetry_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
@@ -1,27 +1,42 @@
 #include "wifi_manager.h"
 #include "storage_nvs.h"
 #include "led_status.h"
+#include "dns_server.h"
+#include "conn_bus.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
+#include "mbedtls/pkcs5.h"
 #include <string.h>
 
 #define DEFAULT_WIFI_SSID "Redmi Note 8"
 #define DEFAULT_WIFI_PASS "649dc38bf950"
-#define WIFI_CONNECTED_BIT BIT0
 
 static const char *TAG = "wifi_manager";
-static EventGroupHandle_t wifi_event_group;
-static bool wifi_connected = false;
-static char ip_str[16] = {0};
-static uint8_t last_disconnect_reason = 0;
+// El estado de conectividad (conectado, IP, última razón) vive en conn_bus: una sola foto consistente
 
 static char saved_ssid[WIFI_SSID_MAX_LEN] = {0};
 static char saved_pass[WIFI_PASS_MAX_LEN] = {0};
 
+// PMK derivada de saved_ssid/saved_pass: con ella el driver no corre el PBKDF2 (4096 iteraciones) en cada connect
+#define WPA_PBKDF2_ITERATIONS 4096
+static uint8_t saved_psk[WIFI_PSK_LEN];
+static bool have_psk = false;
+static portMUX_TYPE psk_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_manager_psk_stats_t psk_stats = {0};
+static bool sta_uses_psk = false;   // Qué secreto lleva la última config enviada al driver
+static int64_t connect_t0_us = 0;   // esp_wifi_connect() pendiente de STA_CONNECTED (0 = ninguno)
+
+// Con WIFI_PS_MAX_MODEM el radio despierta cada listen_interval beacons; 0 deja el default del driver (3)
+#ifdef CONFIG_WIFI_MGR_PS_IDLE_MAX_MODEM
+#define STA_LISTEN_INTERVAL CONFIG_WIFI_MGR_PS_LISTEN_INTERVAL
+#else
+#define STA_LISTEN_INTERVAL 0
+#endif
+
 /* Declaración interna del handler */
 static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                                int32_t event_id, void *event_data);
@@ -29,15 +44,21 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
 /* --- FUNCIONES DE CONSULTA --- */
 
 uint8_t wifi_manager_get_last_disconnect_reason(void) {
-    return last_disconnect_reason;
+    conn_status_t st;
+    conn_bus_get_status(&st);
+    return st.last_reason;
 }
 
 bool wifi_manager_is_connected(void) {
-    return wifi_connected;
+    conn_status_t st;
+    conn_bus_get_status(&st);
+    return st.connected;
 }
 
-const char* wifi_manager_get_ip(void) {
-    return wifi_connected ? ip_str : "0.0.0.0";
+void wifi_manager_get_ip(char *out, size_t len) {
+    conn_status_t st;
+    conn_bus_get_status(&st);
+    if (out && len > 0) snprintf(out, len, "%s", st.ip_str);
 }
 
 // Esta es la función que system_state.c usará para grabar en NVS
@@ -46,16 +67,43 @@ void wifi_manager_get_credentials(char *ssid_out, char *pass_out) {
     if (pass_out) strcpy(pass_out, saved_pass);
 }
 
+/* --- CREDENCIALES HACIA EL DRIVER --- */
+
+// Con PSK derivada, el campo password lleva 64 caracteres hex (sin terminador): el driver la usa como PMK
+static void fill_sta_credentials(wifi_config_t *cfg) {
+    static const char hex[] = "0123456789abcdef";
+    strncpy((char *)cfg->sta.ssid, saved_ssid, sizeof(cfg->sta.ssid));
+    cfg->sta.listen_interval = STA_LISTEN_INTERVAL; // Toda config STA pasa por aquí
+    sta_uses_psk = have_psk;
+    if (sta_uses_psk) {
+        for (int i = 0; i < WIFI_PSK_LEN; i++) {
+            cfg->sta.password[2 * i] = hex[saved_psk[i] >> 4];
+            cfg->sta.password[2 * i + 1] = hex[saved_psk[i] & 0x0f];
+        }
+    } else {
+        strncpy((char *)cfg->sta.password, saved_pass, sizeof(cfg->sta.password));
+    }
+    taskENTER_CRITICAL(&psk_lock);
+    if (sta_uses_psk) psk_stats.connects_psk++;
+    else psk_stats.connects_passphrase++;
+    taskEXIT_CRITICAL(&psk_lock);
+}
+
+// Todo connect pasa por aquí: STA_CONNECTED mide desde este instante (incluye el PBKDF2 del driver)
+static void sta_connect(void) {
+    connect_t0_us = esp_timer_get_time();
+    esp_wifi_connect();
+}
+
 /* --- LOGICA DE CONTROL --- */
 
 void wifi_manager_init(void) {
-    if (wifi_event_group == NULL) wifi_event_group = xEventGroupCreate();
-    
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, NULL));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_LOST_IP, &wifi_event_handler, NULL, NULL));
 
     esp_netif_create_default_wifi_sta();
     esp_netif_create_default_wifi_ap();
@@ -64,52 +112,166 @@ void wifi_manager_init(void) {
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
     ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
 
-    wifi_config_t sta_config = { .sta = { .scan_method = WIFI_FAST_SCAN, .failure_retry_cnt = 0 } };
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
+    // Solo STA: el AP se levanta con el portal (wifi_provisioning_start pasa a APSTA).
+    // En APSTA el driver ignora esp_wifi_set_ps, así que el ahorro de power_save requiere este modo.
+    wifi_config_t sta_config = { .sta = { .scan_method = WIFI_FAST_SCAN, .failure_retry_cnt = 0,
+                                          .listen_interval = STA_LISTEN_INTERVAL } };
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta_config));
-    esp_wifi_set_ps(WIFI_PS_NONE);
+    // El modo de ahorro lo decide power_save según el tráfico medido
 
     ESP_LOGI(TAG, "Driver inicializado.");
 }
 
+void wifi_manager_start(void) {
+#ifdef CONFIG_WIFI_MGR_FAST_BOOT
+    // Fast boot: con credenciales en NVS, el connect() de STA_START ya apunta a la red guardada
+    char ssid[WIFI_SSID_MAX_LEN], pass[WIFI_PASS_MAX_LEN];
+    if (storage_load_wifi_credentials(ssid, pass)) {
+        wifi_manager_set_credentials(ssid, pass);
+        wifi_config_t wifi_config = { .sta = { .scan_method = WIFI_FAST_SCAN, .failure_retry_cnt = 0 } };
+        fill_sta_credentials(&wifi_config);
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        ESP_LOGI(TAG, "Fast boot: conectando a '%s' sin escaneo previo%s.", saved_ssid, have_psk ? " (PSK guardada)" : "");
+    }
+#endif
+    esp_err_t err = esp_wifi_start();
+    if (err != ESP_OK) ESP_LOGE(TAG, "esp_wifi_start falló: %s", esp_err_to_name(err));
+}
+
 void wifi_manager_set_credentials(const char* ssid, const char* password) {
+    char prev_ssid[WIFI_SSID_MAX_LEN], prev_pass[WIFI_PASS_MAX_LEN];
+    memcpy(prev_ssid, saved_ssid, sizeof(prev_ssid));
+    memcpy(prev_pass, saved_pass, sizeof(prev_pass));
+
     if (ssid) strncpy(saved_ssid, ssid, sizeof(saved_ssid) - 1);
     if (password) strncpy(saved_pass, password, sizeof(saved_pass) - 1);
+
+    // Credenciales distintas: la PSK vieja ya no sirve; si estas son las de la NVS, se recupera la suya
+    if (have_psk && memcmp(prev_ssid, saved_ssid, sizeof(prev_ssid)) == 0 &&
+        memcmp(prev_pass, saved_pass, sizeof(prev_pass)) == 0) {
+        return;
+    }
+    have_psk = storage_load_wifi_psk(saved_ssid, saved_pass, saved_psk);
+}
+
+bool wifi_manager_cache_psk(void) {
+    size_t pass_len = strlen(saved_pass);
+    if (have_psk) return true;
+    if (pass_len < 8 || pass_len > 63) return false; // Red abierta, o la clave ya es una PSK en hex
+
+    // WPA3/SAE (y el modo de transición) necesitan la passphrase: ahí no se fija la PSK
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return false;
+    if (ap.authmode != WIFI_AUTH_WPA_PSK && ap.authmode != WIFI_AUTH_WPA2_PSK && ap.authmode != WIFI_AUTH_WPA_WPA2_PSK) {
+        return false;
+    }
+
+    uint8_t psk[WIFI_PSK_LEN];
+    int64_t t0 = esp_timer_get_time();
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1, (const unsigned char *)saved_pass, pass_len,
+                                            (const unsigned char *)saved_ssid, strlen(saved_ssid),
+                                            WPA_PBKDF2_ITERATIONS, WIFI_PSK_LEN, psk);
+    uint32_t derive_us = (uint32_t)(esp_timer_get_time() - t0);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "No se pudo derivar la PSK (%d)", ret);
+        return false;
+    }
+    if (!storage_save_wifi_psk(saved_ssid, saved_pass, psk)) return false;
+
+    memcpy(saved_psk, psk, sizeof(saved_psk));
+    have_psk = true;
+    taskENTER_CRITICAL(&psk_lock);
+    psk_stats.derive_us = derive_us;
+    taskEXIT_CRITICAL(&psk_lock);
+    ESP_LOGI(TAG, "PSK derivada en %lu ms y guardada: los próximos connect no repiten el PBKDF2",
+             (unsigned long)(derive_us / 1000));
+    return true;
+}
+
+bool wifi_manager_forget_psk(void) {
+    bool was_used = sta_uses_psk;
+    if (!have_psk) return false;
+
+    have_psk = false;
+    sta_uses_psk = false;
+    storage_clear_wifi_psk();
+    ESP_LOGW(TAG, "PSK guardada descartada: los connect vuelven a la passphrase");
+    return was_used;
+}
+
+void wifi_manager_get_psk_stats(wifi_manager_psk_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&psk_lock);
+    memcpy(out, &psk_stats, sizeof(psk_stats));
+    out->psk_stored = have_psk;
+    taskEXIT_CRITICAL(&psk_lock);
 }
 
 void wifi_manager_reconnect(void) {
     wifi_config_t wifi_config = {0};
-    strncpy((char *)wifi_config.sta.ssid, saved_ssid, 32);
-    strncpy((char *)wifi_config.sta.password, saved_pass, 64);
+    fill_sta_credentials(&wifi_config);
     esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
     esp_wifi_disconnect();
-    esp_wifi_connect();
+    sta_connect();
+}
+
+void wifi_manager_connect_bssid(const uint8_t bssid[6], uint8_t channel) {
+    wifi_config_t wifi_config = {0};
+    fill_sta_credentials(&wifi_config);
+    wifi_config.sta.bssid_set = true;
+    memcpy(wifi_config.sta.bssid, bssid, 6);
+    wifi_config.sta.channel = channel;
+
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    esp_wifi_disconnect();
+    sta_connect();
 }
 
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        sta_connect(); // Con credenciales precargadas esto ya es el primer intento real (fast boot)
+        conn_bus_publish(CONN_EVT_STA_START, 0, 0);
     } 
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        if (connect_t0_us != 0) {
+            uint32_t connect_us = (uint32_t)(esp_timer_get_time() - connect_t0_us);
+            connect_t0_us = 0;
+            taskENTER_CRITICAL(&psk_lock);
+            if (sta_uses_psk) psk_stats.connect_us_psk = connect_us;
+            else psk_stats.connect_us_passphrase = connect_us;
+            taskEXIT_CRITICAL(&psk_lock);
+        }
+        conn_bus_publish(CONN_EVT_STA_CONNECTED, 0, 0);
+    }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
-        last_disconnect_reason = event->reason;
-        wifi_connected = false;
-        if (wifi_event_group) xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
-        ESP_LOGW(TAG, "Desconectado. Razón: %d", last_disconnect_reason);
+        connect_t0_us = 0; // Un intento fallido no es una muestra
+        dns_server_set_upstream(0, 0); // Sin uplink: el DNS del SoftAP vuelve a secuestrar todo
+        conn_bus_publish(CONN_EVT_STA_DISCONNECTED, event->reason, 0);
+        ESP_LOGW(TAG, "Desconectado. Razón: %d", event->reason);
     } 
+    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        dns_server_set_upstream(0, 0);
+        conn_bus_publish(CONN_EVT_LOST_IP, 0, 0);
+        ESP_LOGW(TAG, "IP perdida.");
+    }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&event->ip_info.ip));
-        wifi_connected = true;
-        last_disconnect_reason = 0;
-        if (wifi_event_group) xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
-        ESP_LOGI(TAG, "IP: %s", ip_str);
+        ESP_LOGI(TAG, "IP: " IPSTR, IP2STR(&event->ip_info.ip));
+
+        // Con uplink, los clientes del SoftAP pueden resolver nombres reales a través del DNS de la STA
+        esp_netif_dns_info_t dns_info;
+        if (esp_netif_get_dns_info(event->esp_netif, ESP_NETIF_DNS_MAIN, &dns_info) == ESP_OK) {
+            dns_server_set_upstream(dns_info.ip.u_addr.ip4.addr, 0);
+        }
+
+        // Publicamos al final: cuando los suscriptores reaccionen, el forwarder ya está listo
+        conn_bus_publish(CONN_EVT_GOT_IP, 0, event->ip_info.ip.addr);
     }
 }
 
 void wifi_manager_reset_last_disconnect_reason(void) {
-    last_disconnect_reason = 0;
+    conn_bus_clear_reason();
     ESP_LOGI("WIFI_MGR", "Razón de desconexión reseteada.");
-}
-
-EventGroupHandle_t wifi_manager_get_event_group(void) { return wifi_event_group; }
\ No newline at end of file
+}
\ No newline at end of file
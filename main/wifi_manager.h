@@ -5,8 +5,7 @@
 #include <stdint.h>
 #include "esp_wifi_types.h" // Necesario para wifi_mode_t
 #include "esp_wifi.h" // Asegura que reconozca los tipos de WiFi
-#include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,7 +23,8 @@ extern "C" {
 void wifi_manager_init(void);
 
 /**
- * @brief Configura y arranca el Wi-Fi.
+ * @brief Configura y arranca el Wi-Fi. Con CONFIG_WIFI_MGR_FAST_BOOT precarga las credenciales
+ * de la NVS, de modo que el STA_START dispara directamente el primer intento de conexión.
  */
 void wifi_manager_start(void);
 
@@ -37,7 +37,13 @@ void wifi_manager_stop(void);
  * @brief Fuerza una reconexión (desconecta y vuelve a conectar).
  */
 void wifi_manager_reconnect(void);
-EventGroupHandle_t wifi_manager_get_event_group(void);
+
+/**
+ * @brief Re-asocia con las credenciales actuales pero fijando un AP concreto (roaming).
+ * @param bssid MAC del AP destino.
+ * @param channel Canal del AP destino (evita barrer todos los canales).
+ */
+void wifi_manager_connect_bssid(const uint8_t bssid[6], uint8_t channel);
 
 /* --- Funciones de Configuración (Nuevas) --- */
 
@@ -52,6 +58,33 @@ void wifi_manager_set_credentials(const char* ssid, const char* password);
  */
 void wifi_manager_set_mode(wifi_mode_t mode);
 
+/**
+ * @brief Tras una conexión exitosa con credenciales ya guardadas: deriva una vez la PSK de WPA2
+ * (PBKDF2-SHA1, 4096 iteraciones) y la guarda junto a las credenciales. Desde entonces el driver
+ * recibe la PSK en hex y los connect (reintentos y arranques) se saltean la derivación.
+ * No aplica a redes abiertas ni a WPA3/SAE, que necesitan la passphrase.
+ * @return true si hay una PSK en uso.
+ */
+bool wifi_manager_cache_psk(void);
+
+/**
+ * @brief El AP rechazó las credenciales: descarta la PSK (RAM y NVS) para que los próximos connect
+ * lleven la passphrase. Así se recupera un AP que pasó a WPA3/SAE, donde la PSK en hex no sirve.
+ * @return true si la config rechazada llevaba la PSK (vale reintentar con la passphrase).
+ */
+bool wifi_manager_forget_psk(void);
+
+typedef struct {
+    bool psk_stored;               /**< Los connect usan la PSK guardada */
+    uint32_t derive_us;            /**< Costo medido del PBKDF2 (lo que ahorra cada connect) */
+    uint32_t connects_psk;         /**< Configuraciones enviadas al driver con PSK */
+    uint32_t connects_passphrase;  /**< ... y con passphrase (el driver deriva) */
+    uint32_t connect_us_psk;       /**< Último connect→STA_CONNECTED con PSK (0 = sin medir) */
+    uint32_t connect_us_passphrase;/**< ... y con passphrase: la diferencia es el ahorro real */
+} wifi_manager_psk_stats_t;
+
+void wifi_manager_get_psk_stats(wifi_manager_psk_stats_t *out);
+
 /* --- Funciones de Estado --- */
 
 /**
@@ -65,9 +98,10 @@ bool wifi_manager_is_connected(void);
 bool wifi_manager_wait_connected(uint32_t timeout_ms);
 
 /**
- * @brief Retorna la dirección IP actual en formato string.
+ * @brief Copia la dirección IP actual en formato string ("0.0.0.0" sin conexión).
+ * Se copia desde la foto de conn_bus, nunca se entrega un puntero a un buffer que otra tarea escribe.
  */
-const char* wifi_manager_get_ip(void);
+void wifi_manager_get_ip(char *out, size_t len);
 
 /**
  * @brief Obtiene el código de razón de la última desconexión.
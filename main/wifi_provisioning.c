@@ -6,19 +6,29 @@
 #include "lwip/ip_addr.h"
 #include <string.h>
 
+#include "portal_services.h"
+#include "wifi_manager.h"
 #include "http_server.h"
-#include "dns_server.h" 
 
 #define PROVISIONING_AP_SSID  "ESP32_Setup"
 #define PROVISIONING_AP_PASS  "12345678"
-#define PROVISIONING_CHANNEL  6
+#define PROVISIONING_CHANNEL  6   // Preferido si el álbum no muestra diferencias
+#define PROVISIONING_MAX_CHANNEL 11 // Canales 12/13 no están permitidos en todos los países
 #define MAX_STA_CONN          4
 
+#ifdef CONFIG_WIFI_MGR_CAPPORT_API
+// lwIP guarda el puntero (no copia): el URI tiene que vivir mientras corra el DHCP del SoftAP
+static char capport_uri[] = "http://192.168.4.1" HTTP_CAPPORT_API_PATH;
+#endif
+
 static const char *TAG = "wifi_provisioning";
 
 static bool provisioning_active = false;
 static bool has_creds = false;
 static wifi_credentials_t captured_creds;
+static volatile wifi_prov_test_result_t test_result = WIFI_PROV_TEST_IDLE;
+static volatile uint8_t test_reason = 0;
+static wifi_prov_channel_report_t channel_report;
 
 void wifi_provisioning_init(void)
 {
@@ -26,10 +36,43 @@ void wifi_provisioning_init(void)
     memset(&captured_creds, 0, sizeof(wifi_credentials_t));
 }
 
+/**
+ * Elige el canal del SoftAP. Con un enlace STA activo el radio solo puede estar en un canal,
+ * así que se sigue al AP; si no, se toma el canal menos ocupado según el álbum.
+ */
+static uint8_t select_ap_channel(void)
+{
+    // Orden de preferencia ante empates: 6, 1, 11 (no solapados) y luego el resto
+    static const uint8_t candidates[] = { PROVISIONING_CHANNEL, 1, 11, 2, 3, 4, 5, 7, 8, 9, 10 };
+
+    memset(&channel_report, 0, sizeof(channel_report));
+    wifi_scanner_score_channels(channel_report.score, channel_report.ap_count);
+
+    wifi_ap_record_t sta_ap;
+    if (wifi_manager_is_connected() && esp_wifi_sta_get_ap_info(&sta_ap) == ESP_OK) {
+        channel_report.channel = sta_ap.primary;
+        channel_report.follows_sta = true;
+        ESP_LOGI(TAG, "Canal SoftAP: %d (sigue al enlace STA)", sta_ap.primary);
+        return sta_ap.primary;
+    }
+
+    uint8_t best = candidates[0];
+    for (int i = 1; i < (int)sizeof(candidates); i++) {
+        if (candidates[i] > PROVISIONING_MAX_CHANNEL) continue;
+        if (channel_report.score[candidates[i]] < channel_report.score[best]) best = candidates[i];
+    }
+    channel_report.channel = best;
+    ESP_LOGI(TAG, "Canal SoftAP: %d (puntaje %lu, %d APs en el canal)",
+             best, (unsigned long)channel_report.score[best], channel_report.ap_count[best]);
+    return best;
+}
+
 void wifi_provisioning_start(void)
 {
     if (provisioning_active) return;
     ESP_LOGI(TAG, "Iniciando SoftAP de configuracion...");
+    test_result = WIFI_PROV_TEST_IDLE;
+    test_reason = 0;
 
     // 1. NO HACEMOS STOP. El radio ya está encendido desde el BOOT.
     // Solo cambiamos el modo para no perder la capacidad de cliente (STA)
@@ -40,7 +83,7 @@ void wifi_provisioning_start(void)
         .ap = {
             .ssid = "ESP32_OPEN_TEST",
             .ssid_len = 0,
-            .channel = 1,
+            .channel = select_ap_channel(),
             .max_connection = 4,
             .authmode = WIFI_AUTH_OPEN 
         },
@@ -58,13 +101,18 @@ void wifi_provisioning_start(void)
         IP4_ADDR(&ip_info.gw, 192, 168, 4, 1);
         IP4_ADDR(&ip_info.netmask, 255, 255, 255, 0);
         esp_netif_set_ip_info(netif_ap, &ip_info);
+#ifdef CONFIG_WIFI_MGR_CAPPORT_API
+        // Opción 114: el cliente pregunta a la API en vez de adivinar con sondas de conectividad
+        esp_err_t err = esp_netif_dhcps_option(netif_ap, ESP_NETIF_OP_SET, ESP_NETIF_CAPTIVEPORTAL_URI,
+                                               capport_uri, strlen(capport_uri));
+        if (err != ESP_OK) ESP_LOGW(TAG, "DHCP sin opción 114 (%s)", esp_err_to_name(err));
+#endif
         esp_netif_dhcps_start(netif_ap);
         ESP_LOGI(TAG, "Red configurada en 192.168.4.1");
     }
 
-    // 4. Lanzar servicios (HTTP y DNS Captive Portal)
-    http_server_start();
-    dns_server_start();
+    // 4. Reanudar servicios (HTTP y DNS Captive Portal). Se crean una sola vez.
+    portal_services_acquire(PORTAL_OWNER_PROVISIONING);
 
     provisioning_active = true;
 }
@@ -74,13 +122,14 @@ void wifi_provisioning_stop(void)
     if (!provisioning_active) return;
     ESP_LOGI(TAG, "Deteniendo modo provision");
 
-    http_server_stop();
-    dns_server_stop();
+    portal_services_release(PORTAL_OWNER_PROVISIONING);
     
     // IMPORTANTE: No apagamos el radio (stop), solo limpiamos la config del AP
     // para que el radio quede libre para la conexión STA.
     wifi_config_t empty_ap_config = {0};
     esp_wifi_set_config(WIFI_IF_AP, &empty_ap_config);
+    // Sin AP el radio vuelve a solo STA: en APSTA el driver no aplica ningún modo de ahorro
+    esp_wifi_set_mode(WIFI_MODE_STA);
 
     provisioning_active = false;
 }
@@ -110,4 +159,21 @@ void wifi_provisioning_get_credentials(wifi_credentials_t *creds)
         memcpy(creds, &captured_creds, sizeof(wifi_credentials_t));
         has_creds = false; // IMPORTANTE: Resetear para que el cerebro no re-procese
     }
+}
+
+void wifi_provisioning_set_test_result(wifi_prov_test_result_t result, uint8_t reason)
+{
+    test_reason = reason;
+    test_result = result;
+}
+
+wifi_prov_test_result_t wifi_provisioning_get_test_result(uint8_t *reason_out)
+{
+    if (reason_out) *reason_out = test_reason;
+    return test_result;
+}
+
+void wifi_provisioning_get_channel_report(wifi_prov_channel_report_t *out)
+{
+    if (out) memcpy(out, &channel_report, sizeof(channel_report));
 }
\ No newline at end of file
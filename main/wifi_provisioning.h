@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "wifi_scanner.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +14,26 @@ typedef struct {
     char password[64];
 } wifi_credentials_t;
 
+/**
+ * @brief Resultado de la prueba de credenciales, informado en vivo al portal.
+ */
+typedef enum {
+    WIFI_PROV_TEST_IDLE = 0,   /**< Sin prueba en curso */
+    WIFI_PROV_TEST_RUNNING,    /**< Probando en APSTA con el portal arriba */
+    WIFI_PROV_TEST_SUCCESS,    /**< GOT_IP confirmado, el portal se cierra tras la gracia */
+    WIFI_PROV_TEST_FAILED      /**< Falló: se restauraron las credenciales anteriores */
+} wifi_prov_test_result_t;
+
+/**
+ * @brief Canal elegido para el SoftAP y los puntajes que lo justificaron.
+ */
+typedef struct {
+    uint8_t channel;                            /**< Canal aplicado al SoftAP */
+    bool follows_sta;                           /**< true si se copió el canal del enlace STA */
+    uint32_t score[WIFI_SCANNER_MAX_24G_CHANNEL + 1];   /**< Ocupación por canal (menor = más libre) */
+    uint8_t ap_count[WIFI_SCANNER_MAX_24G_CHANNEL + 1]; /**< APs con ese canal primario */
+} wifi_prov_channel_report_t;
+
 void wifi_provisioning_init(void);
 void wifi_provisioning_start(void);
 void wifi_provisioning_stop(void);
@@ -33,6 +54,23 @@ bool wifi_provisioning_has_new_credentials(void);
  */
 void wifi_provisioning_get_credentials(wifi_credentials_t *creds);
 
+/**
+ * @brief Registra el resultado de la prueba de credenciales (lo llama el sistema de estados).
+ * @param reason Código de razón de desconexión si falló, 0 en otro caso.
+ */
+void wifi_provisioning_set_test_result(wifi_prov_test_result_t result, uint8_t reason);
+
+/**
+ * @brief Obtiene el resultado de la última prueba (lo consulta el servidor HTTP).
+ * @param reason_out Opcional: razón de la falla.
+ */
+wifi_prov_test_result_t wifi_provisioning_get_test_result(uint8_t *reason_out);
+
+/**
+ * @brief Copia el reporte de la última elección de canal del SoftAP (para /metrics).
+ */
+void wifi_provisioning_get_channel_report(wifi_prov_channel_report_t *out);
+
 #ifdef __cplusplus
 }
 #endif
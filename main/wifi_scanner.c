@@ -2,16 +2,155 @@
 #include <string.h>
 #include "esp_wifi.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "mem_report.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
 
 static const char *TAG = "wifi_scanner";
 
+// Tiempo de radio en escaneo, por tipo: es lo que cuesta energía en los equipos a batería
+static portMUX_TYPE radio_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_scanner_radio_stats_t radio_stats = {0};
+
+static wifi_scanner_plan_stats_t plan_stats = {0};
+
+static void record_radio(wifi_scanner_kind_t kind, int64_t start_us) {
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    taskENTER_CRITICAL(&radio_lock);
+    radio_stats.scans[kind]++;
+    radio_stats.radio_ms[kind] += ms;
+    taskEXIT_CRITICAL(&radio_lock);
+}
+
+// Canales de 5 GHz del plan; el driver rechaza los que el país no permite (el paso se salta).
+// Los no DFS también los recorre el refresco en segundo plano; DFS solo el escaneo completo.
+#if SOC_WIFI_SUPPORT_5G
+static const uint8_t channels_5g[] = { 36, 40, 44, 48, 149, 153, 157, 161, 165 };
+#ifdef CONFIG_WIFI_MGR_SCAN_DFS
+static const uint8_t channels_dfs[] = { 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 144 };
+#endif
+#endif
+
 // --- El ÁLBUM (Memoria RAM Estática) ---
-static wifi_scan_result_t g_scan_album[20];
-static int g_networks_found = 0;
+// Lo escribe la tarea de estados (escaneo completo y refresco por canal) y lo leen httpd y roaming:
+// todo acceso va bajo album_lock, sin logs ni llamadas al driver adentro.
+typedef struct {
+    wifi_scan_result_t entries[20];
+    int count;
+    int64_t time_us;                                        // Momento de la foto (-1: nunca)
+    int64_t channel_time_us[WIFI_SCANNER_MAX_24G_CHANNEL + 1]; // Último refresco de cada canal (0: no está en el álbum)
+#if SOC_WIFI_SUPPORT_5G
+    int64_t time_5g_us[sizeof(channels_5g)];                // Como channel_time_us, por índice en channels_5g
+#endif
+} album_t;
+
+// Dos buffers: el escaneo completo arma la foto en el que no está publicado (solo la tarea de estados)
+// y la publica cambiando el puntero. Durante el plan los lectores siguen viendo el álbum anterior entero.
+static portMUX_TYPE album_lock = portMUX_INITIALIZER_UNLOCKED;
+static album_t g_albums[2] = { { .time_us = -1 }, { .time_us = -1 } };
+static album_t *g_album = &g_albums[0];
+
+// Momento del último escaneo de 'channel' en el álbum; NULL si su antigüedad no se sigue (DFS)
+static int64_t *channel_time(album_t *a, uint8_t channel) {
+    if (channel >= 1 && channel <= WIFI_SCANNER_MAX_24G_CHANNEL) return &a->channel_time_us[channel];
+#if SOC_WIFI_SUPPORT_5G
+    for (size_t i = 0; i < sizeof(channels_5g); i++) {
+        if (channels_5g[i] == channel) return &a->time_5g_us[i];
+    }
+#endif
+    return NULL;
+}
+
+// Canales de 2.4 GHz que permite el país (los mismos para el plan y para el refresco)
+static uint8_t country_channels_2g(uint8_t ch[WIFI_SCANNER_MAX_24G_CHANNEL]) {
+    wifi_country_t country;
+    uint8_t first = 1, last = WIFI_SCANNER_MAX_24G_CHANNEL, n = 0;
+    if (esp_wifi_get_country(&country) == ESP_OK && country.nchan > 0) {
+        first = country.schan;
+        last = country.schan + country.nchan - 1;
+        if (last > WIFI_SCANNER_MAX_24G_CHANNEL) last = WIFI_SCANNER_MAX_24G_CHANNEL;
+    }
+    for (uint8_t c = first; c <= last; c++) ch[n++] = c;
+    return n;
+}
+
+static size_t build_plan(bool passive, scan_plan_t *plan) {
+    uint8_t ch_2g[WIFI_SCANNER_MAX_24G_CHANNEL];
+    uint8_t n_2g = country_channels_2g(ch_2g);
+
+    scan_plan_input_t in = { .ch_2g = ch_2g, .n_2g = n_2g, .preferred = SCAN_BAND_2G, .passive = passive,
+                             .passive_dwell_ms = WIFI_SCANNER_PASSIVE_DWELL_MS,
+                             .dfs_dwell_ms = WIFI_SCANNER_DFS_DWELL_MS };
+#if SOC_WIFI_SUPPORT_5G
+    in.ch_5g = channels_5g;
+    in.n_5g = sizeof(channels_5g);
+#ifdef CONFIG_WIFI_MGR_SCAN_DFS
+    in.ch_dfs = channels_dfs;
+    in.n_dfs = sizeof(channels_dfs);
+#endif
+#ifdef CONFIG_WIFI_MGR_SCAN_PREFER_5G
+    in.preferred = SCAN_BAND_5G;
+#endif
+#endif
+    return scan_plan_build(&in, plan);
+}
+
+static scan_band_t band_of(uint8_t channel) {
+    return (channel > WIFI_SCANNER_MAX_24G_CHANNEL + 1) ? SCAN_BAND_5G : SCAN_BAND_2G; // 14 todavía es 2.4 GHz (JP)
+}
+
+static void fill_entry(wifi_scan_result_t *e, const wifi_ap_record_t *rec) {
+    memset(e, 0, sizeof(*e));
+    strncpy(e->ssid, (char *)rec->ssid, sizeof(e->ssid) - 1);
+    e->rssi = rec->rssi;
+    e->authmode = rec->authmode;
+    e->channel = rec->primary;
+    e->band = band_of(rec->primary);
+    e->hidden = (e->ssid[0] == '\0');
+    memcpy(e->bssid, rec->bssid, sizeof(e->bssid));
+}
+
+// Agrega al álbum; lleno, una red más fuerte desplaza a la más débil. false si no entró.
+// Sobre g_album, con album_lock tomado (el de staging es solo de la tarea de estados).
+static bool album_add(album_t *a, const wifi_ap_record_t *rec) {
+    const int capacity = sizeof(a->entries) / sizeof(a->entries[0]);
+    int slot = a->count;
+    if (a->count >= capacity) {
+        slot = 0;
+        for (int i = 1; i < capacity; i++) {
+            if (a->entries[i].rssi < a->entries[slot].rssi) slot = i;
+        }
+        if (a->entries[slot].rssi >= rec->rssi) return false;
+    } else {
+        a->count++;
+    }
+    fill_entry(&a->entries[slot], rec);
+    return true;
+}
+
+// La antigüedad del álbum es la del canal escaneado más viejo: un refresco parcial no rejuvenece al resto.
+// Los canales en 0 no se escanearon (fuera del país, o el plan cortó antes) y no cuentan.
+// Sobre g_album, con album_lock tomado (el de staging es solo de la tarea de estados).
+static void update_album_time(album_t *a) {
+    int64_t oldest = INT64_MAX;
+    for (int c = 1; c <= WIFI_SCANNER_MAX_24G_CHANNEL; c++) {
+        if (a->channel_time_us[c] > 0 && a->channel_time_us[c] < oldest) oldest = a->channel_time_us[c];
+    }
+#if SOC_WIFI_SUPPORT_5G
+    for (size_t i = 0; i < sizeof(channels_5g); i++) {
+        if (a->time_5g_us[i] > 0 && a->time_5g_us[i] < oldest) oldest = a->time_5g_us[i];
+    }
+#endif
+    a->time_us = (oldest != INT64_MAX) ? oldest : -1;
+}
 
 void wifi_scanner_init(void) {
-    memset(g_scan_album, 0, sizeof(g_scan_album));
-    g_networks_found = 0;
+    taskENTER_CRITICAL(&album_lock);
+    memset(g_album, 0, sizeof(*g_album));
+    g_album->time_us = -1;
+    taskEXIT_CRITICAL(&album_lock);
+    mem_report_register("wifi_scanner", NULL, 0, sizeof(g_albums));
     ESP_LOGI(TAG, "WiFi scanner inicializado (Memoria limpia)");
 }
 
@@ -20,56 +159,163 @@ void wifi_scanner_init(void) {
  * Retorna: >0 (redes encontradas), 0 (no hay redes), <0 (Error de hardware)
  */
 int wifi_scanner_execute_actual_scan(void) {
+    return wifi_scanner_execute_scan(false, NULL);
+}
+
+int wifi_scanner_execute_scan(bool passive, const char *known_ssid) {
+    static scan_plan_t plan; // Solo la usa la tarea de estados
     wifi_ap_record_t ap_info[20];
-    uint16_t ap_count = 0;
-    uint16_t max_number = 20;
+    bool have_known = (known_ssid && known_ssid[0] != '\0');
+    bool known_seen = false;
+    bool any_ok = false;
+    int steps_run = 0;
+
+    size_t n_steps = build_plan(passive, &plan);
+    uint8_t ch_2g[WIFI_SCANNER_MAX_24G_CHANNEL];
+    uint8_t n_2g = country_channels_2g(ch_2g);
+    ESP_LOGI(TAG, "Hardware: Iniciando escaneo real (%s, %u pasos)...", passive ? "pasivo" : "activo", (unsigned)n_steps);
+
+    // Álbum nuevo en el buffer no publicado: los tiempos por canal pasan a ser solo los de este plan
+    album_t *staging = (g_album == &g_albums[0]) ? &g_albums[1] : &g_albums[0];
+    memset(staging, 0, sizeof(*staging));
+    int64_t plan_t0 = esp_timer_get_time();
+
+    for (size_t s = 0; s < n_steps; s++) {
+        const scan_plan_step_t *step = &plan.steps[s];
+        wifi_scan_config_t scan_config = {
+            .channel = step->channel,
+            .show_hidden = true,
+            .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+            .scan_time.active.min = 100,
+            .scan_time.active.max = 300
+        };
+        if (step->passive) {
+            // Solo escucha beacons: sin probe requests, el dwell del plan (más largo en DFS)
+            scan_config.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+            scan_config.scan_time.passive = step->dwell_ms;
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
+        record_radio(step->passive ? WIFI_SCANNER_KIND_FULL_PASSIVE : WIFI_SCANNER_KIND_FULL_ACTIVE, t0);
+        steps_run++;
+        if (ret != ESP_OK) {
+            // Con un paso por canal, un canal no permitido por el país no invalida el resto
+            ESP_LOGW(TAG, "Canal %d rechazado: %s", step->channel, esp_err_to_name(ret));
+        } else {
+            any_ok = true;
+            uint16_t ap_count = sizeof(ap_info) / sizeof(ap_info[0]);
+            if (esp_wifi_scan_get_ap_records(&ap_count, ap_info) != ESP_OK) ap_count = 0;
+            // IMPORTANTE: Limpiar el estado del driver para que la próxima vez esté fresco
+            esp_wifi_scan_stop();
+
+            for (int i = 0; i < ap_count; i++) {
+                if (have_known && strcmp((char *)ap_info[i].ssid, known_ssid) == 0) known_seen = true;
+            }
+            int64_t now = esp_timer_get_time();
+            for (int i = 0; i < ap_count; i++) album_add(staging, &ap_info[i]);
+            if (step->channel == SCAN_PLAN_CHANNEL_ALL) {
+                // Solo los del país: los demás no los vuelve a visitar el refresco y envejecerían el álbum
+                for (int c = 0; c < n_2g; c++) staging->channel_time_us[ch_2g[c]] = now;
+            } else {
+                int64_t *t = channel_time(staging, step->channel);
+                if (t) *t = now;
+            }
+        }
+        if (scan_plan_should_stop(&plan, s, have_known, known_seen)) {
+            ESP_LOGI(TAG, "'%s' visto en %s: se omiten %u pasos", known_ssid,
+                     step->band == SCAN_BAND_5G ? "5 GHz" : "2.4 GHz", (unsigned)(n_steps - s - 1));
+            break;
+        }
+    }
+
+    uint32_t plan_ms = (uint32_t)((esp_timer_get_time() - plan_t0) / 1000);
+    taskENTER_CRITICAL(&radio_lock);
+    plan_stats.plans++;
+    plan_stats.steps_run += steps_run;
+    plan_stats.steps_skipped += n_steps - steps_run;
+    if ((size_t)steps_run < n_steps) plan_stats.early_stops++;
+    if (steps_run > 0 && plan.steps[steps_run - 1].dfs) plan_stats.dfs_plans++;
+    plan_stats.last_ms = plan_ms;
+    if (plan_ms > plan_stats.max_ms) plan_stats.max_ms = plan_ms;
+    taskEXIT_CRITICAL(&radio_lock);
+
+    if (!any_ok) {
+        // El álbum anterior queda publicado: mejor una foto vieja que ninguna
+        ESP_LOGE(TAG, "Error hardware radio: ningún paso del plan se pudo escanear");
+        return -1; // <--- CAMBIO CLAVE: Devolvemos -1 para indicar FALLO DE HARDWARE
+    }
+    update_album_time(staging);
+    int found = staging->count;
+    taskENTER_CRITICAL(&album_lock);
+    g_album = staging;
+    taskEXIT_CRITICAL(&album_lock);
+
+    ESP_LOGI(TAG, "Escaneo finalizado en %lu ms. %d redes guardadas en RAM.", (unsigned long)plan_ms, found);
+    return found;
+}
+
+/**
+ * REFRESCO INCREMENTAL (en segundo plano, conectado)
+ * Un solo canal con dwell corto: el radio deja el canal propio como mucho 'dwell_ms'.
+ * Reemplaza en el álbum solo las entradas de ese canal; el resto queda como estaba.
+ */
+int wifi_scanner_refresh_channel(uint8_t channel, uint16_t dwell_ms) {
+    static wifi_ap_record_t records[WIFI_SCANNER_SLICE_MAX]; // Solo la usa la tarea de estados
+    if (channel_time(g_album, channel) == NULL) return -1;
 
     wifi_scan_config_t scan_config = {
+        .channel = channel,
         .show_hidden = true,
         .scan_type = WIFI_SCAN_TYPE_ACTIVE,
-        .scan_time.active.min = 100,
-        .scan_time.active.max = 300
+        .scan_time.active.min = dwell_ms / 2,
+        .scan_time.active.max = dwell_ms
     };
-
-    ESP_LOGI(TAG, "Hardware: Iniciando escaneo real...");
-    
-    // 1. Intentar el escaneo
+    int64_t t0 = esp_timer_get_time();
     esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
-    
+    record_radio(WIFI_SCANNER_KIND_SLICE, t0);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error hardware radio: %s", esp_err_to_name(ret));
-        return -1; // <--- CAMBIO CLAVE: Devolvemos -1 para indicar FALLO DE HARDWARE
+        ESP_LOGW(TAG, "Refresco del canal %d rechazado: %s", channel, esp_err_to_name(ret));
+        return -1;
     }
+    uint16_t count = WIFI_SCANNER_SLICE_MAX;
+    if (esp_wifi_scan_get_ap_records(&count, records) != ESP_OK) count = 0;
+    esp_wifi_scan_stop();
 
-    // 2. Si llegamos aquí, el hardware respondió. Obtenemos resultados.
-    esp_wifi_scan_get_ap_num(&ap_count);
-    if (ap_count > max_number) ap_count = max_number;
-
-    // Solo pedimos records si ap_count > 0 para evitar errores innecesarios
-    if (ap_count > 0) {
-        ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&ap_count, ap_info));
+    // Compactar: fuera las entradas viejas de este canal. Un lector nunca ve el álbum a medias.
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&album_lock);
+    int kept = 0;
+    for (int i = 0; i < g_album->count; i++) {
+        if (g_album->entries[i].channel == channel) continue;
+        if (kept != i) g_album->entries[kept] = g_album->entries[i];
+        kept++;
+    }
 
-        // --- ACTUALIZAR EL ÁLBUM ---
-        g_networks_found = ap_count;
-        memset(g_scan_album, 0, sizeof(g_scan_album));
+    const int capacity = sizeof(g_album->entries) / sizeof(g_album->entries[0]);
+    if (kept < capacity) memset(&g_album->entries[kept], 0, sizeof(wifi_scan_result_t) * (capacity - kept));
+    g_album->count = kept;
 
-        for (int i = 0; i < ap_count; i++) {
-            strncpy(g_scan_album[i].ssid, (char *)ap_info[i].ssid, sizeof(g_scan_album[i].ssid) - 1);
-            g_scan_album[i].rssi = ap_info[i].rssi;
-            g_scan_album[i].authmode = ap_info[i].authmode;
-            g_scan_album[i].channel = ap_info[i].primary;
-            g_scan_album[i].hidden = (strlen((char *)ap_info[i].ssid) == 0);
-        }
-    } else {
-        g_networks_found = 0;
-        memset(g_scan_album, 0, sizeof(g_scan_album));
+    // Agregar las nuevas; con el álbum lleno, una más fuerte desplaza a la más débil
+    int added = 0;
+    for (int r = 0; r < count; r++) {
+        if (records[r].primary != channel) continue; // Vecinos solapados: los trae su propio canal
+        if (album_add(g_album, &records[r])) added++;
     }
 
-    // IMPORTANTE: Limpiar el estado del driver para que la próxima vez esté fresco
-    esp_wifi_scan_stop(); 
-    
-    ESP_LOGI(TAG, "Escaneo finalizado. %d redes guardadas en RAM.", g_networks_found);
-    return (int)g_networks_found;
+    *channel_time(g_album, channel) = now;
+    update_album_time(g_album);
+    taskEXIT_CRITICAL(&album_lock);
+    return added;
+}
+
+uint8_t wifi_scanner_get_refresh_channels(uint8_t out[WIFI_SCANNER_REFRESH_MAX_CHANNELS]) {
+    uint8_t n = country_channels_2g(out);
+#if SOC_WIFI_SUPPORT_5G
+    memcpy(out + n, channels_5g, sizeof(channels_5g));
+    n += sizeof(channels_5g);
+#endif
+    return n;
 }
 
 /**
@@ -79,11 +325,12 @@ int wifi_scanner_execute_actual_scan(void) {
 int wifi_scanner_get_results(wifi_scan_result_t *results, int max_results) {
     if (!results || max_results <= 0) return 0;
 
-    // Entregamos lo que ya tenemos en memoria
-    int count_to_copy = (g_networks_found < max_results) ? g_networks_found : max_results;
-    
-    memcpy(results, g_scan_album, sizeof(wifi_scan_result_t) * count_to_copy);
-    
+    // Entregamos lo que ya tenemos en memoria (copia consistente aunque la tarea de estados esté refrescando)
+    taskENTER_CRITICAL(&album_lock);
+    int count_to_copy = (g_album->count < max_results) ? g_album->count : max_results;
+    memcpy(results, g_album->entries, sizeof(wifi_scan_result_t) * count_to_copy);
+    taskEXIT_CRITICAL(&album_lock);
+
     ESP_LOGI(TAG, "Servidor HTTP: Entregando %d redes desde memoria RAM.", count_to_copy);
     return count_to_copy;
 }
@@ -95,10 +342,106 @@ bool wifi_scanner_is_network_available(const char *target_ssid) {
     if (!target_ssid || strlen(target_ssid) == 0) return false;
 
     // Buscamos en el álbum, no volvemos a sacar la foto.
-    for (int i = 0; i < g_networks_found; i++) {
-        if (strcmp(g_scan_album[i].ssid, target_ssid) == 0) {
-            return true;
+    bool found = false;
+    taskENTER_CRITICAL(&album_lock);
+    for (int i = 0; i < g_album->count && !found; i++) {
+        found = (strcmp(g_album->entries[i].ssid, target_ssid) == 0);
+    }
+    taskEXIT_CRITICAL(&album_lock);
+    return found;
+}
+
+uint32_t wifi_scanner_get_album_age_ms(void) {
+    taskENTER_CRITICAL(&album_lock);
+    int64_t album_time_us = g_album->time_us; // 64 bits: en un core de 32 la lectura no es atómica
+    taskEXIT_CRITICAL(&album_lock);
+    if (album_time_us < 0) return WIFI_SCANNER_ALBUM_NEVER;
+    return (uint32_t)((esp_timer_get_time() - album_time_us) / 1000);
+}
+
+uint32_t wifi_scanner_get_channel_age_ms(uint8_t channel) {
+    int64_t t_us = 0;
+    taskENTER_CRITICAL(&album_lock);
+    int64_t *t = channel_time(g_album, channel);
+    if (t) t_us = *t;
+    taskEXIT_CRITICAL(&album_lock);
+    if (t_us <= 0) return WIFI_SCANNER_ALBUM_NEVER;
+    return (uint32_t)((esp_timer_get_time() - t_us) / 1000);
+}
+
+/**
+ * ESCANEO DIRIGIDO (Roaming)
+ * Solo busca un SSID y con tiempos cortos por canal, para no dejar el canal propio mucho tiempo.
+ */
+int wifi_scanner_scan_ssid(const char *ssid, wifi_ap_record_t *records, int max_records) {
+    if (!ssid || !records || max_records <= 0) return 0;
+
+    wifi_scan_config_t scan_config = {
+        .ssid = (uint8_t *)ssid,
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time.active.min = 30,
+        .scan_time.active.max = 80
+    };
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t ret = esp_wifi_scan_start(&scan_config, true);
+    record_radio(WIFI_SCANNER_KIND_TARGETED, t0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Escaneo dirigido rechazado: %s", esp_err_to_name(ret));
+        return -1;
+    }
+
+    uint16_t count = max_records;
+    if (esp_wifi_scan_get_ap_records(&count, records) != ESP_OK) count = 0;
+    esp_wifi_scan_stop();
+
+    ESP_LOGI(TAG, "Escaneo dirigido '%s': %d APs", ssid, count);
+    return count;
+}
+
+/**
+ * OCUPACIÓN POR CANAL (para elegir el canal del SoftAP)
+ * También trabaja sobre el álbum: no toca el radio.
+ */
+void wifi_scanner_score_channels(uint32_t score[WIFI_SCANNER_MAX_24G_CHANNEL + 1],
+                                 uint8_t ap_count[WIFI_SCANNER_MAX_24G_CHANNEL + 1]) {
+    // Porcentaje de solapamiento según la distancia en canales (20 MHz de ancho, 5 MHz de paso)
+    static const uint8_t overlap_pct[] = { 100, 75, 50, 25, 10 };
+
+    memset(score, 0, sizeof(uint32_t) * (WIFI_SCANNER_MAX_24G_CHANNEL + 1));
+    if (ap_count) memset(ap_count, 0, WIFI_SCANNER_MAX_24G_CHANNEL + 1);
+
+    // Como mucho 20 x 13 sumas: se calcula directamente bajo el lock, sin copiar el álbum
+    taskENTER_CRITICAL(&album_lock);
+    for (int i = 0; i < g_album->count; i++) {
+        int ch = g_album->entries[i].channel;
+        if (ch < 1 || ch > WIFI_SCANNER_MAX_24G_CHANNEL) continue; // 5 GHz no interfiere con el SoftAP
+
+        // Peso lineal: -100 dBm cuenta 1, -30 dBm o más cuenta 70
+        int weight = g_album->entries[i].rssi + 101;
+        if (weight < 1) weight = 1;
+        if (weight > 70) weight = 70;
+
+        if (ap_count) ap_count[ch]++;
+        for (int c = 1; c <= WIFI_SCANNER_MAX_24G_CHANNEL; c++) {
+            int dist = (c > ch) ? c - ch : ch - c;
+            if (dist < (int)sizeof(overlap_pct)) score[c] += weight * overlap_pct[dist];
         }
     }
-    return false;
-}
\ No newline at end of file
+    taskEXIT_CRITICAL(&album_lock);
+}
+
+void wifi_scanner_get_plan_stats(wifi_scanner_plan_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&radio_lock);
+    memcpy(out, &plan_stats, sizeof(plan_stats));
+    taskEXIT_CRITICAL(&radio_lock);
+}
+
+void wifi_scanner_get_radio_stats(wifi_scanner_radio_stats_t *out) {
+    if (!out) return;
+    taskENTER_CRITICAL(&radio_lock);
+    memcpy(out, &radio_stats, sizeof(radio_stats));
+    taskEXIT_CRITICAL(&radio_lock);
+}
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "esp_wifi_types.h"
+#include "scan_plan.h"
 
 /**
  * @brief Estructura para almacenar los resultados del escaneo de redes.
@@ -12,9 +14,51 @@ typedef struct {
     int8_t rssi;           /**< Fuerza de la señal en dBm */
     uint8_t authmode;      /**< Modo de cifrado */
     uint8_t channel;       /**< Canal de radio */
+    uint8_t band;          /**< scan_band_t (2.4 o 5 GHz) */
     bool hidden;           /**< Si la red es oculta */
+    uint8_t bssid[6];      /**< MAC del AP (distingue APs de un mismo SSID) */
 } wifi_scan_result_t;
 
+#define WIFI_SCANNER_MAX_24G_CHANNEL 13
+#define WIFI_SCANNER_ALBUM_NEVER     UINT32_MAX
+#define WIFI_SCANNER_SLICE_MAX       10 // APs por canal en un refresco incremental
+#define WIFI_SCANNER_REFRESH_MAX_CHANNELS (WIFI_SCANNER_MAX_24G_CHANNEL + 9) // 2.4 GHz + 5 GHz sin DFS
+#define WIFI_SCANNER_PASSIVE_DWELL_MS CONFIG_WIFI_MGR_SCAN_PASSIVE_DWELL_MS
+#ifdef CONFIG_WIFI_MGR_SCAN_DFS
+#define WIFI_SCANNER_DFS_DWELL_MS     CONFIG_WIFI_MGR_SCAN_DFS_DWELL_MS
+#else
+#define WIFI_SCANNER_DFS_DWELL_MS     WIFI_SCANNER_PASSIVE_DWELL_MS // Sin canales DFS en el plan
+#endif
+
+typedef enum {
+    WIFI_SCANNER_KIND_FULL_ACTIVE = 0,  /**< Escaneo completo con probe requests (SCANNING) */
+    WIFI_SCANNER_KIND_FULL_PASSIVE,     /**< Escaneo completo solo escuchando beacons (entorno vacío) */
+    WIFI_SCANNER_KIND_SLICE,            /**< Un canal, refresco en segundo plano */
+    WIFI_SCANNER_KIND_TARGETED,         /**< Dirigido a un SSID (roaming) */
+    WIFI_SCANNER_KIND_COUNT
+} wifi_scanner_kind_t;
+
+/**
+ * @brief Tiempo de radio consumido escaneando (duración de cada esp_wifi_scan_start bloqueante).
+ */
+typedef struct {
+    uint32_t scans[WIFI_SCANNER_KIND_COUNT];
+    uint64_t radio_ms[WIFI_SCANNER_KIND_COUNT];
+} wifi_scanner_radio_stats_t;
+
+/**
+ * @brief Escaneos completos planificados por banda (ver scan_plan.h).
+ */
+typedef struct {
+    uint32_t plans;             /**< Escaneos completos ejecutados */
+    uint32_t early_stops;       /**< Cortados tras ver la red conocida */
+    uint32_t dfs_plans;         /**< Llegaron a los canales DFS */
+    uint32_t steps_run;
+    uint32_t steps_skipped;
+    uint32_t last_ms;           /**< Duración del último plan (todos sus pasos) */
+    uint32_t max_ms;
+} wifi_scanner_plan_stats_t;
+
 void wifi_scanner_init(void);
 
 /**
@@ -24,6 +68,32 @@ void wifi_scanner_init(void);
  */
 int wifi_scanner_execute_actual_scan(void); // <--- AGREGADO
 
+/**
+ * @brief Igual que wifi_scanner_execute_actual_scan, eligiendo el tipo. El pasivo no transmite
+ * (solo escucha beacons en cada canal): más barato, para los reintentos en un entorno vacío.
+ * En chips de doble banda el escaneo sigue un plan: banda preferida, la otra y DFS al final;
+ * si 'known_ssid' aparece en un grupo, los siguientes se omiten.
+ * @param known_ssid Red guardada (NULL o "" para barrer todo, p. ej. para el portal).
+ */
+int wifi_scanner_execute_scan(bool passive, const char *known_ssid);
+
+/**
+ * @brief Refresca en el álbum un solo canal (escaneo corto, pensado para hacerlo conectado).
+ * Las entradas de los demás canales no se tocan. La antigüedad del álbum pasa a ser la del canal más viejo.
+ * @param channel Uno de wifi_scanner_get_refresh_channels() (DFS no: solo lo escucha el escaneo completo).
+ * @param dwell_ms Tiempo máximo en el canal (ausencia del canal propio).
+ * @return APs agregados para ese canal, o -1 si el radio rechazó el escaneo.
+ */
+int wifi_scanner_refresh_channel(uint8_t channel, uint16_t dwell_ms);
+
+/**
+ * @brief Canales que recorre el refresco en segundo plano: los de 2.4 GHz que permite el país y,
+ * en chips de doble banda, los de 5 GHz sin DFS. Son todos los que cuentan para la antigüedad del
+ * álbum, así una vuelta completa la renueva entera.
+ * @return Cantidad de canales en 'out'.
+ */
+uint8_t wifi_scanner_get_refresh_channels(uint8_t out[WIFI_SCANNER_REFRESH_MAX_CHANNELS]);
+
 /**
  * @brief Obtiene los resultados DESDE LA RAM (sin tocar el hardware).
  * Es la que usa el servidor HTTP para no interrumpir el Portal.
@@ -37,4 +107,37 @@ int wifi_scanner_get_results(wifi_scan_result_t *results, int max_results);
  */
 bool wifi_scanner_is_network_available(const char *target_ssid);
 
+/**
+ * @brief Antigüedad del álbum en milisegundos (WIFI_SCANNER_ALBUM_NEVER si nunca se escaneó).
+ */
+uint32_t wifi_scanner_get_album_age_ms(void);
+
+/**
+ * @brief Antigüedad de las entradas de un canal (su último escaneo completo o refresco).
+ * Con el refresco incremental el álbum envejece por partes: esto dice cuáles entradas son recientes.
+ * @return WIFI_SCANNER_ALBUM_NEVER si el canal no está en el álbum o no se sigue (DFS).
+ */
+uint32_t wifi_scanner_get_channel_age_ms(uint8_t channel);
+
+/**
+ * @brief Escaneo corto y dirigido a un SSID (para roaming). NO modifica el álbum.
+ * @param records Buffer de salida con los APs que anuncian ese SSID.
+ * @return Cantidad de APs encontrados, o -1 si el radio rechazó el escaneo.
+ */
+int wifi_scanner_scan_ssid(const char *ssid, wifi_ap_record_t *records, int max_records);
+
+/**
+ * @brief Calcula la ocupación de cada canal de 2.4 GHz a partir del álbum.
+ * Cada AP suma un peso según su RSSI, repartido sobre los canales adyacentes que solapa
+ * (100% en su canal, 75/50/25/10% a 1..4 canales de distancia). Menor puntaje = canal más libre.
+ * @param score Arreglo indexado por canal (1..13); el índice 0 no se usa.
+ * @param ap_count Opcional: cantidad de APs con ese canal primario.
+ */
+void wifi_scanner_score_channels(uint32_t score[WIFI_SCANNER_MAX_24G_CHANNEL + 1],
+                                 uint8_t ap_count[WIFI_SCANNER_MAX_24G_CHANNEL + 1]);
+
+void wifi_scanner_get_radio_stats(wifi_scanner_radio_stats_t *out);
+
+void wifi_scanner_get_plan_stats(wifi_scanner_plan_stats_t *out);
+
 #endif // WIFI_SCANNER_H
\ No newline at end of file
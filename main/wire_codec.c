@@ -0,0 +1,79 @@
+#include "wire_codec.h"
+#include <string.h>
+
+// Escritura explícita byte a byte: el layout no depende del compilador ni del endianness
+static uint8_t *put_u8(uint8_t *p, uint8_t v) {
+    *p++ = v;
+    return p;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_bytes(uint8_t *p, const void *src, size_t len) {
+    memcpy(p, src, len);
+    return p + len;
+}
+
+static uint8_t *put_header(uint8_t *p, uint8_t kind) {
+    p = put_u8(p, 'W');
+    p = put_u8(p, 'M');
+    p = put_u8(p, WIRE_VERSION);
+    return put_u8(p, kind);
+}
+
+size_t wire_encode_scan(const wifi_scan_result_t *results, int count, uint8_t *out, size_t cap) {
+    if (!out || cap < WIRE_HEADER_LEN + 1) return 0;
+    uint8_t *p = put_header(out, WIRE_KIND_SCAN);
+    uint8_t *count_pos = p++;
+    uint8_t written = 0;
+
+    for (int i = 0; i < count && written < UINT8_MAX; i++) {
+        const wifi_scan_result_t *r = &results[i];
+        size_t ssid_len = strnlen(r->ssid, sizeof(r->ssid) - 1);
+        if ((size_t)(p - out) + 6 + 5 + ssid_len > cap) break;
+        p = put_bytes(p, r->bssid, sizeof(r->bssid));
+        p = put_u8(p, (uint8_t)r->rssi);
+        p = put_u8(p, r->channel);
+        p = put_u8(p, r->authmode);
+        p = put_u8(p, (r->hidden ? 0x01 : 0x00) | (r->band == SCAN_BAND_5G ? 0x02 : 0x00));
+        p = put_u8(p, (uint8_t)ssid_len);
+        p = put_bytes(p, r->ssid, ssid_len);
+        written++;
+    }
+    *count_pos = written;
+    return (size_t)(p - out);
+}
+
+size_t wire_encode_status(const wire_status_src_t *src, uint8_t *out, size_t cap) {
+    static const uint8_t zero_bssid[6] = {0};
+    if (!src || !out || cap < WIRE_STATUS_LEN) return 0;
+
+    uint8_t flags = (src->link->connected ? 0x01 : 0) | (src->degraded ? 0x02 : 0) |
+                    (src->link->sta_started ? 0x04 : 0);
+    uint8_t *p = put_header(out, WIRE_KIND_STATUS);
+    p = put_u8(p, (uint8_t)src->state);
+    p = put_u8(p, (uint8_t)src->test);
+    p = put_u8(p, src->test_reason);
+    p = put_u8(p, src->link->last_reason);
+    p = put_u8(p, flags);
+    p = put_u8(p, src->ap ? (uint8_t)src->ap->rssi : 0);
+    p = put_u8(p, src->ap ? src->ap->primary : 0);
+    p = put_u8(p, src->probe->loss_pct);
+    p = put_bytes(p, src->ap ? src->ap->bssid : zero_bssid, 6);
+    p = put_bytes(p, &src->link->ip, 4); // Ya está en orden de red
+    p = put_u32(p, src->uptime_s);
+    p = put_u32(p, src->flow->transitions);
+    p = put_u32(p, src->flow->scans);
+    p = put_u32(p, src->bus->published[CONN_EVT_STA_DISCONNECTED]);
+    p = put_u32(p, src->bus->published[CONN_EVT_GOT_IP]);
+    p = put_u32(p, src->flow->time_to_ip_last_ms);
+    p = put_u32(p, src->probe->rtt_us_avg);
+    p = put_u32(p, src->album_age_ms);
+    return (size_t)(p - out);
+}
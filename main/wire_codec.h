@@ -0,0 +1,75 @@
+#ifndef WIRE_CODEC_H
+#define WIRE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "wifi_scanner.h"
+#include "wifi_provisioning.h"
+#include "system_state.h"
+#include "conn_bus.h"
+#include "link_probe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Formato binario compacto de /scan y /status para herramientas de flota.
+ * Se pide con "Accept: application/x-wifimgr-bin"; sin ese header los endpoints siguen en JSON.
+ *
+ * Todo en little-endian, sin padding. Cabecera común (4 bytes): 'W' 'M' versión tipo.
+ *
+ * Álbum (tipo 1): u8 count, y por AP:
+ *   bssid[6] | i8 rssi | u8 canal | u8 authmode | u8 flags (bit0 oculta, bit1 5 GHz) | u8 ssid_len | ssid[ssid_len]
+ *
+ * Estado (tipo 2, largo fijo WIRE_STATUS_LEN):
+ *   u8 state | u8 test | u8 test_reason | u8 last_reason | u8 flags (bit0 IP, bit1 degradado, bit2 STA iniciada)
+ *   | i8 rssi | u8 canal | u8 pérdida % | bssid[6] | ip[4] (orden de red) | u32 uptime_s
+ *   | u32 transiciones | u32 escaneos | u32 desconexiones | u32 got_ip | u32 time_to_ip_ms (último)
+ *   | u32 rtt_avg_us | u32 antigüedad del álbum ms (0xFFFFFFFF = nunca)
+ */
+
+#define WIRE_CONTENT_TYPE "application/x-wifimgr-bin"
+#define WIRE_VERSION      1
+#define WIRE_KIND_SCAN    1
+#define WIRE_KIND_STATUS  2
+
+#define WIRE_HEADER_LEN     4
+#define WIRE_SCAN_REC_MAX   (6 + 5 + 32)
+#define WIRE_STATUS_LEN     (WIRE_HEADER_LEN + 8 + 6 + 4 + 4 + 7 * 4)
+
+/**
+ * @brief Fuentes del estado: las fotos que ya exponen los módulos, sin pasar por texto.
+ */
+typedef struct {
+    system_state_t state;
+    wifi_prov_test_result_t test;
+    uint8_t test_reason;
+    const conn_status_t *link;
+    const wifi_ap_record_t *ap;         /**< AP asociado, NULL sin asociación (rssi/canal/bssid en 0) */
+    const system_state_stats_t *flow;
+    const conn_bus_stats_t *bus;
+    const link_probe_stats_t *probe;
+    bool degraded;
+    uint32_t uptime_s;
+    uint32_t album_age_ms;
+} wire_status_src_t;
+
+/**
+ * @brief Codifica el álbum. Los registros que no entran en 'cap' se omiten (count refleja los escritos).
+ * @return Bytes escritos, 0 si 'cap' no alcanza ni para la cabecera.
+ */
+size_t wire_encode_scan(const wifi_scan_result_t *results, int count, uint8_t *out, size_t cap);
+
+/**
+ * @brief Codifica la foto de estado.
+ * @return WIRE_STATUS_LEN, o 0 si 'cap' es menor.
+ */
+size_t wire_encode_status(const wire_status_src_t *src, uint8_t *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIRE_CODEC_H
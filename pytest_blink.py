@@ -12,6 +12,9 @@ from pytest_embedded_idf.utils import idf_parametrize
 @idf_parametrize('target', ['supported_targets'], indirect=['target'])
 def test_blink(dut: IdfDut) -> None:
     # check and log bin size
-    binary_file = os.path.join(dut.app.binary_path, 'blink.bin')
+    binary_file = os.path.join(dut.app.binary_path, 'wifi_manager_pro_v2.bin')
     bin_size = os.path.getsize(binary_file)
-    logging.info('blink_bin_size : {}KB'.format(bin_size // 1024))
+    logging.info('wifi_manager_bin_size : {}KB'.format(bin_size // 1024))
+    # the state machine must come up and leave BOOT on its own (STA_START, no fixed sleeps)
+    dut.expect_exact('Inicializando gestor de estados', timeout=10)
+    dut.expect(r'Cambiando estado del sistema -> [12]', timeout=10)
@@ -0,0 +1,82 @@
+/*
+ * Perfil de arranque con reloj virtual: la tabla se imprime desde la tarea de estados (no en el
+ * callback de conn_bus) y el presupuesto de time-to-IP se evalúa en el borde exacto.
+ * Se incluye boot_profile.c para reiniciar su estado entre casos.
+ */
+#include "boot_profile.c"
+
+#include "fake_idf.h"
+#include "host_test.h"
+
+static conn_event_cb_t bus_cb = NULL;
+
+bool conn_bus_subscribe_cb(conn_event_cb_t cb, void *arg) {
+    bus_cb = cb;
+    return true;
+}
+
+static void publish_at(uint32_t ms, conn_event_type_t type) {
+    fake_clock_set_virtual(ms * 1000LL);
+    conn_event_t evt = { .type = type, .timestamp_us = esp_timer_get_time() };
+    bus_cb(&evt, NULL);
+}
+
+static void mark_at(uint32_t ms, boot_phase_t phase) {
+    fake_clock_set_virtual(ms * 1000LL);
+    boot_profile_mark(phase);
+}
+
+static void reset_profile(void) {
+    initialized = false;
+    report_pending = false;
+}
+
+static void test_report_deferred(void) {
+    reset_profile();
+    mark_at(30, BOOT_PHASE_APP_MAIN);
+    mark_at(60, BOOT_PHASE_NVS_READY);
+    boot_profile_init();
+    mark_at(180, BOOT_PHASE_WIFI_INIT);
+    mark_at(190, BOOT_PHASE_RADIO_START);
+    publish_at(420, CONN_EVT_STA_START);
+    mark_at(425, BOOT_PHASE_CONNECT);
+    publish_at(1300, CONN_EVT_STA_CONNECTED);
+
+    // El GOT_IP llega por el event loop: solo marca
+    uint32_t lines = fake_idf_log_lines();
+    publish_at(2100, CONN_EVT_GOT_IP);
+    CHECK_EQ(fake_idf_log_lines(), lines);
+
+    // La tarea de estados imprime la tabla (un renglón por hito y el veredicto), una sola vez
+    boot_profile_report();
+    CHECK_EQ(fake_idf_log_lines() - lines, BOOT_PHASE_COUNT + 1);
+    lines = fake_idf_log_lines();
+    boot_profile_report();
+    publish_at(9000, CONN_EVT_GOT_IP); // Reconexión posterior: no es el arranque
+    boot_profile_report();
+    CHECK_EQ(fake_idf_log_lines(), lines);
+
+    uint32_t ms[BOOT_PHASE_COUNT];
+    boot_profile_get(ms);
+    CHECK_EQ(ms[BOOT_PHASE_STA_START], 420);
+    CHECK_EQ(ms[BOOT_PHASE_GOT_IP], 2100);
+    CHECK_EQ(ms[BOOT_PHASE_SCAN_DONE], BOOT_PHASE_NOT_REACHED); // Fast boot: sin álbum
+    CHECK(!boot_profile_over_budget());
+}
+
+static void test_budget_edge(void) {
+    reset_profile();
+    publish_at(CONFIG_WIFI_MGR_BOOT_BUDGET_MS, CONN_EVT_GOT_IP);
+    CHECK(!boot_profile_over_budget());
+
+    reset_profile();
+    CHECK(!boot_profile_over_budget()); // Sin IP todavía no hay veredicto
+    publish_at(CONFIG_WIFI_MGR_BOOT_BUDGET_MS + 1, CONN_EVT_GOT_IP);
+    CHECK(boot_profile_over_budget());
+}
+
+int main(void) {
+    test_report_deferred();
+    test_budget_edge();
+    return host_test_result("boot_profile_test");
+}
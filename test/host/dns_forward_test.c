@@ -0,0 +1,336 @@
+#include "dns_forward.h"
+#include "dns_cache.h"
+#include "dns_packet.h"
+#include "host_test.h"
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * Forwarder + caché contra un resolver de prueba en loopback (UDP 127.0.0.1). El reloj es virtual:
+ * cada paso recibe 'now_ms', igual que la tarea DNS con esp_timer_get_time().
+ * El TTL de cada respuesta depende del nombre:
+ *   nx.*   -> NXDOMAIN sin registros (TTL negativo de 30 s en la caché)
+ *   long.* -> 86400 s (la caché lo limita a 3600 s)
+ *   resto  -> 300 s
+ */
+
+#define QTYPE_AAAA 28
+
+static int fwd_sock = -1;       // Lado "upstream" del forwarder
+static int resolver_sock = -1;  // Resolver de prueba
+static struct sockaddr_in resolver_addr;
+static uint32_t resolver_rx = 0;
+static uint16_t next_upstream_id = 0x4000;
+
+/* Último lote de respuestas entregadas a clientes */
+static dns_fwd_client_t delivered[16];
+static uint8_t delivered_pkt[16][512];
+static int n_delivered = 0;
+
+/* =========================
+   Funciones Auxiliares
+   ========================= */
+
+static size_t build_query(uint8_t *p, uint16_t id, const char *name, uint16_t qtype) {
+    memset(p, 0, DNS_HEADER_LEN);
+    p[0] = id >> 8; p[1] = id & 0xff; p[2] = 0x01; p[5] = 1;
+    size_t off = DNS_HEADER_LEN;
+    const char *s = name;
+    while (*s) {
+        const char *dot = strchr(s, '.');
+        size_t l = dot ? (size_t)(dot - s) : strlen(s);
+        p[off++] = (uint8_t)l;
+        memcpy(p + off, s, l);
+        off += l;
+        s += l + (dot ? 1 : 0);
+    }
+    p[off++] = 0;
+    p[off++] = qtype >> 8; p[off++] = qtype & 0xff;
+    p[off++] = 0; p[off++] = DNS_QCLASS_IN;
+    return off;
+}
+
+// TTL del único RR de la respuesta (va después de la pregunta, con el nombre comprimido)
+static uint32_t answer_ttl(const uint8_t *resp) {
+    size_t off = DNS_HEADER_LEN;
+    while (resp[off] != 0) off += resp[off] + 1;
+    const uint8_t *t = resp + off + 1 + 4 + 6;
+    return ((uint32_t)t[0] << 24) | ((uint32_t)t[1] << 16) | ((uint32_t)t[2] << 8) | t[3];
+}
+
+// ¿La primera etiqueta del nombre es 'label'?
+static int first_label_is(const uint8_t *wire, const char *label) {
+    size_t l = strlen(label);
+    return wire[0] == l && memcmp(wire + 1, label, l) == 0;
+}
+
+// Resolver de prueba: contesta todo lo que tenga pendiente en su socket
+static void resolver_serve(int expected) {
+    for (int n = 0; n < expected; n++) {
+        uint8_t buf[512];
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(resolver_sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (len <= 0) return;
+        resolver_rx++;
+
+        dns_question_t q;
+        if (dns_packet_parse_question(buf, len, &q) != 0) continue;
+        size_t off = q.qend;
+        buf[2] = 0x81; // QR + RD
+        buf[3] = 0x80; // RA
+        if (first_label_is(buf + q.name_off, "nx")) {
+            buf[3] |= 3;
+            dns_packet_set_counts(buf, 1, 0);
+        } else {
+            uint32_t ttl = first_label_is(buf + q.name_off, "long") ? 86400 : 300;
+            static const uint8_t rr_head[] = { 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01 };
+            memcpy(buf + off, rr_head, sizeof(rr_head));
+            off += sizeof(rr_head);
+            buf[off++] = ttl >> 24; buf[off++] = ttl >> 16; buf[off++] = ttl >> 8; buf[off++] = ttl;
+            buf[off++] = 0; buf[off++] = 4;
+            buf[off++] = 10; buf[off++] = 0; buf[off++] = 0; buf[off++] = 1;
+            dns_packet_set_counts(buf, 1, 1);
+        }
+        sendto(resolver_sock, buf, off, 0, (struct sockaddr *)&from, from_len);
+    }
+}
+
+typedef enum { OUT_CACHE, OUT_SENT, OUT_COALESCED, OUT_FULL } outcome_t;
+
+// Mismo camino que dns_forward_query() en dns_server.c: caché, tabla en vuelo, envío al upstream
+static outcome_t client_query(const char *name, uint16_t qtype, uint16_t client_id, uint16_t client_port,
+                              uint32_t now_ms, uint8_t *out, size_t *out_len) {
+    uint8_t buf[512];
+    size_t len = build_query(buf, client_id, name, qtype);
+    dns_question_t q;
+    if (dns_packet_parse_question(buf, len, &q) != 0) return OUT_FULL;
+
+    if (dns_cache_lookup(buf + q.name_off, q.name_len, qtype, now_ms, out, 512, out_len)) {
+        out[0] = client_id >> 8;
+        out[1] = client_id & 0xff;
+        return OUT_CACHE;
+    }
+
+    dns_fwd_client_t c = { .ip = htonl(INADDR_LOOPBACK), .port = htons(client_port), .id = client_id };
+    uint8_t tx[512];
+    size_t tx_len;
+    uint16_t upstream_id = next_upstream_id++;
+    switch (dns_forward_add(buf, &q, &c, upstream_id, now_ms * 1000LL, tx, sizeof(tx), &tx_len)) {
+        case DNS_FWD_COALESCED: return OUT_COALESCED;
+        case DNS_FWD_FULL:      return OUT_FULL;
+        case DNS_FWD_SEND:      break;
+    }
+    if (sendto(fwd_sock, tx, tx_len, 0, (struct sockaddr *)&resolver_addr, sizeof(resolver_addr)) < 0) {
+        dns_forward_cancel(upstream_id);
+        return OUT_FULL;
+    }
+    return OUT_SENT;
+}
+
+// El resolver contesta 'sent' consultas y el forwarder las reparte (y las guarda en la caché)
+static void pump(int sent, uint32_t now_ms) {
+    resolver_serve(sent);
+    n_delivered = 0;
+    for (int n = 0; n < sent; n++) {
+        uint8_t buf[512];
+        ssize_t len = recv(fwd_sock, buf, sizeof(buf), 0);
+        if (len <= 0) return;
+        dns_fwd_reply_t r;
+        if (!dns_forward_match_reply(buf, len, now_ms * 1000LL, &r)) continue;
+        dns_cache_store(buf + r.q.name_off, r.q.name_len, r.q.qtype, buf, len, now_ms);
+        for (int w = 0; w < r.n_clients && n_delivered < 16; w++) {
+            delivered[n_delivered] = r.clients[w];
+            memcpy(delivered_pkt[n_delivered], buf, len);
+            delivered_pkt[n_delivered][0] = r.clients[w].id >> 8;
+            delivered_pkt[n_delivered][1] = r.clients[w].id & 0xff;
+            n_delivered++;
+        }
+    }
+}
+
+static void reset_all(void) {
+    dns_cache_init();
+    dns_forward_reset();
+}
+
+/* =========================
+   Casos
+   ========================= */
+
+static void test_ttl_rewrite_on_hit(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    CHECK_EQ(client_query("ttl.test", DNS_QTYPE_A, 0x1111, 5001, 0, out, &len), OUT_SENT);
+    pump(1, 0);
+    CHECK_EQ(n_delivered, 1);
+    CHECK_EQ(delivered[0].id, 0x1111);
+    CHECK_EQ(answer_ttl(delivered_pkt[0]), 300);
+
+    CHECK_EQ(client_query("ttl.test", DNS_QTYPE_A, 0x2222, 5002, 100999, out, &len), OUT_CACHE);
+    CHECK_EQ((out[0] << 8) | out[1], 0x2222);
+    CHECK_EQ(answer_ttl(out), 200);
+    CHECK_EQ(client_query("TTL.Test", DNS_QTYPE_A, 0x3333, 5003, 299999, out, &len), OUT_CACHE);
+    CHECK_EQ(answer_ttl(out), 1);
+    CHECK_EQ(client_query("ttl.test", DNS_QTYPE_A, 0x4444, 5004, 300000, out, &len), OUT_SENT);
+    pump(1, 300000);
+}
+
+static void test_negative_ttl(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    CHECK_EQ(client_query("nx.test", DNS_QTYPE_A, 1, 5001, 0, out, &len), OUT_SENT);
+    pump(1, 0);
+    CHECK_EQ(n_delivered, 1);
+    CHECK_EQ(delivered_pkt[0][3] & 0x0f, 3);
+    CHECK_EQ(client_query("nx.test", DNS_QTYPE_A, 2, 5001, 29999, out, &len), OUT_CACHE);
+    CHECK_EQ(out[3] & 0x0f, 3);
+    CHECK_EQ(client_query("nx.test", DNS_QTYPE_A, 3, 5001, 30000, out, &len), OUT_SENT);
+    pump(1, 30000);
+}
+
+static void test_ttl_cap(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    CHECK_EQ(client_query("long.test", DNS_QTYPE_A, 1, 5001, 0, out, &len), OUT_SENT);
+    pump(1, 0);
+    CHECK_EQ(answer_ttl(delivered_pkt[0]), 86400);
+    CHECK_EQ(client_query("long.test", DNS_QTYPE_A, 2, 5001, 3599999, out, &len), OUT_CACHE);
+    CHECK_EQ(client_query("long.test", DNS_QTYPE_A, 3, 5001, 3600000, out, &len), OUT_SENT);
+    pump(1, 3600000);
+}
+
+static void test_lru_eviction(void) {
+    uint8_t out[512];
+    size_t len;
+    char name[16];
+    dns_cache_stats_t before, after;
+    reset_all();
+    dns_cache_get_stats(&before);
+
+    // 12 entradas llenan la caché
+    for (int i = 0; i < 12; i++) {
+        snprintf(name, sizeof(name), "h%d.test", i);
+        CHECK_EQ(client_query(name, DNS_QTYPE_A, i, 5001, i, out, &len), OUT_SENT);
+        pump(1, i);
+    }
+    // h0 se vuelve la más reciente: la próxima víctima es h1
+    CHECK_EQ(client_query("h0.test", DNS_QTYPE_A, 100, 5001, 1000, out, &len), OUT_CACHE);
+    CHECK_EQ(client_query("h12.test", DNS_QTYPE_A, 101, 5001, 1001, out, &len), OUT_SENT);
+    pump(1, 1001);
+
+    dns_cache_get_stats(&after);
+    CHECK_EQ(after.evictions - before.evictions, 1);
+    CHECK_EQ(client_query("h0.test", DNS_QTYPE_A, 102, 5001, 1002, out, &len), OUT_CACHE);
+    CHECK_EQ(client_query("h12.test", DNS_QTYPE_A, 103, 5001, 1002, out, &len), OUT_CACHE);
+    CHECK_EQ(client_query("h2.test", DNS_QTYPE_A, 104, 5001, 1002, out, &len), OUT_CACHE);
+    CHECK_EQ(client_query("h1.test", DNS_QTYPE_A, 105, 5001, 1002, out, &len), OUT_SENT);
+    pump(1, 1002);
+}
+
+static void test_coalescing(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    uint32_t rx0 = resolver_rx;
+
+    // Misma pregunta (sin distinguir mayúsculas) desde cuatro clientes: una sola consulta al upstream
+    CHECK_EQ(client_query("dup.test", DNS_QTYPE_A, 0xa1, 6001, 0, out, &len), OUT_SENT);
+    CHECK_EQ(client_query("DUP.test", DNS_QTYPE_A, 0xa2, 6002, 1, out, &len), OUT_COALESCED);
+    CHECK_EQ(client_query("dup.TEST", DNS_QTYPE_A, 0xa3, 6003, 2, out, &len), OUT_COALESCED);
+    CHECK_EQ(client_query("dup.test", DNS_QTYPE_A, 0xa4, 6004, 3, out, &len), OUT_COALESCED);
+    CHECK_EQ(client_query("dup.test", DNS_QTYPE_A, 0xa5, 6005, 4, out, &len), OUT_FULL);
+    // Otro tipo es otra pregunta
+    CHECK_EQ(client_query("dup.test", QTYPE_AAAA, 0xb1, 6006, 5, out, &len), OUT_SENT);
+
+    pump(2, 40);
+    CHECK_EQ(resolver_rx - rx0, 2);
+    CHECK_EQ(n_delivered, 5);
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(delivered[i].id, 0xa1 + i);
+        CHECK_EQ(ntohs(delivered[i].port), 6001 + i);
+        CHECK_EQ((delivered_pkt[i][0] << 8) | delivered_pkt[i][1], 0xa1 + i);
+    }
+    CHECK_EQ(delivered[4].id, 0xb1);
+
+    // Ya en caché: no vuelve al upstream
+    CHECK_EQ(client_query("dup.test", DNS_QTYPE_A, 0xc1, 6001, 50, out, &len), OUT_CACHE);
+    CHECK_EQ(resolver_rx - rx0, 2);
+}
+
+static void test_timeout(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    CHECK_EQ(client_query("slow.test", DNS_QTYPE_A, 1, 5001, 0, out, &len), OUT_SENT);
+    CHECK_EQ(dns_forward_expire(DNS_FWD_TIMEOUT_MS * 1000LL), 0);
+    CHECK_EQ(dns_forward_expire((DNS_FWD_TIMEOUT_MS + 1) * 1000LL), 1);
+    // La respuesta tardía ya no tiene a quién entregarse ni entra en la caché
+    pump(1, DNS_FWD_TIMEOUT_MS + 5);
+    CHECK_EQ(n_delivered, 0);
+    CHECK_EQ(client_query("slow.test", DNS_QTYPE_A, 2, 5001, DNS_FWD_TIMEOUT_MS + 6, out, &len), OUT_SENT);
+    pump(1, DNS_FWD_TIMEOUT_MS + 6);
+}
+
+static void test_id_in_use(void) {
+    uint8_t out[512];
+    size_t len;
+    reset_all();
+    uint16_t id = next_upstream_id;
+    CHECK(!dns_forward_id_in_use(id));
+    CHECK_EQ(client_query("busy.test", DNS_QTYPE_A, 1, 5001, 0, out, &len), OUT_SENT);
+    CHECK(dns_forward_id_in_use(id));
+    CHECK(!dns_forward_id_in_use(id + 1));
+    // Al contestarse (o vencer) el ID vuelve a quedar libre
+    pump(1, 10);
+    CHECK_EQ(n_delivered, 1);
+    CHECK(!dns_forward_id_in_use(id));
+}
+
+/* =========================
+   Main
+   ========================= */
+
+static int open_udp(struct sockaddr_in *bound) {
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0) return -1;
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(a);
+    struct timeval tv = { .tv_sec = 1 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (bind(s, (struct sockaddr *)&a, sizeof(a)) < 0 || getsockname(s, (struct sockaddr *)&a, &alen) < 0) {
+        close(s);
+        return -1;
+    }
+    if (bound) *bound = a;
+    return s;
+}
+
+int main(void) {
+    resolver_sock = open_udp(&resolver_addr);
+    fwd_sock = open_udp(NULL);
+    if (resolver_sock < 0 || fwd_sock < 0) {
+        fprintf(stderr, "sin sockets UDP en loopback\n");
+        return EXIT_FAILURE;
+    }
+
+    test_ttl_rewrite_on_hit();
+    test_negative_ttl();
+    test_ttl_cap();
+    test_lru_eviction();
+    test_coalescing();
+    test_timeout();
+    test_id_in_use();
+
+    close(resolver_sock);
+    close(fwd_sock);
+    return host_test_result("dns_forward_test");
+}
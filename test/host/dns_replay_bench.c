@@ -0,0 +1,128 @@
+#include "dns_packet.h"
+#include "host_test.h"
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * Replay del responder DNS del portal: un corpus con las consultas típicas de las sondas de
+ * conectividad (A, AAAA, HTTPS, EDNS) y paquetes inválidos. Primero verifica cada respuesta,
+ * después repite el corpus N veces y reporta consultas/s.
+ */
+
+#define QTYPE_AAAA  28
+#define QTYPE_HTTPS 65
+
+typedef struct {
+    uint8_t pkt[128];
+    size_t len;
+    dns_reply_kind_t expect;
+} query_t;
+
+static query_t corpus[16];
+static int n_corpus = 0;
+
+// Consulta estándar con RD; 'edns' agrega un OPT vacío en la sección adicional
+static void add_query(const char *name, uint16_t qtype, int edns, dns_reply_kind_t expect) {
+    query_t *q = &corpus[n_corpus++];
+    uint8_t *p = q->pkt;
+    memset(q->pkt, 0, sizeof(q->pkt));
+    p[0] = 0x12; p[1] = n_corpus; p[2] = 0x01; p[5] = 1; p[11] = edns ? 1 : 0;
+    size_t off = DNS_HEADER_LEN;
+    const char *s = name;
+    while (*s) {
+        const char *dot = strchr(s, '.');
+        size_t l = dot ? (size_t)(dot - s) : strlen(s);
+        p[off++] = (uint8_t)l;
+        memcpy(p + off, s, l);
+        off += l;
+        s += l + (dot ? 1 : 0);
+    }
+    p[off++] = 0;
+    p[off++] = qtype >> 8; p[off++] = qtype & 0xff;
+    p[off++] = 0; p[off++] = DNS_QCLASS_IN;
+    if (edns) {
+        static const uint8_t opt[] = { 0, 0, 41, 0x04, 0xd0, 0, 0, 0, 0, 0, 0 };
+        memcpy(p + off, opt, sizeof(opt));
+        off += sizeof(opt);
+    }
+    q->len = off;
+    q->expect = expect;
+}
+
+static void add_raw(const uint8_t *pkt, size_t len, dns_reply_kind_t expect) {
+    query_t *q = &corpus[n_corpus++];
+    memcpy(q->pkt, pkt, len);
+    q->len = len;
+    q->expect = expect;
+}
+
+static void build_corpus(void) {
+    add_query("connectivitycheck.gstatic.com", DNS_QTYPE_A, 0, DNS_REPLY_A);
+    add_query("captive.apple.com", DNS_QTYPE_A, 1, DNS_REPLY_A);
+    add_query("www.msftconnecttest.com", DNS_QTYPE_A, 0, DNS_REPLY_A);
+    add_query("captive.apple.com", QTYPE_AAAA, 1, DNS_REPLY_EMPTY);
+    add_query("setup.esp32", QTYPE_HTTPS, 0, DNS_REPLY_EMPTY);
+    add_query("detectportal.firefox.com", DNS_QTYPE_ANY, 0, DNS_REPLY_A);
+
+    static const uint8_t truncated[] = { 0x00, 0x01, 0x01, 0x00, 0x00, 0x01 };
+    static const uint8_t response[] = { 0, 1, 0x81, 0x80, 0, 1, 0, 0, 0, 0, 0, 0, 1, 'a', 0, 0, 1, 0, 1 };
+    static const uint8_t compressed[] = { 0, 1, 0x01, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0xc0, 0x0c, 0, 1, 0, 1 };
+    static const uint8_t opcode[] = { 0, 1, 0x11, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 'a', 0, 0, 1, 0, 1 };
+    static const uint8_t two_q[] = { 0, 1, 0x01, 0, 0, 2, 0, 0, 0, 0, 0, 0, 1, 'a', 0, 0, 1, 0, 1 };
+    add_raw(truncated, sizeof(truncated), DNS_REPLY_DROP);
+    add_raw(response, sizeof(response), DNS_REPLY_DROP);
+    add_raw(compressed, sizeof(compressed), DNS_REPLY_ERROR);
+    add_raw(opcode, sizeof(opcode), DNS_REPLY_ERROR);
+    add_raw(two_q, sizeof(two_q), DNS_REPLY_ERROR);
+}
+
+static void verify(void) {
+    uint8_t buf[512];
+    for (int i = 0; i < n_corpus; i++) {
+        dns_reply_kind_t kind;
+        memcpy(buf, corpus[i].pkt, corpus[i].len);
+        size_t len = dns_packet_build_response(buf, corpus[i].len, sizeof(buf), &kind);
+        CHECK_EQ(kind, corpus[i].expect);
+        if (kind == DNS_REPLY_DROP) {
+            CHECK_EQ(len, 0);
+            continue;
+        }
+        CHECK(buf[2] & 0x80);                           // QR
+        CHECK_EQ(buf[0], corpus[i].pkt[0]);             // Mismo ID
+        CHECK_EQ(buf[10] | buf[11], 0);                 // Sin adicionales (EDNS descartado)
+        if (kind == DNS_REPLY_A) {
+            CHECK_EQ(buf[7], 1);
+            CHECK(memcmp(buf + len - 4, "\xc0\xa8\x04\x01", 4) == 0);
+        } else if (kind == DNS_REPLY_EMPTY) {
+            CHECK_EQ(buf[7], 0);
+            CHECK_EQ(buf[3] & 0x0f, 0);
+        } else {
+            CHECK_EQ(len, DNS_HEADER_LEN);
+            CHECK(buf[3] & 0x0f);
+        }
+    }
+    CHECK(dns_packet_name_equals(corpus[4].pkt + DNS_HEADER_LEN, corpus[4].len, "SETUP.esp32"));
+    CHECK(!dns_packet_name_equals(corpus[4].pkt + DNS_HEADER_LEN, corpus[4].len, "setup.esp3"));
+}
+
+int main(int argc, char **argv) {
+    long rounds = (argc > 1) ? strtol(argv[1], NULL, 10) : 200000;
+    build_corpus();
+    verify();
+
+    uint8_t buf[512];
+    volatile size_t sink = 0;
+    double t0 = host_now_s();
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < n_corpus; i++) {
+            memcpy(buf, corpus[i].pkt, corpus[i].len);
+            sink += dns_packet_build_response(buf, corpus[i].len, sizeof(buf), NULL);
+        }
+    }
+    double dt = host_now_s() - t0;
+    long queries = rounds * n_corpus;
+    printf("dns replay: %ld consultas en %.3f s = %.0f consultas/s (%.1f ns/consulta)\n",
+           queries, dt, queries / dt, dt * 1e9 / queries);
+    (void)sink;
+    return host_test_result("dns_replay_bench");
+}
@@ -0,0 +1,13 @@
+#ifndef FAKE_IDF_ESP_HEAP_CAPS_H
+#define FAKE_IDF_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+/* Las cifras del heap las define cada prueba */
+size_t heap_caps_get_free_size(uint32_t caps);
+
+#endif // FAKE_IDF_ESP_HEAP_CAPS_H
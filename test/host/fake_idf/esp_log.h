@@ -0,0 +1,14 @@
+#ifndef FAKE_IDF_ESP_LOG_H
+#define FAKE_IDF_ESP_LOG_H
+
+#include "esp_err.h"
+
+/* Los logs del firmware salen por stderr solo con FAKE_IDF_LOG=1 en el entorno */
+void fake_idf_log(char level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, fmt, ...) fake_idf_log('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fake_idf_log('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fake_idf_log('I', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) fake_idf_log('D', tag, fmt, ##__VA_ARGS__)
+
+#endif // FAKE_IDF_ESP_LOG_H
@@ -0,0 +1,7 @@
+#ifndef FAKE_IDF_ESP_SYSTEM_H
+#define FAKE_IDF_ESP_SYSTEM_H
+
+/* La define cada prueba: en el host un reinicio es un error o el fin del escenario */
+void esp_restart(void);
+
+#endif // FAKE_IDF_ESP_SYSTEM_H
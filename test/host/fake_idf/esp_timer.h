@@ -0,0 +1,24 @@
+#ifndef FAKE_IDF_ESP_TIMER_H
+#define FAKE_IDF_ESP_TIMER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/* Reloj del host: monotónico real, o virtual si la prueba llamó a fake_clock_set_virtual() */
+int64_t esp_timer_get_time(void);
+
+/* Timers de un disparo: nunca disparan solos, fake_timer_run_due() (fake_idf.h) corre los vencidos */
+typedef void (*esp_timer_cb_t)(void *arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+} esp_timer_create_args_t;
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+
+#endif // FAKE_IDF_ESP_TIMER_H
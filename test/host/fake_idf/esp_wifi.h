@@ -0,0 +1,14 @@
+#ifndef FAKE_IDF_ESP_WIFI_H
+#define FAKE_IDF_ESP_WIFI_H
+
+#include "esp_err.h"
+#include "esp_wifi_types.h"
+
+/* La radio la implementa cada prueba (p. ej. el mundo de state_replay) */
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info);
+
+#endif // FAKE_IDF_ESP_WIFI_H
@@ -0,0 +1,212 @@
+#include "fake_idf.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+/* =========================
+   Reloj
+   ========================= */
+
+static bool clock_virtual = false;
+static int64_t virtual_us = 0;
+
+void fake_clock_set_virtual(int64_t start_us) {
+    clock_virtual = true;
+    virtual_us = start_us;
+}
+
+void fake_clock_advance_us(int64_t us) {
+    if (us > 0) virtual_us += us;
+}
+
+int64_t esp_timer_get_time(void) {
+    if (clock_virtual) return virtual_us;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* =========================
+   Timers
+   ========================= */
+
+#define FAKE_TIMERS 4
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    int64_t due_us;
+    bool armed;
+};
+
+static struct esp_timer timers[FAKE_TIMERS];
+static int n_timers = 0;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle) {
+    if (!args || !out_handle) return ESP_ERR_INVALID_ARG;
+    if (n_timers == FAKE_TIMERS) return ESP_ERR_NO_MEM;
+    timers[n_timers].args = *args;
+    *out_handle = &timers[n_timers++];
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->armed = true;
+    return ESP_OK;
+}
+
+int fake_timer_run_due(void) {
+    int fired = 0;
+    for (int i = 0; i < n_timers; i++) {
+        if (timers[i].armed && esp_timer_get_time() >= timers[i].due_us) {
+            timers[i].armed = false;
+            timers[i].args.callback(timers[i].args.arg);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+/* =========================
+   Log
+   ========================= */
+
+static uint32_t log_lines = 0;
+
+uint32_t fake_idf_log_lines(void) {
+    return log_lines;
+}
+
+void fake_idf_log(char level, const char *tag, const char *fmt, ...) {
+    static int enabled = -1;
+    log_lines++;
+    if (enabled < 0) enabled = getenv("FAKE_IDF_LOG") != NULL;
+    if (!enabled) return;
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%c (%lld) %s: ", level, (long long)(esp_timer_get_time() / 1000), tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+/* =========================
+   Tareas
+   ========================= */
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                           UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb, BaseType_t core) {
+    (void)stack_depth; (void)prio; (void)stack; (void)core;
+    tcb->fn = fn;
+    tcb->arg = arg;
+    tcb->name = name;
+    return tcb;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000 * portTICK_PERIOD_MS));
+}
+
+static fake_idle_hook_t idle_hook = NULL;
+static void *idle_arg = NULL;
+
+// Fin de una espera de 'ticks' desde ahora (INT64_MAX para portMAX_DELAY)
+static int64_t wait_until_us(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) return INT64_MAX;
+    return esp_timer_get_time() + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    int64_t until = wait_until_us(ticks);
+    if (idle_hook) idle_hook(until, NULL, idle_arg);
+    if (clock_virtual && until != INT64_MAX && virtual_us < until) virtual_us = until;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+/* =========================
+   Colas
+   ========================= */
+
+void fake_rtos_set_idle_hook(fake_idle_hook_t hook, void *arg) {
+    idle_hook = hook;
+    idle_arg = arg;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buf) {
+    buf->storage = storage;
+    buf->item_size = item_size;
+    buf->len = len;
+    buf->head = 0;
+    buf->count = 0;
+    return buf;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    if (q->count == q->len && wait > 0) {
+        // Llena con espera: el gancho es el único que puede vaciarla (otra "tarea" consumiendo)
+        int64_t until = wait_until_us(wait);
+        if (idle_hook) idle_hook(until, q, idle_arg);
+        if (q->count == q->len && clock_virtual && until != INT64_MAX && virtual_us < until) virtual_us = until;
+    }
+    if (q->count == q->len) return errQUEUE_FULL;
+    UBaseType_t tail = (q->head + q->count) % q->len;
+    if (q->item_size) memcpy(q->storage + tail * q->item_size, item, q->item_size);
+    q->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    if (q->count == 0 && wait > 0) {
+        int64_t until = wait_until_us(wait);
+        if (idle_hook) idle_hook(until, q, idle_arg);
+        // Nada llegó: la espera se cumple entera
+        if (q->count == 0 && clock_virtual && until != INT64_MAX && virtual_us < until) virtual_us = until;
+    }
+    if (q->count == 0) return pdFALSE;
+    if (q->item_size) memcpy(item, q->storage + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->len;
+    q->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    return q->count;
+}
+
+/* =========================
+   Netif
+   ========================= */
+
+struct esp_netif_obj {
+    esp_netif_ip_info_t ip_info;
+};
+
+static struct esp_netif_obj sta_netif;
+
+void fake_netif_set_ip_info(const esp_netif_ip_info_t *info) {
+    sta_netif.ip_info = *info;
+}
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key) {
+    return strcmp(if_key, "WIFI_STA_DEF") == 0 ? &sta_netif : NULL;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *netif, esp_netif_ip_info_t *ip_info) {
+    if (!netif || !ip_info) return ESP_ERR_INVALID_ARG;
+    *ip_info = netif->ip_info;
+    return ESP_OK;
+}
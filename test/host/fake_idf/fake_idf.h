@@ -0,0 +1,36 @@
+#ifndef FAKE_IDF_FAKE_IDF_H
+#define FAKE_IDF_FAKE_IDF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_netif.h"
+
+/*
+ * Controles de fake_idf para las pruebas del host.
+ */
+
+/** Pasa a reloj virtual (arranca en 'start_us'); hasta entonces esp_timer_get_time() es el monotónico real. */
+void fake_clock_set_virtual(int64_t start_us);
+void fake_clock_advance_us(int64_t us);
+
+/**
+ * Gancho de inactividad: corre cuando la tarea se bloquea (xQueueReceive con la cola vacía o xQueueSend
+ * con la cola llena, con espera > 0; o vTaskDelay con 'queue' en NULL). El escenario avanza el reloj
+ * virtual hasta 'until_us' como mucho y hace lo que harían las otras tareas; si 'queue' ya puede
+ * atenderse, puede volver antes. Con portMAX_DELAY 'until_us' es INT64_MAX. Sin gancho, la espera se
+ * consume entera en reloj virtual. Los semáforos son colas (freertos/semphr.h) y esperan igual.
+ */
+typedef void (*fake_idle_hook_t)(int64_t until_us, QueueHandle_t queue, void *arg);
+void fake_rtos_set_idle_hook(fake_idle_hook_t hook, void *arg);
+
+/** Corre los callbacks de los timers de un disparo ya vencidos. @return Cuántos corrieron. */
+int fake_timer_run_due(void);
+
+void fake_netif_set_ip_info(const esp_netif_ip_info_t *info);
+
+/** Líneas de log emitidas (se cuentan aunque FAKE_IDF_LOG no esté definida). */
+uint32_t fake_idf_log_lines(void);
+
+#endif // FAKE_IDF_FAKE_IDF_H
@@ -0,0 +1,24 @@
+#ifndef FAKE_IDF_FREERTOS_QUEUE_H
+#define FAKE_IDF_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+/* Cola circular sobre el almacenamiento estático del llamador */
+typedef struct fake_queue {
+    uint8_t *storage;
+    size_t item_size;
+    UBaseType_t len;
+    UBaseType_t head;
+    UBaseType_t count;
+} StaticQueue_t;
+
+typedef StaticQueue_t *QueueHandle_t;
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t len, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buf);
+/* Cola llena (en send) o vacía (en receive) con espera: corre el gancho de inactividad (fake_idf.h),
+   que puede avanzar el reloj y hacer lo que harían las otras tareas */
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif // FAKE_IDF_FREERTOS_QUEUE_H
@@ -0,0 +1,14 @@
+#ifndef FAKE_IDF_FREERTOS_SEMPHR_H
+#define FAKE_IDF_FREERTOS_SEMPHR_H
+
+#include "freertos/queue.h"
+
+/* Como en FreeRTOS: un semáforo binario es una cola de un lugar con elementos de largo 0 */
+typedef StaticQueue_t StaticSemaphore_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreCreateBinaryStatic(buf) xQueueCreateStatic(1, 0, NULL, (buf))
+#define xSemaphoreTake(sem, wait)         xQueueReceive((sem), NULL, (wait))
+#define xSemaphoreGive(sem)               xQueueSend((sem), NULL, 0)
+
+#endif // FAKE_IDF_FREERTOS_SEMPHR_H
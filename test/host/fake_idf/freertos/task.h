@@ -0,0 +1,23 @@
+#ifndef FAKE_IDF_FREERTOS_TASK_H
+#define FAKE_IDF_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+typedef struct fake_task {
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+} StaticTask_t;
+
+typedef StaticTask_t *TaskHandle_t;
+
+/* Las tareas no corren solas: se registran y la prueba llama a sus funciones */
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                           UBaseType_t prio, StackType_t *stack, StaticTask_t *tcb, BaseType_t core);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif // FAKE_IDF_FREERTOS_TASK_H
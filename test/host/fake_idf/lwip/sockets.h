@@ -0,0 +1,15 @@
+#ifndef FAKE_IDF_LWIP_SOCKETS_H
+#define FAKE_IDF_LWIP_SOCKETS_H
+
+/* En el host los sockets de lwIP son los de POSIX */
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#endif // FAKE_IDF_LWIP_SOCKETS_H
@@ -0,0 +1,53 @@
+#ifndef FAKE_IDF_SDKCONFIG_H
+#define FAKE_IDF_SDKCONFIG_H
+
+/*
+ * Configuración fija para compilar módulos de main/ en el host contra fake_idf.
+ * Los valores de Kconfig que una prueba necesita variar se definen como variables (ver fake_idf.h).
+ */
+
+#define CONFIG_FREERTOS_HZ                      1000
+
+#define CONFIG_WIFI_MGR_TASK_STATE_CORE         -1
+#define CONFIG_WIFI_MGR_TASK_STATE_PRIO         5
+#define CONFIG_WIFI_MGR_TASK_STATE_STACK        4096
+#define CONFIG_WIFI_MGR_TASK_DNS_CORE           -1
+#define CONFIG_WIFI_MGR_TASK_DNS_PRIO           5
+#define CONFIG_WIFI_MGR_TASK_DNS_STACK          4096
+#define CONFIG_WIFI_MGR_TASK_HTTPD_CORE         -1
+#define CONFIG_WIFI_MGR_TASK_HTTPD_PRIO         5
+#define CONFIG_WIFI_MGR_TASK_HTTPD_STACK        10240
+#define CONFIG_WIFI_MGR_TASK_PROBE_CORE         -1
+#define CONFIG_WIFI_MGR_TASK_PROBE_PRIO         3
+#define CONFIG_WIFI_MGR_TASK_PROBE_STACK        3072
+#define CONFIG_WIFI_MGR_TASK_OTA_CORE           -1
+#define CONFIG_WIFI_MGR_TASK_OTA_PRIO           5
+#define CONFIG_WIFI_MGR_TASK_OTA_STACK          3072
+
+#define CONFIG_WIFI_MGR_OTA                     1
+#define CONFIG_WIFI_MGR_OTA_CHUNK               4096
+
+#define CONFIG_WIFI_MGR_FAST_BOOT               1
+#define CONFIG_WIFI_MGR_BOOT_BUDGET_MS          4000
+
+#define CONFIG_WIFI_MGR_SCAN_BACKOFF_MIN_S      30
+#define CONFIG_WIFI_MGR_SCAN_BACKOFF_MAX_S      600
+#define CONFIG_WIFI_MGR_SCAN_ACTIVE_EVERY       4
+
+#define CONFIG_WIFI_MGR_LINK_PROBE              1
+#define CONFIG_WIFI_MGR_LINK_PROBE_INTERVAL_S   15
+#define CONFIG_WIFI_MGR_LINK_PROBE_TCP_HOST     "127.0.0.1"
+#define CONFIG_WIFI_MGR_LINK_PROBE_TCP_PORT     fake_link_probe_tcp_port
+#define CONFIG_WIFI_MGR_LINK_PROBE_FAIL_ROUNDS  4
+#define CONFIG_WIFI_MGR_LINK_PROBE_LOSS_PCT     50
+
+#define CONFIG_WIFI_MGR_TELEMETRY               1
+#define CONFIG_WIFI_MGR_TELEMETRY_HOST          "127.0.0.1"
+#define CONFIG_WIFI_MGR_TELEMETRY_PORT          fake_telemetry_port
+#define CONFIG_WIFI_MGR_TELEMETRY_INTERVAL_S    30
+#define CONFIG_WIFI_MGR_TELEMETRY_PAYLOAD       256
+
+extern int fake_link_probe_tcp_port; // Puerto efímero del endpoint de prueba
+extern int fake_telemetry_port;      // Puerto efímero del colector de prueba
+
+#endif // FAKE_IDF_SDKCONFIG_H
@@ -0,0 +1,36 @@
+#include "fuzz_target.h"
+#include "dns_packet.h"
+#include <string.h>
+
+/*
+ * Datagrama arbitrario al responder del portal, en un buffer del tamaño del de dns_server.
+ * La respuesta se arma en el mismo buffer y nunca pasa de 'cap'.
+ */
+
+#define DNS_BUF_LEN 512
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > DNS_BUF_LEN) return 0; // recvfrom() nunca entrega más
+    uint8_t *buf = malloc(DNS_BUF_LEN);
+    memcpy(buf, data, size);
+
+    dns_question_t q;
+    int rc = dns_packet_parse_question(buf, size, &q);
+    if (rc == 0) {
+        FUZZ_CHECK(q.name_off == DNS_HEADER_LEN);
+        FUZZ_CHECK(q.name_len >= 1 && q.name_len <= DNS_MAX_NAME_LEN);
+        FUZZ_CHECK(q.qend <= size);
+    }
+
+    dns_reply_kind_t kind;
+    size_t len = dns_packet_build_response(buf, size, DNS_BUF_LEN, &kind);
+    if (kind == DNS_REPLY_DROP) {
+        FUZZ_CHECK(len == 0);
+    } else {
+        FUZZ_CHECK(len >= DNS_HEADER_LEN && len <= DNS_BUF_LEN);
+        FUZZ_CHECK(buf[2] & 0x80);
+        FUZZ_CHECK(memcmp(buf, data, 2) == 0); // Mismo ID
+    }
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "fuzz_target.h"
+#include "portal_parse.h"
+#include <string.h>
+
+/*
+ * SSID arbitrario (bytes crudos del aire). La salida nunca pasa de 'cap' ni corta un escape, y lo
+ * escapado vuelve a leerse igual con portal_json_get_string (salvo bytes NUL, que el parser rechaza).
+ */
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    // Recortada: escape a mitad de camino, siempre terminado y sin barra colgando
+    size_t small = size % 16 + 1;
+    char *out = malloc(small);
+    size_t n = portal_json_escape(data, size, out, small);
+    FUZZ_CHECK(n < small);
+    FUZZ_CHECK(out[n] == '\0');
+    size_t bs = 0;
+    while (bs < n && out[n - 1 - bs] == '\\') bs++;
+    FUZZ_CHECK(bs % 2 == 0);
+    free(out);
+
+    // Completa (6 bytes por entrada como máximo) y de vuelta
+    size_t cap = size * 6 + 1;
+    out = malloc(cap);
+    n = portal_json_escape(data, size, out, cap);
+    FUZZ_CHECK(n < cap);
+    FUZZ_CHECK(strlen(out) == n);
+    for (size_t i = 0; i < n; i++) {
+        FUZZ_CHECK((uint8_t)out[i] >= 0x20 && out[i] != 0x7f && out[i] != '<' && out[i] != '>');
+    }
+
+    if (memchr(data, '\0', size) == NULL) {
+        size_t json_len = n + 8;
+        char *json = malloc(json_len);
+        memcpy(json, "{\"k\":\"", 6);
+        memcpy(json + 6, out, n);
+        memcpy(json + 6 + n, "\"}", 2);
+        char *back = malloc(size + 1);
+        int got = portal_json_get_string(json, json_len, "k", back, size + 1);
+        FUZZ_CHECK(got == (int)size);
+        FUZZ_CHECK(memcmp(back, data, size) == 0);
+        free(back);
+        free(json);
+    }
+    free(out);
+    return 0;
+}
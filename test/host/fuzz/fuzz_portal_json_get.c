@@ -0,0 +1,31 @@
+#include "fuzz_target.h"
+#include "portal_parse.h"
+#include <string.h>
+
+/*
+ * Cuerpo de /connect arbitrario. Cada salida va en un buffer del heap del tamaño exacto de 'cap'
+ * (ASan marca cualquier byte de más). Se prueban los tamaños reales y uno chico para forzar el recorte.
+ */
+
+static void get_one(const char *body, size_t len, const char *key, size_t cap) {
+    char *out = malloc(cap);
+    int n = portal_json_get_string(body, len, key, out, cap);
+    FUZZ_CHECK(n >= -1);
+    if (n >= 0) {
+        FUZZ_CHECK((size_t)n < cap);
+        FUZZ_CHECK(out[n] == '\0');
+        FUZZ_CHECK(memchr(out, '\0', n) == NULL); // \u0000 se rechaza
+    }
+    free(out);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    // Copia exacta: el parser no puede apoyarse en un '\0' después de 'len'
+    char *body = malloc(size ? size : 1);
+    memcpy(body, data, size);
+    get_one(body, size, "ssid", 33);
+    get_one(body, size, "pass", 65);
+    get_one(body, size, "ssid", size % 8 + 1);
+    free(body);
+    return 0;
+}
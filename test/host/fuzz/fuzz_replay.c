@@ -0,0 +1,128 @@
+#include "fuzz_target.h"
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*
+ * Driver sin libFuzzer (gcc u otro compilador): corre cada archivo del corpus semilla y, por cada uno,
+ * FUZZ_REPLAY_MUTATIONS variantes deterministas (bytes cambiados, insertados, borrados, recortes).
+ * No reemplaza al fuzzer guiado por cobertura, pero mantiene las invariantes probadas en ctest.
+ *   fuzz_<parser>_replay <directorio o archivo>...
+ */
+
+#define FUZZ_REPLAY_MAX_INPUT 4096
+#define FUZZ_REPLAY_MUTATIONS 2000
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static const uint8_t interesting[] = { 0x00, 0x01, 0x1f, 0x20, '"', '\\', '{', '}', ':', ',', 'u', '0',
+                                       0x7f, 0x80, 0xc0, 0xff };
+
+static size_t mutate(uint8_t *buf, size_t len) {
+    int edits = 1 + rng() % 4;
+    for (int e = 0; e < edits; e++) {
+        switch (rng() % 5) {
+            case 0: // Byte al azar
+                if (len) buf[rng() % len] = (uint8_t)rng();
+                break;
+            case 1: // Byte con significado para los parsers
+                if (len) buf[rng() % len] = interesting[rng() % sizeof(interesting)];
+                break;
+            case 2: // Inserción
+                if (len < FUZZ_REPLAY_MAX_INPUT) {
+                    size_t at = len ? rng() % (len + 1) : 0;
+                    memmove(buf + at + 1, buf + at, len - at);
+                    buf[at] = interesting[rng() % sizeof(interesting)];
+                    len++;
+                }
+                break;
+            case 3: // Borrado
+                if (len) {
+                    size_t at = rng() % len;
+                    memmove(buf + at, buf + at + 1, len - at - 1);
+                    len--;
+                }
+                break;
+            default: // Recorte
+                if (len) len = rng() % len;
+                break;
+        }
+    }
+    return len;
+}
+
+static long run_file(const char *path) {
+    static uint8_t seed[FUZZ_REPLAY_MAX_INPUT], buf[FUZZ_REPLAY_MAX_INPUT];
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: no se puede abrir\n", path);
+        return -1;
+    }
+    size_t len = fread(seed, 1, sizeof(seed), f);
+    fclose(f);
+
+    // Cada caso en un bloque del heap de su tamaño exacto: ASan ve las lecturas de más
+    uint8_t *exact = malloc(len ? len : 1);
+    memcpy(exact, seed, len);
+    LLVMFuzzerTestOneInput(exact, len);
+    free(exact);
+    for (int m = 0; m < FUZZ_REPLAY_MUTATIONS; m++) {
+        memcpy(buf, seed, len);
+        size_t n = mutate(buf, len);
+        exact = malloc(n ? n : 1);
+        memcpy(exact, buf, n);
+        LLVMFuzzerTestOneInput(exact, n);
+        free(exact);
+    }
+    return 1 + FUZZ_REPLAY_MUTATIONS;
+}
+
+static long run_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: no existe\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) return run_file(path);
+
+    DIR *d = opendir(path);
+    if (!d) return -1;
+    long total = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        char child[1024];
+        snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+        long n = run_file(child);
+        if (n < 0) {
+            total = -1;
+            break;
+        }
+        total += n;
+    }
+    closedir(d);
+    return total;
+}
+
+int main(int argc, char **argv) {
+    long total = 0;
+    for (int i = 1; i < argc; i++) {
+        long n = run_path(argv[i]);
+        if (n < 0) return EXIT_FAILURE;
+        total += n;
+    }
+    if (total == 0) {
+        fprintf(stderr, "uso: %s <corpus>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("%s: %ld entradas sin fallas\n", argv[0], total);
+    return EXIT_SUCCESS;
+}
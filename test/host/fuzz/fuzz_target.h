@@ -0,0 +1,18 @@
+#ifndef FUZZ_TARGET_H
+#define FUZZ_TARGET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+ * Punto de entrada de libFuzzer. Con clang se enlaza con -fsanitize=fuzzer; con otros compiladores
+ * fuzz_replay.c lo corre sobre el corpus semilla y mutaciones deterministas.
+ * Una invariante rota aborta: para el fuzzer es un hallazgo, igual que un acceso fuera de rango.
+ */
+
+#define FUZZ_CHECK(cond) do { if (!(cond)) abort(); } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#endif // FUZZ_TARGET_H
@@ -0,0 +1,201 @@
+/*
+ * Sonda de enlace contra endpoints de prueba locales: el gateway es 127.0.0.1 (el kernel contesta el
+ * echo ICMP si hay permiso para sockets raw) y el host TCP es un listener efímero en loopback.
+ * Se incluye link_probe.c para llamar a las rondas directamente, sin esperar el intervalo de la tarea.
+ */
+#include "link_probe.c"
+
+#include "fake_idf.h"
+#include "host_test.h"
+
+int fake_link_probe_tcp_port = 0;
+
+/* =========================
+   Dependencias del módulo
+   ========================= */
+
+static conn_event_cb_t bus_cb = NULL;
+static void *bus_cb_arg = NULL;
+static QueueHandle_t bus_queue = NULL;
+static uint32_t latency_samples = 0;
+static conn_status_t bus_status = {0};
+
+bool conn_bus_subscribe_queue(QueueHandle_t q) {
+    bus_queue = q;
+    return true;
+}
+
+bool conn_bus_subscribe_cb(conn_event_cb_t cb, void *arg) {
+    bus_cb = cb;
+    bus_cb_arg = arg;
+    return true;
+}
+
+void conn_bus_get_status(conn_status_t *out) {
+    *out = bus_status;
+}
+
+void power_save_record_latency(uint32_t latency_us) {
+    latency_samples++;
+}
+
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes) {
+}
+
+// Como conn_bus_publish(): callbacks en el contexto del publicador, después la cola de la tarea
+static void publish(conn_event_type_t type) {
+    conn_event_t evt = { .type = type, .timestamp_us = esp_timer_get_time() };
+    if (bus_cb) bus_cb(&evt, bus_cb_arg);
+    if (bus_queue) xQueueSend(bus_queue, &evt, 0);
+}
+
+/* =========================
+   Endpoints de prueba
+   ========================= */
+
+static int open_listener(void) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(a);
+    if (s < 0 || bind(s, (struct sockaddr *)&a, sizeof(a)) < 0 || listen(s, 16) < 0 ||
+        getsockname(s, (struct sockaddr *)&a, &alen) < 0) {
+        if (s >= 0) close(s);
+        return -1;
+    }
+    fake_link_probe_tcp_port = ntohs(a.sin_port);
+    return s;
+}
+
+// Acepta las conexiones pendientes para que el backlog no se llene
+static void drain_listener(int s) {
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    int c;
+    while ((c = accept(s, NULL, NULL)) >= 0) close(c);
+}
+
+static bool raw_icmp_available(void) {
+    int s = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    if (s < 0) return false;
+    close(s);
+    return true;
+}
+
+/* =========================
+   Casos
+   ========================= */
+
+static const uint32_t gw = 0x0100007f; // 127.0.0.1 en orden de red
+
+static void got_ip(void) {
+    publish(CONN_EVT_GOT_IP);
+    conn_event_t evt;
+    while (xQueueReceive(probe_queue, &evt, 0) == pdTRUE) {
+        if (evt.type == CONN_EVT_GOT_IP) window_reset(); // Lo que hace la tarea al consumirlo
+    }
+}
+
+static void test_healthy_then_dead_upstream(int listener, bool icmp) {
+    got_ip();
+    for (int i = 0; i < 3; i++) {
+        probe_round(gw);
+        drain_listener(listener);
+    }
+    link_probe_stats_t s;
+    link_probe_get_stats(&s);
+    CHECK_EQ(s.window_samples, 3);
+    CHECK_EQ(s.loss_pct, 0);
+    CHECK_EQ(s.tcp_lost, 0);
+    CHECK(s.rtt_us_last > 0);
+    CHECK(s.rtt_us_min <= s.rtt_us_avg && s.rtt_us_avg <= s.rtt_us_max);
+    CHECK_EQ(s.gw_answers, icmp);
+    CHECK_EQ(latency_samples > 0, icmp);
+    CHECK(!link_probe_is_degraded());
+    printf("  rtt loopback: último %u us, promedio %u us (ICMP %s)\n",
+           (unsigned)s.rtt_us_last, (unsigned)s.rtt_us_avg, icmp ? "sí" : "sin permiso, solo TCP");
+
+    // Upstream muerto: el connect() se rechaza. Degradado recién al llegar a FAIL_ROUNDS seguidas.
+    close(listener);
+    for (int i = 1; i < CONFIG_WIFI_MGR_LINK_PROBE_FAIL_ROUNDS; i++) {
+        probe_round(gw);
+        CHECK(!link_probe_is_degraded());
+    }
+    probe_round(gw);
+    link_probe_get_stats(&s);
+    CHECK(link_probe_is_degraded());
+    CHECK_EQ(s.consecutive_fail, CONFIG_WIFI_MGR_LINK_PROBE_FAIL_ROUNDS);
+    CHECK_EQ(s.degraded_events, 1);
+
+    // Más rondas fallidas no vuelven a contar el mismo episodio
+    probe_round(gw);
+    link_probe_get_stats(&s);
+    CHECK_EQ(s.degraded_events, 1);
+}
+
+static void test_cleared_on_disconnect(void) {
+    // El veredicto se limpia al publicarse la caída, antes de que la tarea consuma su cola
+    CHECK(link_probe_is_degraded());
+    publish(CONN_EVT_STA_DISCONNECTED);
+    CHECK(!link_probe_is_degraded());
+    CHECK_EQ(uxQueueMessagesWaiting(probe_queue), 1);
+
+    degraded = true;
+    publish(CONN_EVT_LOST_IP);
+    CHECK(!link_probe_is_degraded());
+
+    degraded = true;
+    publish(CONN_EVT_STA_CONNECTED); // Asociado sin IP: todavía no hay veredicto nuevo
+    CHECK(link_probe_is_degraded());
+    publish(CONN_EVT_GOT_IP);
+    CHECK(!link_probe_is_degraded());
+
+    conn_event_t evt;
+    while (xQueueReceive(probe_queue, &evt, 0) == pdTRUE) {
+    }
+}
+
+static void test_sustained_loss(void) {
+    // Alterna éxito y fallo: nunca FAIL_ROUNDS seguidas, pero 50 % de pérdida con ventana suficiente
+    int listener = open_listener();
+    CHECK(listener >= 0);
+    got_ip();
+    int rounds = 0;
+    while (!link_probe_is_degraded() && rounds < LINK_PROBE_WINDOW) {
+        probe_round(gw);
+        drain_listener(listener);
+        rounds++;
+        window_push(PROBE_LOST);
+        evaluate();
+        rounds++;
+    }
+    link_probe_stats_t s;
+    link_probe_get_stats(&s);
+    CHECK(link_probe_is_degraded());
+    CHECK_EQ(rounds, PROBE_MIN_SAMPLES);
+    CHECK_EQ(s.loss_pct, 50);
+    CHECK(s.consecutive_fail < CONFIG_WIFI_MGR_LINK_PROBE_FAIL_ROUNDS);
+    close(listener);
+}
+
+int main(void) {
+    bool icmp = raw_icmp_available();
+    int listener = open_listener();
+    if (listener < 0) {
+        fprintf(stderr, "sin listener TCP en loopback\n");
+        return EXIT_FAILURE;
+    }
+    esp_netif_ip_info_t info = { .gw.addr = gw };
+    fake_netif_set_ip_info(&info);
+    // Fast boot: la IP ya está en la foto al suscribirse; la tarea igual tiene que enterarse
+    bus_status.connected = true;
+    bus_status.ip = gw;
+    link_probe_init();
+    CHECK(bus_cb != NULL);
+    CHECK(bus_queue == probe_queue);
+    conn_event_t first;
+    CHECK(xQueueReceive(probe_queue, &first, 0) == pdTRUE && first.type == CONN_EVT_GOT_IP);
+
+    test_healthy_then_dead_upstream(listener, icmp);
+    test_cleared_on_disconnect();
+    test_sustained_loss();
+    return host_test_result("link_probe_test");
+}
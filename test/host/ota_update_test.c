@@ -0,0 +1,369 @@
+/*
+ * Pipeline OTA de doble buffer contra una partición simulada en reloj virtual. La recepción (tarea
+ * httpd) se reproduce como en ota_handler() de http_server.c; la tarea ota_writer corre en el gancho
+ * de inactividad: cuando la recepción se bloquea, graba los chunks encolados al ritmo de la flash.
+ * Se incluye ota_update.c para llamar a writer_step() y ver sus colas.
+ */
+#include "ota_update.c"
+
+#include "fake_idf.h"
+#include "host_test.h"
+
+#define NET_US_PER_KB   10000 // ~100 KB/s desde el socket
+#define FLASH_US_PER_KB 7500  // Borrado de sector + escritura
+#define SLOT_SIZE       0xF0000
+
+/* =========================
+   Partición simulada (esp_ota_*)
+   ========================= */
+
+static struct {
+    esp_partition_t slots[2];
+    esp_ota_handle_t handle;   // Handle abierto (0: ninguno)
+    esp_ota_handle_t last;
+    uint8_t seed;              // Contenido esperado: byte i = i * 7 + seed
+    size_t expected_len;
+    size_t len;
+    uint32_t corrupt;          // Bytes fuera de orden o de otra imagen
+    uint32_t stale_writes;     // Escrituras sobre un handle cerrado o abortado
+    uint32_t writes;
+    uint32_t fail_write_at;    // Número de write que falla (0: ninguno)
+    uint32_t aborts;
+    bool boot_set;
+    uint32_t restarts;
+} flash = {
+    .slots = { { .address = 0x10000, .size = SLOT_SIZE, .label = "ota_0" },
+               { .address = 0x100000, .size = SLOT_SIZE, .label = "ota_1" } },
+};
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from) {
+    return &flash.slots[1];
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void) {
+    return &flash.slots[0];
+}
+
+const esp_partition_t *esp_ota_get_last_invalid_partition(void) {
+    return NULL;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle) {
+    flash.handle = ++flash.last;
+    flash.len = 0;
+    flash.corrupt = 0;
+    flash.writes = 0;
+    flash.boot_set = false;
+    *out_handle = flash.handle;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size) {
+    if (handle == 0 || handle != flash.handle) {
+        flash.stale_writes++;
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (++flash.writes == flash.fail_write_at) return ESP_FAIL;
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != (uint8_t)((flash.len + i) * 7 + flash.seed)) flash.corrupt++;
+    }
+    flash.len += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    if (handle == 0 || handle != flash.handle) return ESP_ERR_INVALID_ARG;
+    flash.handle = 0;
+    return (flash.len == flash.expected_len && flash.corrupt == 0) ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    if (handle == flash.handle) flash.handle = 0;
+    flash.aborts++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+    flash.boot_set = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *state) {
+    *state = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    flash.restarts++;
+}
+
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes) {
+}
+
+/* =========================
+   Tarea de escritura simulada
+   ========================= */
+
+// Momento en que cada chunk quedó listo (FIFO paralela a full_q, sin los marcadores de fin)
+#define READY_FIFO 8
+
+static struct {
+    bool stalled;              // Atascada dentro de esp_ota_write: no devuelve el chunk que tiene
+    bool in_hand;
+    ota_chunk_t hand;
+    int64_t busy_until;
+    int64_t ready[READY_FIFO];
+    int ready_head, ready_count;
+} writer;
+
+static void ready_push(int64_t t) {
+    writer.ready[(writer.ready_head + writer.ready_count++) % READY_FIFO] = t;
+}
+
+static int64_t ready_pop(void) {
+    int64_t t = writer.ready[writer.ready_head];
+    writer.ready_head = (writer.ready_head + 1) % READY_FIFO;
+    writer.ready_count--;
+    return t;
+}
+
+static bool take_chunk(void) {
+    if (writer.in_hand) return true;
+    if (xQueueReceive(full_q, &writer.hand, 0) != pdTRUE) return false;
+    writer.in_hand = true;
+    return true;
+}
+
+// Graba un chunk empezando cuando estuvo listo y la flash quedó libre, lo que pase último
+static bool writer_run_one(void) {
+    if (!take_chunk()) return false;
+    ota_chunk_t c = writer.hand;
+    writer.in_hand = false;
+
+    int64_t now = esp_timer_get_time();
+    int64_t start = c.buf ? ready_pop() : now;
+    if (start < writer.busy_until) start = writer.busy_until;
+    bool writes = c.buf && c.session == session && write_err == ESP_OK;
+    int64_t done = start + (writes ? (int64_t)c.len * FLASH_US_PER_KB / 1024 : 0);
+    if (done > now) fake_clock_advance_us(done - now);
+    writer.busy_until = done;
+    writer_step(&c);
+    return true;
+}
+
+static bool can_proceed(QueueHandle_t q) {
+    return (q == full_q) ? q->count < q->len : q->count > 0;
+}
+
+static void writer_idle(int64_t until_us, QueueHandle_t q, void *arg) {
+    if (writer.stalled) {
+        take_chunk(); // El que se está grabando sale de la cola, como en la tarea real
+        return;
+    }
+    while (q && !can_proceed(q) && writer_run_one()) {
+    }
+}
+
+static void writer_catch_up(void) {
+    writer.stalled = false;
+    while (writer_run_one()) {
+    }
+}
+
+/* =========================
+   Recepción (como ota_handler)
+   ========================= */
+
+// Sube una imagen de 'content_len' bytes de la que llegan 'body_len' antes de que el cliente corte
+static esp_err_t upload(size_t content_len, size_t body_len, uint8_t seed) {
+    flash.seed = seed;
+    flash.expected_len = content_len;
+    esp_err_t err = ota_update_begin(content_len);
+    if (err != ESP_OK) return err;
+
+    size_t remaining = content_len;
+    size_t sent = 0;
+    while (remaining > 0) {
+        size_t cap = 0;
+        uint8_t *buf = ota_update_acquire_buffer(&cap);
+        if (!buf) break;
+
+        size_t want = remaining < cap ? remaining : cap;
+        size_t fill = want;
+        if (sent + fill > body_len) fill = body_len - sent; // El cliente cortó
+        for (size_t i = 0; i < fill; i++) buf[i] = (uint8_t)((sent + i) * 7 + seed);
+        fake_clock_advance_us((int64_t)fill * NET_US_PER_KB / 1024);
+        sent += fill;
+        if (fill < want) {
+            ota_update_release_buffer(buf);
+            break;
+        }
+        ready_push(esp_timer_get_time());
+        if (ota_update_submit(buf, fill) != ESP_OK) break;
+        remaining -= fill;
+    }
+
+    if (remaining > 0) {
+        ota_update_abort();
+        return ESP_FAIL;
+    }
+    return ota_update_finish();
+}
+
+/* =========================
+   Casos
+   ========================= */
+
+static void test_throughput(void) {
+    size_t size = 256 * 1024;
+    CHECK_EQ(upload(size, size, 1), ESP_OK);
+
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK_EQ(p.state, OTA_STATE_DONE);
+    CHECK_EQ(p.written, size);
+    CHECK_EQ(flash.len, size);
+    CHECK_EQ(flash.corrupt, 0);
+    CHECK(flash.boot_set);
+
+    // Con la flash más rápida que la red, el pipeline tarda la recepción más el último chunk
+    uint32_t net_ms = (uint32_t)(size / 1024 * NET_US_PER_KB / 1000);
+    uint32_t serial_ms = (uint32_t)(size / 1024 * (NET_US_PER_KB + FLASH_US_PER_KB) / 1000);
+    CHECK(p.elapsed_ms >= net_ms);
+    CHECK(p.elapsed_ms < net_ms + 100);
+    CHECK_EQ(p.stall_ms, 0);
+    printf("  pipeline: %lu KB en %lu ms (%lu KB/s, %lu ms esperando a la flash); en serie serían %lu ms\n",
+           (unsigned long)(p.written / 1024), (unsigned long)p.elapsed_ms, (unsigned long)p.kbps,
+           (unsigned long)p.stall_ms, (unsigned long)serial_ms);
+
+    ota_update_reboot_later(500);
+    CHECK_EQ(fake_timer_run_due(), 0);
+    fake_clock_advance_us(500 * 1000);
+    CHECK_EQ(fake_timer_run_due(), 1);
+    CHECK_EQ(flash.restarts, 1);
+}
+
+static void test_slow_flash_stalls(void) {
+    // Flash tres veces más lenta que la red: la recepción espera y el stall lo refleja
+    size_t size = 64 * 1024;
+    int64_t t0 = esp_timer_get_time();
+    writer.busy_until = t0 + 3 * (int64_t)OTA_CHUNK * FLASH_US_PER_KB / 1024; // Sector en borrado
+    CHECK_EQ(upload(size, size, 2), ESP_OK);
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK(p.stall_ms > 0);
+    CHECK_EQ(p.written, size);
+}
+
+static void test_short_body(void) {
+    uint32_t aborts = flash.aborts;
+    CHECK_EQ(upload(64 * 1024, 10 * 1024, 3), ESP_FAIL);
+
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK_EQ(p.state, OTA_STATE_FAILED);
+    CHECK_EQ(p.last_err, ESP_FAIL);
+    CHECK_EQ(flash.aborts, aborts + 1);
+    CHECK(!flash.boot_set);
+    CHECK_EQ(uxQueueMessagesWaiting(free_q), OTA_BUFFERS); // Ningún buffer quedó perdido
+    CHECK_EQ(uxQueueMessagesWaiting(full_q), 0);
+}
+
+static void test_write_error(void) {
+    flash.fail_write_at = 5;
+    CHECK_EQ(upload(64 * 1024, 64 * 1024, 4), ESP_FAIL);
+    flash.fail_write_at = 0;
+
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK_EQ(p.state, OTA_STATE_FAILED);
+    CHECK_EQ(p.last_err, ESP_FAIL);
+    CHECK_EQ(p.written, 4 * OTA_CHUNK);
+    CHECK(p.received < 64 * 1024);         // La recepción se cortó al ver el error
+    CHECK_EQ(flash.writes, 5);             // Ni un write más después del que falló
+    CHECK_EQ(flash.stale_writes, 0);
+    CHECK_EQ(uxQueueMessagesWaiting(free_q), OTA_BUFFERS);
+}
+
+// Drain vencido: la tarea de escritura se atasca en la flash y finish() se rinde a los OTA_BUFFER_WAIT_MS
+static void start_stuck_session(uint8_t seed) {
+    size_t size = 8 * OTA_CHUNK;
+    flash.seed = seed;
+    flash.expected_len = size;
+    CHECK_EQ(ota_update_begin(size), ESP_OK);
+    for (size_t sent = 0; sent < size; sent += OTA_CHUNK) {
+        size_t cap;
+        uint8_t *buf = ota_update_acquire_buffer(&cap);
+        CHECK(buf != NULL);
+        for (size_t i = 0; i < OTA_CHUNK; i++) buf[i] = (uint8_t)((sent + i) * 7 + seed);
+        ready_push(esp_timer_get_time());
+        ota_update_submit(buf, OTA_CHUNK);
+    }
+    writer.stalled = true;
+    int64_t t0 = esp_timer_get_time();
+    CHECK_EQ(ota_update_finish(), ESP_ERR_TIMEOUT);
+    CHECK(esp_timer_get_time() - t0 >= OTA_BUFFER_WAIT_MS * 1000LL);
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK_EQ(p.state, OTA_STATE_FAILED);
+}
+
+static void check_clean_session(uint8_t seed) {
+    size_t size = 4 * OTA_CHUNK;
+    CHECK_EQ(upload(size, size, seed), ESP_OK);
+    ota_progress_t p;
+    ota_update_get_progress(&p);
+    CHECK_EQ(p.state, OTA_STATE_DONE);
+    CHECK_EQ(p.written, size);
+    CHECK_EQ(flash.len, size);
+    CHECK_EQ(flash.corrupt, 0);      // Nada de la subida anterior se coló en esta
+    CHECK_EQ(flash.stale_writes, 0); // Ni se grabó sobre el handle abortado
+    CHECK_EQ(uxQueueMessagesWaiting(free_q), OTA_BUFFERS);
+}
+
+static void test_drain_timeout_then_new_session(void) {
+    // La tarea se destraba antes de la sesión nueva: su give tardío no puede adelantar el próximo drain
+    start_stuck_session(5);
+    writer_catch_up();
+    CHECK_EQ(uxQueueMessagesWaiting(flushed), 1);
+    check_clean_session(6);
+
+    // Se destraba con la sesión nueva ya abierta: lo encolado de la anterior se descarta
+    start_stuck_session(7);
+    flash.seed = 8;
+    flash.expected_len = 4 * OTA_CHUNK;
+    CHECK_EQ(ota_update_begin(4 * OTA_CHUNK), ESP_OK);
+    writer_catch_up();
+    CHECK_EQ(uxQueueMessagesWaiting(flushed), 0);
+    CHECK_EQ(uxQueueMessagesWaiting(free_q), OTA_BUFFERS);
+    CHECK_EQ(flash.len, 0);
+    ota_update_abort();
+    check_clean_session(9);
+}
+
+static void test_rejects(void) {
+    CHECK_EQ(ota_update_begin(0), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(ota_update_begin(SLOT_SIZE + 1), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(ota_update_begin(OTA_CHUNK), ESP_OK);
+    CHECK_EQ(ota_update_begin(OTA_CHUNK), ESP_ERR_INVALID_STATE); // Una sola subida a la vez
+    ota_update_abort();
+}
+
+int main(void) {
+    fake_clock_set_virtual(0);
+    fake_rtos_set_idle_hook(writer_idle, NULL);
+    ota_update_init();
+
+    test_throughput();
+    test_slow_flash_stalls();
+    test_short_body();
+    test_write_error();
+    test_drain_timeout_then_new_session();
+    test_rejects();
+    return host_test_result("ota_update_test");
+}
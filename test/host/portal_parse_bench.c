@@ -0,0 +1,63 @@
+#include "portal_parse.h"
+#include "host_test.h"
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * Micro-benchmark de los parsers del portal: cuerpos de /connect típicos y con escapes, y SSIDs del
+ * álbum escapados para /scan. Primero verifica cada caso, después lo repite N veces y reporta
+ * ns/op y bytes de entrada por op (y su caudal), para comparar cambios de endurecimiento.
+ */
+
+typedef struct {
+    const char *name;
+    const char *input;
+    const char *key;     // NULL: caso de portal_json_escape
+    const char *expect;
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+    { "connect_plain",   "{\"ssid\":\"Oficina 3er piso\",\"pass\":\"una-clave-larga-2024\"}", "pass",
+      "una-clave-larga-2024" },
+    { "connect_escaped", "{\"ssid\":\"Caf\\u00e9 \\\"El Sol\\\"\",\"pass\":\"a\\\\b\\/c\\u20ac\"}", "ssid",
+      "Caf\xc3\xa9 \"El Sol\"" },
+    { "connect_spaced",  "{ \"pass\" : \"12345678\" ,\r\n  \"n\" : 3 , \"ssid\" : \"MOVISTAR_4F2A\" }", "ssid",
+      "MOVISTAR_4F2A" },
+    { "escape_plain",    "MOVISTAR_PLUS_4F2A_5GHz_EXT12", NULL, "MOVISTAR_PLUS_4F2A_5GHz_EXT12" },
+    { "escape_specials", "a\"b\\c<d>\x01", NULL, "a\\\"b\\\\c\\u003cd\\u003e\\u0001" },
+};
+
+#define N_CASES (sizeof(cases) / sizeof(cases[0]))
+
+static int run_case(const bench_case_t *c, char *out, size_t cap) {
+    size_t len = strlen(c->input);
+    if (c->key) return portal_json_get_string(c->input, len, c->key, out, cap);
+    return (int)portal_json_escape((const uint8_t *)c->input, len, out, cap);
+}
+
+static void verify(void) {
+    char out[256];
+    for (size_t i = 0; i < N_CASES; i++) {
+        int n = run_case(&cases[i], out, sizeof(out));
+        CHECK_EQ(n, strlen(cases[i].expect));
+        CHECK(n >= 0 && strcmp(out, cases[i].expect) == 0);
+    }
+}
+
+int main(int argc, char **argv) {
+    long rounds = (argc > 1) ? strtol(argv[1], NULL, 10) : 1000000;
+    verify();
+
+    char out[256];
+    volatile int sink = 0;
+    for (size_t i = 0; i < N_CASES; i++) {
+        size_t bytes = strlen(cases[i].input);
+        double t0 = host_now_s();
+        for (long r = 0; r < rounds; r++) sink += run_case(&cases[i], out, sizeof(out));
+        double dt = host_now_s() - t0;
+        printf("  %-16s %7.1f ns/op  %4zu bytes/op  %7.1f MB/s\n", cases[i].name, dt * 1e9 / rounds, bytes,
+               bytes * rounds / dt / 1e6);
+    }
+    (void)sink;
+    return host_test_result("portal_parse_bench");
+}
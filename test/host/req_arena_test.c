@@ -0,0 +1,102 @@
+/*
+ * Arena de los requests HTTP sobre un pool propio: alineación de cada reserva, pedidos que no entran,
+ * reset al final del request y high-water mark entre requests.
+ */
+#include "req_arena.h"
+#include "host_test.h"
+
+#include <stdint.h>
+
+#define POOL_BYTES 256
+
+static uint32_t pool[POOL_BYTES / sizeof(uint32_t)];
+
+static size_t offset_of(const req_arena_t *a, const void *p) {
+    return (size_t)((const uint8_t *)p - a->base);
+}
+
+static void test_alignment(void) {
+    req_arena_t a;
+    req_arena_init(&a, pool, sizeof(pool));
+
+    static const size_t sizes[] = { 1, 3, 4, 5, 7, 2, 9, 1 };
+    const uint8_t *prev_end = a.base;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint8_t *p = req_arena_alloc(&a, sizes[i]);
+        CHECK(p != NULL);
+        if (!p) return;
+        CHECK_EQ(offset_of(&a, p) % REQ_ARENA_ALIGN, 0);
+        CHECK(p >= prev_end);                          // Sin solapar la reserva anterior
+        CHECK(p - prev_end < REQ_ARENA_ALIGN);         // Solo el relleno de alineación en medio
+        prev_end = p + sizes[i];
+    }
+    CHECK_EQ(a.used, (size_t)(prev_end - a.base));
+    CHECK(req_arena_alloc(&a, 0) == NULL);
+    CHECK_EQ(a.failures, 0); // Tamaño 0 no es un pedido fallido
+}
+
+static void test_exhaustion(void) {
+    req_arena_t a;
+    req_arena_init(&a, pool, sizeof(pool));
+
+    CHECK(req_arena_alloc(&a, sizeof(pool) + 1) == NULL);
+    CHECK_EQ(a.failures, 1);
+    CHECK_EQ(a.used, 0); // Un pedido fallido no consume
+
+    CHECK(req_arena_alloc(&a, sizeof(pool) - 3) != NULL);
+    // Quedan 3 bytes, pero la próxima reserva arranca alineada al final del pool
+    CHECK(req_arena_alloc(&a, 1) == NULL);
+    CHECK_EQ(a.failures, 2);
+    CHECK_EQ(a.used, sizeof(pool) - 3);
+
+    req_arena_init(&a, pool, sizeof(pool));
+    CHECK(req_arena_alloc(&a, sizeof(pool)) != NULL); // Justo la capacidad
+    CHECK(req_arena_alloc(&a, 1) == NULL);
+    CHECK(req_arena_alloc(&a, SIZE_MAX) == NULL);     // Sin desbordes en la cuenta
+
+    req_arena_t empty;
+    req_arena_init(&empty, NULL, sizeof(pool));
+    CHECK_EQ(empty.cap, 0);
+    CHECK(req_arena_alloc(&empty, 1) == NULL);
+    CHECK(req_arena_alloc(NULL, 1) == NULL);
+}
+
+static void test_reset_and_high_water(void) {
+    req_arena_t a;
+    req_arena_init(&a, pool, sizeof(pool));
+
+    // Request 1: 100 bytes
+    uint8_t *first = req_arena_alloc(&a, 100);
+    CHECK(first != NULL);
+    req_arena_reset(&a);
+    CHECK_EQ(a.used, 0);
+    CHECK_EQ(a.high_water, 100);
+
+    // Request 2: más chico; el pool se reusa desde el principio y el high-water no baja
+    uint8_t *again = req_arena_alloc(&a, 10);
+    CHECK(again == first);
+    req_arena_reset(&a);
+    CHECK_EQ(a.high_water, 100);
+
+    // Request 3: el más grande hasta ahora
+    CHECK(req_arena_alloc(&a, 48) != NULL);
+    CHECK(req_arena_alloc(&a, 152) != NULL);
+    CHECK_EQ(a.high_water, 100); // Se actualiza recién en el reset
+    req_arena_reset(&a);
+    CHECK_EQ(a.high_water, 200);
+
+    // Después de agotarse, el reset devuelve toda la capacidad
+    CHECK(req_arena_alloc(&a, sizeof(pool)) != NULL);
+    CHECK(req_arena_alloc(&a, 4) == NULL);
+    req_arena_reset(&a);
+    CHECK_EQ(a.high_water, sizeof(pool));
+    CHECK(req_arena_alloc(&a, sizeof(pool)) != NULL);
+    req_arena_reset(NULL);
+}
+
+int main(void) {
+    test_alignment();
+    test_exhaustion();
+    test_reset_and_high_water();
+    return host_test_result("req_arena_test");
+}
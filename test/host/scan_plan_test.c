@@ -0,0 +1,146 @@
+/*
+ * Plan de escaneo por bandas con listas de canales simuladas: orden de los grupos, dwell de los pasos
+ * pasivos y DFS, y el corte temprano. run_plan() recorre el plan como wifi_scanner_execute_scan()
+ * con la red conocida en un canal dado.
+ */
+#include "scan_plan.h"
+#include "host_test.h"
+
+#define PASSIVE_DWELL 110
+#define DFS_DWELL     230
+
+static const uint8_t ch_2g[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
+static const uint8_t ch_5g[] = { 36, 40, 44, 48, 149, 153, 157, 161, 165 };
+static const uint8_t ch_dfs[] = { 52, 56, 60, 64, 100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 144 };
+
+#define N(a) ((uint8_t)sizeof(a))
+
+static scan_plan_input_t dual_band(scan_band_t preferred, bool passive) {
+    scan_plan_input_t in = {
+        .ch_2g = ch_2g, .n_2g = N(ch_2g),
+        .ch_5g = ch_5g, .n_5g = N(ch_5g),
+        .ch_dfs = ch_dfs, .n_dfs = N(ch_dfs),
+        .preferred = preferred, .passive = passive,
+        .passive_dwell_ms = PASSIVE_DWELL, .dfs_dwell_ms = DFS_DWELL,
+    };
+    return in;
+}
+
+// Pasos ejecutados hasta el corte; known_channel 0 = sin red conocida
+static size_t run_plan(const scan_plan_t *plan, uint8_t known_channel) {
+    bool have_known = (known_channel != 0);
+    bool seen = false;
+    for (size_t s = 0; s < plan->n_steps; s++) {
+        if (plan->steps[s].channel == known_channel) seen = true;
+        if (scan_plan_should_stop(plan, s, have_known, seen)) return s + 1;
+    }
+    return plan->n_steps;
+}
+
+static void test_single_band(void) {
+    scan_plan_input_t in = { .ch_2g = ch_2g, .n_2g = N(ch_2g), .passive_dwell_ms = PASSIVE_DWELL };
+    scan_plan_t plan;
+    CHECK_EQ(scan_plan_build(&in, &plan), 1);
+    CHECK_EQ(plan.steps[0].channel, SCAN_PLAN_CHANNEL_ALL);
+    CHECK(plan.steps[0].checkpoint);
+    CHECK(!plan.steps[0].passive);
+    CHECK_EQ(plan.steps[0].dwell_ms, 0);
+    CHECK(!scan_plan_should_stop(&plan, 0, true, true)); // Nada que saltar
+
+    in.passive = true;
+    scan_plan_build(&in, &plan);
+    CHECK(plan.steps[0].passive);
+    CHECK_EQ(plan.steps[0].dwell_ms, PASSIVE_DWELL);
+
+    in.n_2g = 0;
+    CHECK_EQ(scan_plan_build(&in, &plan), 0);
+    CHECK_EQ(scan_plan_build(NULL, &plan), 0);
+}
+
+static void test_group_order(void) {
+    scan_plan_t plan;
+    scan_plan_input_t in = dual_band(SCAN_BAND_2G, false);
+    size_t n = scan_plan_build(&in, &plan);
+    CHECK_EQ(n, N(ch_2g) + N(ch_5g) + N(ch_dfs));
+    CHECK_EQ(plan.steps[0].channel, 1);
+    CHECK_EQ(plan.steps[N(ch_2g)].channel, 36);
+    CHECK_EQ(plan.steps[N(ch_2g) + N(ch_5g)].channel, 52);
+
+    // Checkpoints solo al final de cada grupo
+    int checkpoints = 0;
+    for (size_t s = 0; s < n; s++) checkpoints += plan.steps[s].checkpoint;
+    CHECK_EQ(checkpoints, 3);
+    CHECK(plan.steps[N(ch_2g) - 1].checkpoint);
+    CHECK(plan.steps[N(ch_2g) + N(ch_5g) - 1].checkpoint);
+    CHECK(plan.steps[n - 1].checkpoint);
+
+    // Activo fuera de DFS; DFS siempre pasivo y con su propio dwell
+    for (size_t s = 0; s < n; s++) {
+        const scan_plan_step_t *st = &plan.steps[s];
+        if (st->dfs) {
+            CHECK(st->passive);
+            CHECK_EQ(st->dwell_ms, DFS_DWELL);
+            CHECK_EQ(st->band, SCAN_BAND_5G);
+        } else {
+            CHECK(!st->passive);
+            CHECK_EQ(st->dwell_ms, 0);
+        }
+    }
+
+    in = dual_band(SCAN_BAND_5G, true);
+    scan_plan_build(&in, &plan);
+    CHECK_EQ(plan.steps[0].channel, 36);
+    CHECK_EQ(plan.steps[N(ch_5g)].channel, 1);
+    CHECK_EQ(plan.steps[N(ch_5g)].dwell_ms, PASSIVE_DWELL); // Escaneo pasivo pedido
+    CHECK_EQ(plan.steps[n - 1].dwell_ms, DFS_DWELL);
+
+    // Solo 5 GHz disponible (2.4 vacío): el plan sigue por canal
+    in = dual_band(SCAN_BAND_2G, false);
+    in.n_2g = 0;
+    CHECK_EQ(scan_plan_build(&in, &plan), N(ch_5g) + N(ch_dfs));
+    CHECK_EQ(plan.steps[0].channel, 36);
+}
+
+static void test_early_stop(void) {
+    scan_plan_t plan;
+    scan_plan_input_t in = dual_band(SCAN_BAND_5G, false);
+    size_t n = scan_plan_build(&in, &plan);
+
+    // Vista en la banda preferida: se corta en su checkpoint, no en el canal
+    CHECK_EQ(run_plan(&plan, 44), N(ch_5g));
+    CHECK_EQ(run_plan(&plan, 165), N(ch_5g));
+    // En la otra banda: se completa esa banda y se saltan los DFS
+    CHECK_EQ(run_plan(&plan, 6), N(ch_5g) + N(ch_2g));
+    // Solo en DFS, ausente o sin red conocida: el plan entero
+    CHECK_EQ(run_plan(&plan, 100), n);
+    CHECK_EQ(run_plan(&plan, 200), n);
+    CHECK_EQ(run_plan(&plan, 0), n);
+
+    // Nunca a mitad de grupo, nunca tras el último paso, nunca sin la red vista
+    CHECK(!scan_plan_should_stop(&plan, 0, true, true));
+    CHECK(!scan_plan_should_stop(&plan, n - 1, true, true));
+    CHECK(!scan_plan_should_stop(&plan, N(ch_5g) - 1, true, false));
+    CHECK(!scan_plan_should_stop(&plan, N(ch_5g) - 1, false, false));
+    CHECK(!scan_plan_should_stop(&plan, n, true, true));
+    CHECK(!scan_plan_should_stop(NULL, 0, true, true));
+}
+
+static void test_step_cap(void) {
+    uint8_t many[60];
+    for (size_t i = 0; i < sizeof(many); i++) many[i] = (uint8_t)(36 + i);
+    scan_plan_input_t in = dual_band(SCAN_BAND_2G, false);
+    in.ch_5g = many;
+    in.n_5g = sizeof(many);
+    scan_plan_t plan;
+    CHECK_EQ(scan_plan_build(&in, &plan), SCAN_PLAN_MAX_STEPS);
+    CHECK(plan.steps[SCAN_PLAN_MAX_STEPS - 1].checkpoint); // El grupo recortado igual cierra
+    CHECK(!plan.steps[SCAN_PLAN_MAX_STEPS - 1].dfs);       // DFS no entró
+}
+
+int main(void) {
+    test_single_band();
+    test_group_order();
+    test_early_stop();
+    test_step_cap();
+    return host_test_result("scan_plan_test");
+}
@@ -0,0 +1,687 @@
+/*
+ * Replay de escenarios del flujo de estados: system_state.c, conn_bus.c, boot_profile.c, scan_policy.c y
+ * task_topology.c reales contra un mundo simulado (driver Wi-Fi, APs visibles, portal, NVS y botón) en
+ * reloj virtual. La tarea de estados corre en este hilo; cuando se bloquea (cola de entradas o vTaskDelay)
+ * el mundo avanza el reloj y dispara los eventos que vencen. Reporta el time-to-IP de cada escenario.
+ * Cada escenario corre en un proceso hijo: los módulos de main/ guardan su estado en estáticos.
+ */
+#include "system_state.h"
+#include "wifi_manager.h"
+#include "wifi_provisioning.h"
+#include "wifi_scanner.h"
+#include "storage_nvs.h"
+#include "led_status.h"
+#include "roaming.h"
+#include "album_refresh.h"
+#include "telemetry.h"
+#include "conn_bus.h"
+#include "link_probe.h"
+#include "mem_report.h"
+#include "boot_profile.h"
+#include "button.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+
+#include "fake_idf.h"
+#include "host_test.h"
+
+#include <setjmp.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* =========================
+   Tiempos del mundo (ms)
+   ========================= */
+
+#define BOOTLOADER_MS      280  // Reset -> app_main
+#define NVS_INIT_MS        40
+#define WIFI_INIT_MS       110
+#define RADIO_START_MS     150  // esp_wifi_start() -> STA_START (calibración)
+#define APP_INIT_MS        60   // Resto de app_main hasta system_state_init()
+#define CONNECT_MS         900  // connect() -> STA_CONNECTED (fast scan + auth + assoc)
+#define HANDSHAKE_FAIL_MS  2500 // STA_CONNECTED -> DISCONNECTED(15) con clave equivocada
+#define NO_AP_MS           1600 // connect() -> DISCONNECTED(201) tras barrer todos los canales
+#define SCAN_ACTIVE_MS     1600
+#define SCAN_PASSIVE_MS    2600
+#define DHCP_MS_DEFAULT    600
+
+#define WORLD_MAX_APS      4
+#define WORLD_MAX_ACTIONS  32
+#define WORLD_IP           0x0a00a8c0 // 192.168.0.10 en orden de red
+
+/* =========================
+   Mundo simulado
+   ========================= */
+
+typedef enum {
+    // Del driver (llevan la generación del intento que los originó)
+    ACT_STA_START = 0,
+    ACT_STA_CONNECTED,
+    ACT_GOT_IP,
+    ACT_DISCONNECTED,
+    // Del guion del escenario
+    ACT_AP_UP,
+    ACT_AP_DOWN,
+    ACT_PORTAL_SUBMIT,
+    ACT_BUTTON,
+    ACT_PROBE,          // Aserciones a mitad del escenario
+} action_kind_t;
+
+typedef struct {
+    bool used;
+    int64_t at_us;
+    action_kind_t kind;
+    uint32_t gen;
+    uint8_t reason;
+    int ap;
+    const char *ssid;
+    const char *pass;
+    button_event_t button;
+    void (*probe)(void);
+} action_t;
+
+typedef struct {
+    char ssid[32];
+    char pass[64];
+    bool visible;
+    bool sae_only;            // WPA3: rechaza la PSK en hex, solo acepta la passphrase
+} world_ap_t;
+
+static struct {
+    world_ap_t aps[WORLD_MAX_APS];
+    int n_aps;
+    action_t actions[WORLD_MAX_ACTIONS];
+    uint32_t dhcp_ms;
+    uint32_t app_init_ms;
+
+    // Driver
+    bool radio_started;
+    bool connecting;
+    bool associated;
+    int assoc_ap;
+    uint32_t gen;             // Se incrementa con cada disconnect(): descarta eventos de intentos viejos
+    char ram_ssid[32];
+    char ram_pass[64];
+    uint32_t connects;
+
+    // NVS
+    bool nvs_has;
+    char nvs_ssid[32];
+    char nvs_pass[64];
+    uint32_t nvs_writes;
+    bool nvs_write_fails;
+    bool psk;                 // wifi_manager conecta con la PSK guardada
+    uint32_t psk_caches;
+
+    // Portal
+    bool portal_active;
+    uint32_t portal_starts;
+    bool portal_has_creds;
+    wifi_credentials_t portal_creds;
+    wifi_prov_test_result_t test_result;
+
+    button_cb_t button_cb;
+    void *button_arg;
+    TaskHandle_t state_task;
+
+    uint32_t scans;
+    int64_t end_us;
+    jmp_buf done;
+} world;
+
+static void schedule(uint32_t delay_ms, action_t act) {
+    for (int i = 0; i < WORLD_MAX_ACTIONS; i++) {
+        if (!world.actions[i].used) {
+            act.used = true;
+            act.at_us = esp_timer_get_time() + delay_ms * 1000LL;
+            world.actions[i] = act;
+            return;
+        }
+    }
+    fprintf(stderr, "mundo: sin lugar para más acciones\n");
+    abort();
+}
+
+static void driver_event(uint32_t delay_ms, action_kind_t kind, uint8_t reason) {
+    schedule(delay_ms, (action_t){ .kind = kind, .gen = world.gen, .reason = reason });
+}
+
+static int find_ap(const char *ssid) {
+    for (int i = 0; i < world.n_aps; i++) {
+        if (world.aps[i].visible && strcmp(world.aps[i].ssid, ssid) == 0) return i;
+    }
+    return -1;
+}
+
+static void link_lost(void) {
+    if (!world.associated) return;
+    world.gen++;
+    world.associated = false;
+    conn_bus_publish(CONN_EVT_STA_DISCONNECTED, WIFI_REASON_BEACON_TIMEOUT, 0);
+}
+
+static void run_action(action_t *slot) {
+    action_t a = *slot, *act = &a; // El lugar se libera antes: la acción puede agendar otras
+    slot->used = false;
+    if (act->kind <= ACT_DISCONNECTED && act->gen != world.gen) return; // Intento ya cortado
+
+    switch (act->kind) {
+        case ACT_STA_START:
+            world.radio_started = true;
+            esp_wifi_connect(); // Como el handler de wifi_manager: con credenciales precargadas es el fast boot
+            conn_bus_publish(CONN_EVT_STA_START, 0, 0);
+            break;
+        case ACT_STA_CONNECTED:
+            world.associated = true;
+            conn_bus_publish(CONN_EVT_STA_CONNECTED, 0, 0);
+            break;
+        case ACT_GOT_IP:
+            world.connecting = false;
+            conn_bus_publish(CONN_EVT_GOT_IP, 0, WORLD_IP);
+            break;
+        case ACT_DISCONNECTED:
+            world.connecting = false;
+            world.associated = false;
+            conn_bus_publish(CONN_EVT_STA_DISCONNECTED, act->reason, 0);
+            break;
+        case ACT_AP_UP:
+            world.aps[act->ap].visible = true;
+            break;
+        case ACT_AP_DOWN:
+            world.aps[act->ap].visible = false;
+            if (world.associated && world.assoc_ap == act->ap) link_lost();
+            break;
+        case ACT_PORTAL_SUBMIT:
+            strncpy(world.portal_creds.ssid, act->ssid, sizeof(world.portal_creds.ssid) - 1);
+            strncpy(world.portal_creds.password, act->pass, sizeof(world.portal_creds.password) - 1);
+            world.portal_has_creds = true;
+            break;
+        case ACT_BUTTON:
+            world.button_cb(act->button, world.button_arg); // Contexto del timer del botón
+            break;
+        case ACT_PROBE:
+            act->probe();
+            break;
+    }
+}
+
+/**
+ * Avanza el reloj hasta 'until_us' disparando las acciones vencidas en orden. Si 'queue' recibe algo,
+ * vuelve en ese instante (la tarea se despierta).
+ */
+static void world_advance(int64_t until_us, QueueHandle_t queue) {
+    while (1) {
+        action_t *next = NULL;
+        for (int i = 0; i < WORLD_MAX_ACTIONS; i++) {
+            action_t *a = &world.actions[i];
+            if (a->used && a->at_us <= until_us && (next == NULL || a->at_us < next->at_us)) next = a;
+        }
+        if (next == NULL) break;
+        if (next->at_us > esp_timer_get_time()) fake_clock_advance_us(next->at_us - esp_timer_get_time());
+        run_action(next);
+        if (queue && uxQueueMessagesWaiting(queue) > 0) return;
+    }
+    if (until_us > esp_timer_get_time()) fake_clock_advance_us(until_us - esp_timer_get_time());
+}
+
+static void world_idle(int64_t until_us, QueueHandle_t queue, void *arg) {
+    if (until_us > world.end_us) until_us = world.end_us;
+    world_advance(until_us, queue);
+    if (esp_timer_get_time() >= world.end_us) longjmp(world.done, 1); // Fin del escenario
+}
+
+/* =========================
+   Radio (esp_wifi)
+   ========================= */
+
+esp_err_t esp_wifi_start(void) {
+    if (!world.radio_started) driver_event(RADIO_START_MS, ACT_STA_START, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+    if (world.ram_ssid[0] == '\0') return ESP_FAIL;
+    world.connects++;
+    world.connecting = true;
+    int ap = find_ap(world.ram_ssid);
+    if (ap < 0) {
+        driver_event(NO_AP_MS, ACT_DISCONNECTED, WIFI_REASON_NO_AP_FOUND);
+    } else if (world.psk && world.aps[ap].sae_only) {
+        driver_event(CONNECT_MS, ACT_DISCONNECTED, WIFI_REASON_AUTH_FAIL);
+    } else if (strcmp(world.aps[ap].pass, world.ram_pass) != 0) {
+        driver_event(CONNECT_MS, ACT_STA_CONNECTED, 0);
+        driver_event(CONNECT_MS + HANDSHAKE_FAIL_MS, ACT_DISCONNECTED, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+    } else {
+        world.assoc_ap = ap;
+        driver_event(CONNECT_MS, ACT_STA_CONNECTED, 0);
+        driver_event(CONNECT_MS + world.dhcp_ms, ACT_GOT_IP, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+    world.gen++;
+    if (world.associated || world.connecting) driver_event(5, ACT_DISCONNECTED, WIFI_REASON_ASSOC_LEAVE);
+    world.associated = false;
+    world.connecting = false;
+    return ESP_OK;
+}
+
+/* =========================
+   Módulos falsos de main/
+   ========================= */
+
+void wifi_manager_start(void) {
+#ifdef CONFIG_WIFI_MGR_FAST_BOOT
+    // Fast boot: las credenciales de la NVS quedan precargadas para el connect() de STA_START
+    if (world.nvs_has) wifi_manager_set_credentials(world.nvs_ssid, world.nvs_pass);
+#endif
+    esp_wifi_start();
+}
+
+void wifi_manager_set_credentials(const char *ssid, const char *password) {
+    if (ssid) snprintf(world.ram_ssid, sizeof(world.ram_ssid), "%s", ssid);
+    if (password) snprintf(world.ram_pass, sizeof(world.ram_pass), "%s", password);
+}
+
+void wifi_manager_get_credentials(char *ssid_out, char *pass_out) {
+    if (ssid_out) memcpy(ssid_out, world.ram_ssid, sizeof(world.ram_ssid));
+    if (pass_out) memcpy(pass_out, world.ram_pass, sizeof(world.ram_pass));
+}
+
+void wifi_manager_reconnect(void) {
+    esp_wifi_disconnect();
+    esp_wifi_connect();
+}
+
+// Como el real: solo con la red ya asociada y si el AP no es WPA3
+bool wifi_manager_cache_psk(void) {
+    if (world.assoc_ap < 0 || world.aps[world.assoc_ap].sae_only) return world.psk;
+    world.psk_caches++;
+    world.psk = true;
+    return true;
+}
+
+bool wifi_manager_forget_psk(void) {
+    bool was_used = world.psk;
+    world.psk = false;
+    return was_used;
+}
+
+void wifi_manager_reset_last_disconnect_reason(void) {
+    conn_bus_clear_reason();
+}
+
+int wifi_scanner_execute_scan(bool passive, const char *known_ssid) {
+    world.scans++;
+    world_advance(esp_timer_get_time() + (passive ? SCAN_PASSIVE_MS : SCAN_ACTIVE_MS) * 1000LL, NULL);
+    int found = 0;
+    for (int i = 0; i < world.n_aps; i++) found += world.aps[i].visible;
+    return found;
+}
+
+bool wifi_scanner_is_network_available(const char *ssid) {
+    return find_ap(ssid) >= 0;
+}
+
+void wifi_provisioning_start(void) {
+    world.portal_active = true;
+    world.portal_starts++;
+}
+
+void wifi_provisioning_stop(void) {
+    world.portal_active = false;
+}
+
+bool wifi_provisioning_is_active(void) {
+    return world.portal_active;
+}
+
+bool wifi_provisioning_has_new_credentials(void) {
+    return world.portal_has_creds;
+}
+
+void wifi_provisioning_get_credentials(wifi_credentials_t *creds) {
+    *creds = world.portal_creds;
+    world.portal_has_creds = false;
+}
+
+void wifi_provisioning_set_test_result(wifi_prov_test_result_t result, uint8_t reason) {
+    world.test_result = result;
+}
+
+bool storage_load_wifi_credentials(char *ssid_out, char *password_out) {
+    if (!world.nvs_has) return false;
+    memcpy(ssid_out, world.nvs_ssid, sizeof(world.nvs_ssid));
+    memcpy(password_out, world.nvs_pass, sizeof(world.nvs_pass));
+    return true;
+}
+
+bool storage_save_wifi_credentials(const char *ssid, const char *password) {
+    if (world.nvs_write_fails) return false;
+    snprintf(world.nvs_ssid, sizeof(world.nvs_ssid), "%s", ssid);
+    snprintf(world.nvs_pass, sizeof(world.nvs_pass), "%s", password);
+    world.nvs_has = true;
+    world.nvs_writes++;
+    return true;
+}
+
+bool storage_clear_wifi_credentials(void) {
+    world.nvs_has = false;
+    return true;
+}
+
+void button_init(button_cb_t cb, void *arg) {
+    world.button_cb = cb;
+    world.button_arg = arg;
+}
+
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes) {
+    if (strcmp(module, "system_state") == 0) world.state_task = task;
+}
+
+void led_status_set(led_status_t status) {
+}
+
+void roaming_reset(void) {
+}
+
+bool roaming_tick(void) {
+    return false;
+}
+
+void album_refresh_reset(void) {
+}
+
+bool album_refresh_tick(void) {
+    return false;
+}
+
+void telemetry_reset(void) {
+}
+
+void telemetry_tick(void) {
+}
+
+bool link_probe_is_degraded(void) {
+    return false;
+}
+
+/* =========================
+   Guion y ejecución
+   ========================= */
+
+static int world_add_ap(const char *ssid, const char *pass, bool visible) {
+    world_ap_t *ap = &world.aps[world.n_aps];
+    snprintf(ap->ssid, sizeof(ap->ssid), "%s", ssid);
+    snprintf(ap->pass, sizeof(ap->pass), "%s", pass);
+    ap->visible = visible;
+    return world.n_aps++;
+}
+
+static void world_nvs(const char *ssid, const char *pass) {
+    snprintf(world.nvs_ssid, sizeof(world.nvs_ssid), "%s", ssid);
+    snprintf(world.nvs_pass, sizeof(world.nvs_pass), "%s", pass);
+    world.nvs_has = true;
+}
+
+static void at_ms(uint32_t ms, action_t act) {
+    act.used = true;
+    act.at_us = ms * 1000LL;
+    for (int i = 0; i < WORLD_MAX_ACTIONS; i++) {
+        if (!world.actions[i].used) {
+            world.actions[i] = act;
+            return;
+        }
+    }
+    abort();
+}
+
+/** Arranque como app_main (mismo orden de inits y de hitos) y la tarea de estados hasta 'duration_ms'. */
+static void run_for(uint32_t duration_ms) {
+    fake_clock_set_virtual(BOOTLOADER_MS * 1000LL);
+    boot_profile_mark(BOOT_PHASE_APP_MAIN);
+    fake_clock_advance_us(NVS_INIT_MS * 1000LL);
+    boot_profile_mark(BOOT_PHASE_NVS_READY);
+    conn_bus_init();
+    boot_profile_init();
+    fake_clock_advance_us(WIFI_INIT_MS * 1000LL);
+    boot_profile_mark(BOOT_PHASE_WIFI_INIT);
+    wifi_manager_start();
+    boot_profile_mark(BOOT_PHASE_RADIO_START);
+    world_advance(esp_timer_get_time() + world.app_init_ms * 1000LL, NULL);
+    system_state_init();
+
+    world.end_us = duration_ms * 1000LL;
+    fake_rtos_set_idle_hook(world_idle, NULL);
+    if (setjmp(world.done) == 0) world.state_task->fn(world.state_task->arg);
+    fake_rtos_set_idle_hook(NULL, NULL);
+}
+
+/* =========================
+   Escenarios
+   ========================= */
+
+// Red guardada a la vista: connect() en STA_START, sin escaneo, dentro del presupuesto de arranque
+static void scenario_fast_boot(void) {
+    world_add_ap("casa", "clave-casa", true);
+    world_nvs("casa", "clave-casa");
+    run_for(10000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    uint32_t ms[BOOT_PHASE_COUNT];
+    boot_profile_get(ms);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(st.scans, 0);
+    CHECK_EQ(st.entries[SYSTEM_STATE_SCANNING], 0);
+    CHECK_EQ(world.nvs_writes, 0);
+    CHECK_EQ(world.portal_starts, 0);
+    CHECK_EQ(ms[BOOT_PHASE_SCAN_DONE], BOOT_PHASE_NOT_REACHED);
+    CHECK(ms[BOOT_PHASE_GOT_IP] <= CONFIG_WIFI_MGR_BOOT_BUDGET_MS);
+    CHECK(st.time_to_ip_last_ms <= CONFIG_WIFI_MGR_BOOT_BUDGET_MS);
+    CHECK(!boot_profile_over_budget());
+}
+
+// Regresión del presupuesto: el mismo arranque con un DHCP lento tiene que quedar marcado como excedido
+static void scenario_fast_boot_slow_dhcp(void) {
+    world.dhcp_ms = 3200;
+    world_add_ap("casa", "clave-casa", true);
+    world_nvs("casa", "clave-casa");
+    run_for(10000);
+
+    uint32_t ms[BOOT_PHASE_COUNT];
+    boot_profile_get(ms);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK(ms[BOOT_PHASE_GOT_IP] > CONFIG_WIFI_MGR_BOOT_BUDGET_MS);
+    CHECK(boot_profile_over_budget());
+}
+
+// Init lento: la IP llega antes de que system_state se suscriba y solo queda en la foto de conn_bus
+static void scenario_fast_boot_ip_before_init(void) {
+    world.app_init_ms = 2500;
+    world_add_ap("casa", "clave-casa", true);
+    world_nvs("casa", "clave-casa");
+    run_for(10000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(st.scans, 0);
+    CHECK_EQ(st.entries[SYSTEM_STATE_SCANNING], 0);
+    CHECK_EQ(world.connects, 1);
+    CHECK(st.time_to_ip_last_ms <= CONFIG_WIFI_MGR_BOOT_BUDGET_MS + 2500); // Sin esperar el timeout de TRY_STA
+}
+
+// Primer arranque: NVS vacía -> álbum -> portal; el usuario envía la red a los 20 s
+static void scenario_first_boot_portal(void) {
+    world_add_ap("casa", "clave-casa", true);
+    world_add_ap("vecino", "otra", true);
+    at_ms(20000, (action_t){ .kind = ACT_PORTAL_SUBMIT, .ssid = "casa", .pass = "clave-casa" });
+    run_for(40000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(st.scans, 1);
+    CHECK_EQ(world.portal_starts, 1);
+    CHECK(!world.portal_active); // Cerrado tras el período de gracia
+    CHECK_EQ(world.test_result, WIFI_PROV_TEST_SUCCESS);
+    CHECK_EQ(world.nvs_writes, 1);
+    CHECK(strcmp(world.nvs_ssid, "casa") == 0);
+    CHECK(st.time_to_ip_last_ms > 20000);
+}
+
+// Portal pedido con el botón estando conectado; clave equivocada -> rollback; después la correcta
+static void probe_after_rollback(void) {
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_PROVISIONING);
+    CHECK_EQ(world.test_result, WIFI_PROV_TEST_FAILED);
+    CHECK(strcmp(world.ram_ssid, "casa") == 0); // Vuelven las credenciales guardadas
+    CHECK_EQ(world.nvs_writes, 0);
+    CHECK(world.portal_active);
+}
+
+static void scenario_portal_wrong_password(void) {
+    world_add_ap("casa", "clave-casa", true);
+    world_add_ap("oficina", "clave-oficina", true);
+    world_nvs("casa", "clave-casa");
+    at_ms(8000, (action_t){ .kind = ACT_BUTTON, .button = BUTTON_EVT_SHORT });
+    at_ms(15000, (action_t){ .kind = ACT_PORTAL_SUBMIT, .ssid = "oficina", .pass = "equivocada" });
+    at_ms(24000, (action_t){ .kind = ACT_PROBE, .probe = probe_after_rollback });
+    at_ms(30000, (action_t){ .kind = ACT_PORTAL_SUBMIT, .ssid = "oficina", .pass = "clave-oficina" });
+    run_for(45000);
+
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(world.test_result, WIFI_PROV_TEST_SUCCESS);
+    CHECK_EQ(world.nvs_writes, 1);
+    CHECK(strcmp(world.nvs_ssid, "oficina") == 0);
+}
+
+// Entorno vacío al arrancar: fast boot sin AP -> escaneo vacío -> backoff; la red aparece a los 20 s
+static void scenario_empty_then_backoff(void) {
+    int ap = world_add_ap("casa", "clave-casa", false);
+    world_nvs("casa", "clave-casa");
+    at_ms(20000, (action_t){ .kind = ACT_AP_UP, .ap = ap });
+    run_for(60000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(st.scans, 2); // Uno vacío y el siguiente tras CONFIG_WIFI_MGR_SCAN_BACKOFF_MIN_S
+    CHECK_EQ(world.portal_starts, 0);
+    CHECK(st.time_to_ip_last_ms > CONFIG_WIFI_MGR_SCAN_BACKOFF_MIN_S * 1000);
+}
+
+// Caída del AP con IP: reintentos y reconexión cuando vuelve. El time-to-IP mide el episodio
+static void scenario_link_loss(void) {
+    int ap = world_add_ap("casa", "clave-casa", true);
+    world_nvs("casa", "clave-casa");
+    at_ms(10000, (action_t){ .kind = ACT_AP_DOWN, .ap = ap });
+    at_ms(18000, (action_t){ .kind = ACT_AP_UP, .ap = ap });
+    run_for(90000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK_EQ(st.entries[SYSTEM_STATE_CONNECTED], 2);
+    CHECK(st.entries[SYSTEM_STATE_DISCONNECTED] >= 1);
+    CHECK(st.time_to_ip_last_ms > 8000); // Al menos lo que estuvo caído el AP
+    CHECK_EQ(world.nvs_writes, 0);
+}
+
+// Credenciales del portal que no llegan a la NVS: se conecta igual, pero sin fijar la PSK
+static void scenario_portal_nvs_write_fails(void) {
+    world_add_ap("casa", "clave-casa", true);
+    world.nvs_write_fails = true;
+    at_ms(20000, (action_t){ .kind = ACT_PORTAL_SUBMIT, .ssid = "casa", .pass = "clave-casa" });
+    run_for(40000);
+
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK(!world.nvs_has);
+    CHECK_EQ(world.psk_caches, 0);
+    CHECK(!world.psk);
+}
+
+// El AP guardado pasó a WPA3: la PSK se rechaza, se descarta y la passphrase conecta sin abrir el portal
+static void scenario_psk_rejected_sae(void) {
+    int ap = world_add_ap("casa", "clave-casa", true);
+    world.aps[ap].sae_only = true;
+    world_nvs("casa", "clave-casa");
+    world.psk = true;
+    run_for(15000);
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_CONNECTED);
+    CHECK(!world.psk);
+    CHECK_EQ(world.psk_caches, 0);
+    CHECK_EQ(world.portal_starts, 0);
+    CHECK(st.time_to_ip_last_ms <= CONFIG_WIFI_MGR_BOOT_BUDGET_MS); // Reintento inmediato, sin esperar el timeout
+}
+
+// Pulsación larga con IP: olvida la red y abre el portal
+static void scenario_long_press_forget(void) {
+    world_add_ap("casa", "clave-casa", true);
+    world_nvs("casa", "clave-casa");
+    at_ms(8000, (action_t){ .kind = ACT_BUTTON, .button = BUTTON_EVT_LONG });
+    run_for(20000);
+
+    CHECK_EQ(system_state_get(), SYSTEM_STATE_PROVISIONING);
+    CHECK(!world.nvs_has);
+    CHECK(world.ram_ssid[0] == '\0');
+    CHECK(world.portal_active);
+    CHECK(!world.associated);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "fast_boot",            scenario_fast_boot },
+    { "fast_boot_slow_dhcp",  scenario_fast_boot_slow_dhcp },
+    { "fast_boot_ip_before_init", scenario_fast_boot_ip_before_init },
+    { "first_boot_portal",    scenario_first_boot_portal },
+    { "portal_wrong_password", scenario_portal_wrong_password },
+    { "empty_then_backoff",   scenario_empty_then_backoff },
+    { "link_loss",            scenario_link_loss },
+    { "long_press_forget",    scenario_long_press_forget },
+    { "portal_nvs_write_fails", scenario_portal_nvs_write_fails },
+    { "psk_rejected_sae",     scenario_psk_rejected_sae },
+};
+
+static int run_scenario(const scenario_t *sc) {
+    memset(&world, 0, sizeof(world));
+    world.dhcp_ms = DHCP_MS_DEFAULT;
+    world.app_init_ms = APP_INIT_MS;
+    world.assoc_ap = -1;
+    sc->run();
+
+    system_state_stats_t st;
+    system_state_get_stats(&st);
+    printf("  %-22s time-to-IP %6lu ms (máx %6lu ms), escaneos %lu, en provisión %6llu ms, transiciones %lu\n",
+           sc->name, (unsigned long)st.time_to_ip_last_ms, (unsigned long)st.time_to_ip_max_ms,
+           (unsigned long)st.scans, (unsigned long long)st.time_in_state_ms[SYSTEM_STATE_PROVISIONING],
+           (unsigned long)st.transitions);
+    fflush(stdout);
+    return host_test_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], scenarios[i].name) != 0) continue;
+        pid_t pid = fork();
+        if (pid == 0) exit(run_scenario(&scenarios[i]));
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "escenario %s: falla\n", scenarios[i].name);
+            failed++;
+        }
+    }
+    host_test_failures = failed;
+    return host_test_result("state_replay");
+}
@@ -0,0 +1,252 @@
+/*
+ * Exportador de telemetría contra un colector UDP de prueba en loopback: formato de las líneas StatsD,
+ * corte de los datagramas en CONFIG_WIFI_MGR_TELEMETRY_PAYLOAD, la muestra única de time-to-IP y el
+ * conteo de envíos rechazados. Se incluye telemetry.c para llegar al socket del módulo.
+ */
+#include "telemetry.c"
+
+#include "fake_idf.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int fake_telemetry_port = 0;
+
+#define PREFIX "wifimgr.a1b2c3."
+
+/* =========================
+   Dependencias del módulo
+   ========================= */
+
+static system_state_stats_t state_stats = { .time_to_ip_last_ms = 1234 };
+
+system_state_t system_state_get(void) {
+    return SYSTEM_STATE_CONNECTED;
+}
+
+void system_state_get_stats(system_state_stats_t *out) {
+    *out = state_stats;
+}
+
+void wifi_scanner_get_radio_stats(wifi_scanner_radio_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->scans[WIFI_SCANNER_KIND_FULL_ACTIVE] = 3;
+    out->radio_ms[WIFI_SCANNER_KIND_FULL_ACTIVE] = 4800;
+}
+
+uint32_t wifi_scanner_get_album_age_ms(void) {
+    return 42000;
+}
+
+void album_refresh_get_stats(album_refresh_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+    static const uint8_t sta_mac[6] = { 0x24, 0x6f, 0x28, 0xa1, 0xb2, 0xc3 };
+    memcpy(mac, sta_mac, 6);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info) {
+    memset(ap_info, 0, sizeof(*ap_info));
+    ap_info->rssi = -55;
+    ap_info->primary = 6;
+    return ESP_OK;
+}
+
+void wifi_manager_get_psk_stats(wifi_manager_psk_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+void link_probe_get_stats(link_probe_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return 123456;
+}
+
+void mem_report_register(const char *module, TaskHandle_t task, uint32_t stack_bytes, size_t static_bytes) {
+}
+
+/* =========================
+   Colector de prueba
+   ========================= */
+
+#define MAX_DATAGRAMS 16
+
+static int collector_sock = -1;
+static char rx[MAX_DATAGRAMS][TELEMETRY_PAYLOAD + 1];
+static size_t rx_len[MAX_DATAGRAMS];
+static int rx_count;
+
+static int open_collector(void) {
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(a);
+    if (s < 0 || bind(s, (struct sockaddr *)&a, sizeof(a)) < 0 ||
+        getsockname(s, (struct sockaddr *)&a, &alen) < 0) {
+        if (s >= 0) close(s);
+        return -1;
+    }
+    fake_telemetry_port = ntohs(a.sin_port);
+    return s;
+}
+
+// Una ronda de envío (telemetry_reset la adelanta al tick actual) y lo que llegó al colector.
+// En loopback el datagrama ya está en la cola del receptor cuando sendto() vuelve.
+static void push_round(void) {
+    telemetry_reset();
+    telemetry_tick();
+    rx_count = 0;
+    while (rx_count < MAX_DATAGRAMS) {
+        ssize_t n = recv(collector_sock, rx[rx_count], sizeof(rx[0]), MSG_DONTWAIT);
+        if (n < 0) break;
+        rx_len[rx_count] = (size_t)n;
+        rx[rx_count][n] = '\0';
+        rx_count++;
+    }
+}
+
+// Valor de la línea '<PREFIX><name>:<valor>|<tipo>' en la ronda recibida
+static bool find_line(const char *name, const char *type, long long *value) {
+    char head[64];
+    snprintf(head, sizeof(head), "\n" PREFIX "%s:", name);
+    for (int d = 0; d < rx_count; d++) {
+        char buf[TELEMETRY_PAYLOAD + 2] = "\n";
+        strcat(buf, rx[d]);
+        const char *p = strstr(buf, head);
+        if (!p) continue;
+        char *end;
+        long long v = strtoll(p + strlen(head), &end, 10);
+        char tail[8];
+        snprintf(tail, sizeof(tail), "|%s\n", type);
+        if (strncmp(end, tail, strlen(tail)) != 0) return false;
+        if (value) *value = v;
+        return true;
+    }
+    return false;
+}
+
+static size_t first_line_len(const char *dgram) {
+    const char *nl = strchr(dgram, '\n');
+    return nl ? (size_t)(nl - dgram) + 1 : strlen(dgram);
+}
+
+/* =========================
+   Casos
+   ========================= */
+
+// Cada línea: prefijo con la MAC, nombre, entero, '|g' o '|ms', y '\n'
+static void test_line_format(void) {
+    push_round();
+    CHECK(rx_count > 0);
+    int lines = 0;
+    for (int d = 0; d < rx_count; d++) {
+        CHECK(rx_len[d] > 0 && rx[d][rx_len[d] - 1] == '\n'); // Ninguna línea queda partida entre datagramas
+        for (char *line = rx[d]; *line; lines++) {
+            char *nl = strchr(line, '\n');
+            CHECK(nl != NULL);
+            if (!nl) break;
+            *nl = '\0';
+            char *colon = strchr(line, ':');
+            char *bar = colon ? strchr(colon, '|') : NULL;
+            CHECK(strncmp(line, PREFIX, strlen(PREFIX)) == 0);
+            CHECK(colon != NULL && bar != NULL);
+            if (colon && bar) {
+                char *end;
+                strtoll(colon + 1, &end, 10);
+                CHECK(end == bar && end != colon + 1);
+                CHECK(strcmp(bar, "|g") == 0 || strcmp(bar, "|ms") == 0);
+            }
+            *nl = '\n';
+            line = nl + 1;
+        }
+    }
+    CHECK(lines > 10);
+
+    long long v = 0;
+    CHECK(find_line("wifi.rssi", "g", &v));
+    CHECK_EQ(v, -55);
+    CHECK(find_line("scan.full_active.radio_ms", "g", &v));
+    CHECK_EQ(v, 4800);
+    CHECK(find_line("heap.free", "g", &v));
+    CHECK_EQ(v, 123456);
+
+    telemetry_stats_t st;
+    telemetry_get_stats(&st);
+    size_t bytes = 0;
+    for (int d = 0; d < rx_count; d++) bytes += rx_len[d];
+    CHECK_EQ(st.datagrams, (uint32_t)rx_count);
+    CHECK_EQ(st.bytes, bytes);
+    CHECK_EQ(st.dropped, 0);
+    printf("  ronda: %d líneas en %d datagramas, %zu bytes\n", lines, rx_count, bytes);
+}
+
+// Lo que no entra en TELEMETRY_PAYLOAD va al datagrama siguiente; cada uno se llena antes de cortar
+static void test_payload_split(void) {
+    push_round();
+    CHECK(rx_count >= 2);
+    for (int d = 0; d < rx_count; d++) {
+        CHECK(rx_len[d] <= TELEMETRY_PAYLOAD);
+        if (d + 1 < rx_count) CHECK(rx_len[d] + first_line_len(rx[d + 1]) > TELEMETRY_PAYLOAD);
+    }
+}
+
+// El time-to-IP sale una vez por conexión, como timing
+static void test_time_to_ip_once(void) {
+    state_stats.entries[SYSTEM_STATE_CONNECTED] = 1;
+    state_stats.time_to_ip_last_ms = 2100;
+    push_round();
+    long long v = 0;
+    CHECK(find_line("state.time_to_ip", "ms", &v));
+    CHECK_EQ(v, 2100);
+
+    push_round(); // Misma conexión
+    CHECK(!find_line("state.time_to_ip", "ms", NULL));
+    CHECK(find_line("state.transitions", "g", NULL));
+
+    state_stats.entries[SYSTEM_STATE_CONNECTED] = 2; // Reconexión
+    state_stats.time_to_ip_last_ms = 900;
+    push_round();
+    CHECK(find_line("state.time_to_ip", "ms", &v));
+    CHECK_EQ(v, 900);
+}
+
+// El stack rechaza el envío (descriptor cerrado): se cuenta en 'dropped' y no se reintenta
+static void test_send_failure_counts_drop(void) {
+    telemetry_stats_t before, after;
+    telemetry_get_stats(&before);
+
+    close(sock);
+    push_round();
+    telemetry_get_stats(&after);
+    CHECK_EQ(rx_count, 0);
+    CHECK(after.dropped >= before.dropped + 2); // Todos los datagramas de la ronda
+    CHECK_EQ(after.datagrams, before.datagrams);
+    CHECK_EQ(after.pushes, before.pushes + 1);
+
+    sock = -1; // El módulo abre otro socket en la próxima ronda
+    push_round();
+    long long v = 0;
+    CHECK(rx_count > 0);
+    CHECK(find_line("telemetry.dropped", "g", &v));
+    CHECK_EQ(v, after.dropped);
+}
+
+int main(void) {
+    collector_sock = open_collector();
+    if (collector_sock < 0) {
+        fprintf(stderr, "telemetry_test: sin socket UDP en loopback\n");
+        return 1;
+    }
+    telemetry_init();
+    test_line_format();
+    test_payload_split();
+    test_time_to_ip_once();
+    test_send_failure_counts_drop();
+    close(collector_sock);
+    return host_test_result("telemetry_test");
+}